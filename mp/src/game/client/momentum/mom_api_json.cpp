@@ -0,0 +1,256 @@
+#include "cbase.h"
+
+#include "mom_api_json.h"
+#include "fmtstr.h"
+
+#include "tier0/valve_minmax_off.h"
+// This is wrapped by minmax_off due to Valve making a macro for min and max...
+#include "rapidjson/reader.h"
+#include "rapidjson/error/en.h"
+// Now we can unwrap
+#include "tier0/valve_minmax_on.h"
+
+#include "tier0/memdbgon.h"
+
+using namespace rapidjson;
+
+// Nothing the API sends nests deeper than this
+#define JSON_MAX_DEPTH 32
+
+int64 JsonValue_t::GetInt64() const
+{
+    switch (m_eType)
+    {
+    case JSON_BOOL:
+        return m_bValue;
+    case JSON_INT:
+        return m_iValue;
+    case JSON_UINT:
+        return static_cast<int64>(m_uValue);
+    case JSON_DOUBLE:
+        return static_cast<int64>(m_dValue);
+    case JSON_STRING:
+        return Q_atoi64(m_pString);
+    default:
+        return 0;
+    }
+}
+
+uint64 JsonValue_t::GetUint64() const
+{
+    switch (m_eType)
+    {
+    case JSON_UINT:
+        return m_uValue;
+    case JSON_STRING:
+        return Q_atoui64(m_pString);
+    default:
+        return static_cast<uint64>(GetInt64());
+    }
+}
+
+float JsonValue_t::GetFloat() const
+{
+    switch (m_eType)
+    {
+    case JSON_DOUBLE:
+        return static_cast<float>(m_dValue);
+    case JSON_UINT:
+        return static_cast<float>(m_uValue);
+    case JSON_STRING:
+        return Q_atof(m_pString);
+    default:
+        return static_cast<float>(GetInt64());
+    }
+}
+
+// Walks the SAX events down the models: every object either has the model it fills or is skipped whole,
+// arrays hand their objects to the model owning the array.
+class CJsonModelHandler : public BaseReaderHandler<UTF8<>, CJsonModelHandler>
+{
+  public:
+    CJsonModelHandler(APIModel *pRoot) : m_pRoot(pRoot), m_iDepth(0)
+    {
+        m_szKey[0] = '\0';
+    }
+
+    bool Null()
+    {
+        JsonValue_t value;
+        value.m_eType = JsonValue_t::JSON_NULL;
+        value.m_iValue = 0;
+        return Value(value);
+    }
+
+    bool Bool(bool b)
+    {
+        JsonValue_t value;
+        value.m_eType = JsonValue_t::JSON_BOOL;
+        value.m_bValue = b;
+        return Value(value);
+    }
+
+    bool Int(int i) { return Int64(i); }
+    bool Uint(unsigned u) { return Int64(u); }
+
+    bool Int64(int64_t i)
+    {
+        JsonValue_t value;
+        value.m_eType = JsonValue_t::JSON_INT;
+        value.m_iValue = i;
+        return Value(value);
+    }
+
+    bool Uint64(uint64_t u)
+    {
+        JsonValue_t value;
+        value.m_eType = JsonValue_t::JSON_UINT;
+        value.m_uValue = u;
+        return Value(value);
+    }
+
+    bool Double(double d)
+    {
+        JsonValue_t value;
+        value.m_eType = JsonValue_t::JSON_DOUBLE;
+        value.m_dValue = d;
+        return Value(value);
+    }
+
+    bool String(const char *pStr, SizeType length, bool copy)
+    {
+        JsonValue_t value;
+        value.m_eType = JsonValue_t::JSON_STRING;
+        value.m_iValue = 0;
+        value.m_pString = pStr;
+        return Value(value);
+    }
+
+    bool Key(const char *pStr, SizeType length, bool copy)
+    {
+        Q_strncpy(m_szKey, pStr, sizeof(m_szKey));
+        return true;
+    }
+
+    bool StartObject()
+    {
+        APIModel *pModel = nullptr;
+        if (!m_iDepth)
+        {
+            pModel = m_pRoot;
+        }
+        else
+        {
+            Frame_t &parent = m_Frames[m_iDepth - 1];
+            if (parent.m_pModel)
+                pModel = parent.m_bArray ? parent.m_pModel->FromJsonArrayObject(parent.m_szArrayKey) : parent.m_pModel->FromJsonObject(m_szKey);
+        }
+
+        if (pModel)
+            pModel->FromJsonStart();
+
+        return Push(pModel, false);
+    }
+
+    bool EndObject(SizeType memberCount)
+    {
+        APIModel *pModel = m_Frames[m_iDepth - 1].m_pModel;
+        if (pModel)
+            pModel->FromJsonEnd();
+
+        m_iDepth--;
+        return true;
+    }
+
+    bool StartArray()
+    {
+        // Arrays of arrays aren't handed to anything
+        APIModel *pOwner = m_iDepth && !m_Frames[m_iDepth - 1].m_bArray ? m_Frames[m_iDepth - 1].m_pModel : nullptr;
+        if (!Push(pOwner, true))
+            return false;
+
+        Q_strncpy(m_Frames[m_iDepth - 1].m_szArrayKey, m_szKey, sizeof(m_Frames[m_iDepth - 1].m_szArrayKey));
+        return true;
+    }
+
+    bool EndArray(SizeType elementCount)
+    {
+        m_iDepth--;
+        return true;
+    }
+
+  private:
+    struct Frame_t
+    {
+        APIModel *m_pModel; // The model the object fills, or the one owning the array. Null when skipped.
+        bool m_bArray;
+        char m_szArrayKey[64];
+    };
+
+    bool Push(APIModel *pModel, bool bArray)
+    {
+        if (m_iDepth >= JSON_MAX_DEPTH)
+            return false;
+
+        Frame_t &frame = m_Frames[m_iDepth++];
+        frame.m_pModel = pModel;
+        frame.m_bArray = bArray;
+        return true;
+    }
+
+    bool Value(const JsonValue_t &value)
+    {
+        // Values of arrays have no key to go by
+        const Frame_t &frame = m_Frames[m_iDepth - 1];
+        if (frame.m_pModel && !frame.m_bArray)
+            frame.m_pModel->FromJsonValue(m_szKey, value);
+
+        return true;
+    }
+
+    APIModel *m_pRoot;
+    Frame_t m_Frames[JSON_MAX_DEPTH];
+    int m_iDepth;
+    char m_szKey[64];
+};
+
+static const char *const s_pResponseModelNames[] = {"keyvalues", "maps", "library", "favorites", "ranks"};
+COMPILE_TIME_ASSERT(ARRAYSIZE(s_pResponseModelNames) == API_RESPONSE_COUNT);
+
+APIModel *CJsonModelReader::CreateResponseModel(APIResponseModel_t type)
+{
+    switch (type)
+    {
+    case API_RESPONSE_MAPS:
+        return new MapListResponse(MODEL_FROM_SEARCH_API_CALL, "maps", false);
+    case API_RESPONSE_LIBRARY:
+        return new MapListResponse(MODEL_FROM_LIBRARY_API_CALL, "entries", true);
+    case API_RESPONSE_FAVORITES:
+        return new MapListResponse(MODEL_FROM_FAVORITES_API_CALL, "favorites", true);
+    case API_RESPONSE_RANKS:
+        return new RankListResponse;
+    default:
+        return nullptr;
+    }
+}
+
+const char *CJsonModelReader::GetResponseModelName(APIResponseModel_t type)
+{
+    return s_pResponseModelNames[type];
+}
+
+bool CJsonModelReader::ReadJson(char *pInput, APIModel *pRoot, char *pErrorOut, int iErrorLen)
+{
+    CJsonModelHandler handler(pRoot);
+    Reader reader;
+    InsituStringStream stream(pInput);
+    const ParseResult result = reader.Parse<kParseInsituFlag>(stream, handler);
+    if (result.IsError())
+    {
+        Q_snprintf(pErrorOut, iErrorLen, "Error parsing JSON object! Code: %d (%s) at %u", result.Code(),
+                   GetParseError_En(result.Code()), static_cast<unsigned>(result.Offset()));
+        return false;
+    }
+
+    return true;
+}
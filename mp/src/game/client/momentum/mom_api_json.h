@@ -0,0 +1,60 @@
+#pragma once
+
+#include "mom_api_models.h"
+
+// A scalar value of a JSON stream, handed to the model being filled
+struct JsonValue_t
+{
+    enum Type_t
+    {
+        JSON_NULL = 0,
+        JSON_BOOL,
+        JSON_INT,
+        JSON_UINT,
+        JSON_DOUBLE,
+        JSON_STRING,
+    };
+
+    Type_t m_eType;
+    union
+    {
+        bool m_bValue;
+        int64 m_iValue;
+        uint64 m_uValue;
+        double m_dValue;
+    };
+    const char *m_pString; // Null-terminated, only valid while the value is handled
+
+    // Same conversions as KeyValues, missing/mismatched values are 0 or ""
+    int GetInt() const { return static_cast<int>(GetInt64()); }
+    int64 GetInt64() const;
+    uint64 GetUint64() const;
+    float GetFloat() const;
+    bool GetBool() const { return GetInt64() != 0; }
+    const char *GetString() const { return m_eType == JSON_STRING ? m_pString : ""; }
+};
+
+// Which model the data of an API response gets decoded into, instead of KeyValues
+enum APIResponseModel_t
+{
+    API_RESPONSE_KEYVALUES = 0,
+    API_RESPONSE_MAPS,      // MapListResponse of "maps"
+    API_RESPONSE_LIBRARY,   // MapListResponse of "entries"
+    API_RESPONSE_FAVORITES, // MapListResponse of "favorites"
+    API_RESPONSE_RANKS,     // RankListResponse
+
+    API_RESPONSE_COUNT
+};
+
+class CJsonModelReader
+{
+  public:
+    // Creates the model the response data gets decoded into, null for API_RESPONSE_KEYVALUES
+    static APIModel *CreateResponseModel(APIResponseModel_t type);
+    // The short name of the response type, used for the recorded response fixtures
+    static const char *GetResponseModelName(APIResponseModel_t type);
+
+    // Fills the model straight from the JSON with a SAX reader, without building a document or KeyValues.
+    // Parses in place, so the input gets modified! The root object of the JSON goes into pRoot.
+    static bool ReadJson(char *pInput, APIModel *pRoot, char *pErrorOut, int iErrorLen);
+};
@@ -0,0 +1,182 @@
+#include "cbase.h"
+
+#include "filesystem.h"
+#include "mom_api_json.h"
+#include "util/jsontokv.h"
+
+#include "tier0/memdbgon.h"
+
+// Recorded with mom_api_record_fixtures, named <model name>_<n>.json
+#define API_FIXTURES_PATH "api_fixtures"
+
+static APIResponseModel_t GetFixtureModel(const char *pFileName)
+{
+    for (int i = API_RESPONSE_KEYVALUES + 1; i < API_RESPONSE_COUNT; i++)
+    {
+        const APIResponseModel_t type = static_cast<APIResponseModel_t>(i);
+        const char *pName = CJsonModelReader::GetResponseModelName(type);
+        const int len = Q_strlen(pName);
+        if (!Q_strnicmp(pFileName, pName, len) && pFileName[len] == '_')
+            return type;
+    }
+
+    return API_RESPONSE_KEYVALUES;
+}
+
+static int GetModelElementCount(APIResponseModel_t type, const APIModel *pModel)
+{
+    if (type == API_RESPONSE_RANKS)
+        return static_cast<const RankListResponse *>(pModel)->m_vecRanks.Count();
+
+    return static_cast<const MapListResponse *>(pModel)->m_vecMaps.Count();
+}
+
+// Compares the decoded fields, which both models write out through ToKV, printing the first key that differs
+static bool CompareModelFields(KeyValues *pKv, KeyValues *pSax, const char *pPath)
+{
+    if (Q_strcmp(pKv->GetName(), pSax->GetName()) || pKv->GetDataType() != pSax->GetDataType() ||
+        (!pKv->GetFirstSubKey() && Q_strcmp(pKv->GetString(), pSax->GetString())))
+    {
+        Warning("    %s/%s: \"%s\" through KeyValues, %s/%s: \"%s\" through SAX\n", pPath, pKv->GetName(),
+                pKv->GetString(), pPath, pSax->GetName(), pSax->GetString());
+        return false;
+    }
+
+    char path[512];
+    Q_snprintf(path, sizeof(path), "%s/%s", pPath, pKv->GetName());
+
+    KeyValues *pKvSub = pKv->GetFirstSubKey(), *pSaxSub = pSax->GetFirstSubKey();
+    for (; pKvSub && pSaxSub; pKvSub = pKvSub->GetNextKey(), pSaxSub = pSaxSub->GetNextKey())
+    {
+        if (!CompareModelFields(pKvSub, pSaxSub, path))
+            return false;
+    }
+
+    if (pKvSub || pSaxSub)
+    {
+        Warning("    %s: \"%s\" only decodes through %s\n", path, (pKvSub ? pKvSub : pSaxSub)->GetName(),
+                pKvSub ? "KeyValues" : "SAX");
+        return false;
+    }
+
+    return true;
+}
+
+CON_COMMAND(mom_api_json_benchmark, "Decodes the recorded API responses (" API_FIXTURES_PATH ") into their models through "
+                                    "KeyValues and through the SAX reader, and compares the time per response.\n"
+                                    "Usage: mom_api_json_benchmark [iterations]")
+{
+    const int iterations = args.ArgC() > 1 ? clamp(Q_atoi(args[1]), 1, 10000) : 100;
+
+    double kvTotal = 0.0, saxTotal = 0.0;
+    int responses = 0;
+
+    FileFindHandle_t found;
+    const char *pFoundFile = g_pFullFileSystem->FindFirstEx(API_FIXTURES_PATH "/*.json", "MOD", &found);
+    while (pFoundFile)
+    {
+        const APIResponseModel_t type = GetFixtureModel(pFoundFile);
+        char path[MAX_PATH];
+        V_ComposeFileName(API_FIXTURES_PATH, pFoundFile, path, MAX_PATH);
+
+        CUtlBuffer buf;
+        if (type == API_RESPONSE_KEYVALUES)
+        {
+            Warning("Skipping %s, its name doesn't start with a response model.\n", path);
+        }
+        else if (!g_pFullFileSystem->ReadFile(path, "MOD", buf))
+        {
+            Warning("Failed to read %s!\n", path);
+        }
+        else
+        {
+            buf.PutChar('\0');
+            const int size = buf.TellPut();
+            CUtlMemory<char> input(0, size);
+
+            double kvTime = 0.0, saxTime = 0.0;
+            int kvElements = 0, saxElements = 0;
+            bool bFailed = false, bFieldsMatch = true;
+            for (int i = 0; i < iterations && !bFailed; i++)
+            {
+                double start = Plat_FloatTime();
+                {
+                    KeyValuesAD pKv("data");
+                    bFailed |= !CJsonToKeyValues::ConvertJsonToKeyValues(static_cast<char *>(buf.Base()), pKv);
+                    APIModel *pModel = CJsonModelReader::CreateResponseModel(type);
+                    pModel->FromKV(pKv);
+                    kvElements = GetModelElementCount(type, pModel);
+                    delete pModel;
+                }
+                kvTime += Plat_FloatTime() - start;
+
+                // The SAX reader parses in place, so it needs a fresh copy every time
+                Q_memcpy(input.Base(), buf.Base(), size);
+
+                start = Plat_FloatTime();
+                {
+                    char szError[128];
+                    APIModel *pModel = CJsonModelReader::CreateResponseModel(type);
+                    bFailed |= !CJsonModelReader::ReadJson(input.Base(), pModel, szError, sizeof(szError));
+                    saxElements = GetModelElementCount(type, pModel);
+                    delete pModel;
+                }
+                saxTime += Plat_FloatTime() - start;
+            }
+
+            // Decode once more, outside of the timing, to check both ways end up with the same fields
+            if (!bFailed)
+            {
+                KeyValuesAD pKv("data");
+                CJsonToKeyValues::ConvertJsonToKeyValues(static_cast<char *>(buf.Base()), pKv);
+                APIModel *pKvModel = CJsonModelReader::CreateResponseModel(type);
+                pKvModel->FromKV(pKv);
+
+                char szError[128];
+                Q_memcpy(input.Base(), buf.Base(), size);
+                APIModel *pSaxModel = CJsonModelReader::CreateResponseModel(type);
+                CJsonModelReader::ReadJson(input.Base(), pSaxModel, szError, sizeof(szError));
+
+                KeyValuesAD pKvFields("data"), pSaxFields("data");
+                pKvModel->ToKV(pKvFields);
+                pSaxModel->ToKV(pSaxFields);
+                bFieldsMatch = CompareModelFields(pKvFields, pSaxFields, pFoundFile);
+
+                delete pKvModel;
+                delete pSaxModel;
+            }
+
+            if (bFailed)
+            {
+                Warning("Failed to parse %s!\n", path);
+            }
+            else
+            {
+                if (kvElements != saxElements)
+                    Warning("%s decodes into %i elements through KeyValues but %i through SAX!\n", path, kvElements, saxElements);
+                else if (!bFieldsMatch)
+                    Warning("%s decodes into different fields through KeyValues and SAX!\n", path);
+
+                Msg("%-32s %8i bytes %5i elements: KeyValues %8.3f ms, SAX %8.3f ms (%.1fx)\n", pFoundFile, size - 1,
+                    saxElements, kvTime * 1000.0 / iterations, saxTime * 1000.0 / iterations, kvTime / MAX(saxTime, 1e-9));
+
+                kvTotal += kvTime;
+                saxTotal += saxTime;
+                responses++;
+            }
+        }
+
+        pFoundFile = g_pFullFileSystem->FindNext(found);
+    }
+    g_pFullFileSystem->FindClose(found);
+
+    if (!responses)
+    {
+        Warning("No API response fixtures found in %s! Record some with mom_api_record_fixtures 1.\n", API_FIXTURES_PATH);
+        return;
+    }
+
+    const double divisor = responses * iterations / 1000.0;
+    Msg("%i responses, %i iterations: KeyValues %.3f ms/response, SAX %.3f ms/response (%.1fx)\n", responses, iterations,
+        kvTotal / divisor, saxTotal / divisor, kvTotal / MAX(saxTotal, 1e-9));
+}
@@ -1,6 +1,7 @@
 #include "cbase.h"
 
 #include "mom_api_models.h"
+#include "mom_api_json.h"
 
 #include "mom_modulecomms.h"
 #include "filesystem.h"
@@ -12,7 +13,7 @@ APIModel::APIModel(): m_bValid(false), m_bUpdated(true), m_eSource(MODEL_FROM_DI
 {
 }
 
-User::User(): m_uMainID(0), m_uSteamID(0)
+User::User(): m_uMainID(0), m_uSteamID(0), m_iRoles(0), m_iBans(0)
 {
     m_szAlias[0] = '\0';
 }
@@ -22,6 +23,27 @@ void User::FromKV(KeyValues* pKv)
     m_uMainID = pKv->GetUint64("id");
     m_uSteamID = pKv->GetUint64("steamID");
     Q_strncpy(m_szAlias, pKv->GetString("alias"), sizeof(m_szAlias));
+    m_iRoles = pKv->GetInt("roles");
+    m_iBans = pKv->GetInt("bans");
+    m_bValid = m_uMainID > 0 && Q_strlen(m_szAlias) > 0;
+}
+
+void User::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "id"))
+        m_uMainID = value.GetUint64();
+    else if (FStrEq(pKey, "steamID"))
+        m_uSteamID = value.GetUint64();
+    else if (FStrEq(pKey, "alias"))
+        Q_strncpy(m_szAlias, value.GetString(), sizeof(m_szAlias));
+    else if (FStrEq(pKey, "roles"))
+        m_iRoles = value.GetInt();
+    else if (FStrEq(pKey, "bans"))
+        m_iBans = value.GetInt();
+}
+
+void User::FromJsonEnd()
+{
     m_bValid = m_uMainID > 0 && Q_strlen(m_szAlias) > 0;
 }
 
@@ -40,6 +62,8 @@ User& User::operator=(const User& src)
         m_uMainID = src.m_uMainID;
         m_uSteamID = src.m_uSteamID;
         Q_strncpy(m_szAlias, src.m_szAlias, sizeof(m_szAlias));
+        m_iRoles = src.m_iRoles;
+        m_iBans = src.m_iBans;
         m_bValid = src.m_bValid;
     }
 
@@ -66,6 +90,21 @@ void MapInfo::FromKV(KeyValues* pKv)
     m_bValid = m_iNumTracks && Q_strlen(m_szDescription);
 }
 
+void MapInfo::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "description"))
+        Q_strncpy(m_szDescription, value.GetString(), sizeof(m_szDescription));
+    else if (FStrEq(pKey, "numTracks"))
+        m_iNumTracks = value.GetInt();
+    else if (FStrEq(pKey, "creationDate"))
+        Q_strncpy(m_szCreationDate, value.GetString(), sizeof(m_szCreationDate));
+}
+
+void MapInfo::FromJsonEnd()
+{
+    m_bValid = m_iNumTracks && Q_strlen(m_szDescription);
+}
+
 void MapInfo::ToKV(KeyValues* pKv) const
 {
     pKv->SetString("description", m_szDescription);
@@ -112,6 +151,25 @@ void MapImage::FromKV(KeyValues* pKv)
     m_bValid = m_uID > 0;
 }
 
+void MapImage::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "id"))
+        m_uID = value.GetInt();
+    else if (FStrEq(pKey, "small"))
+        Q_strncpy(m_szURLSmall, value.GetString(), sizeof(m_szURLSmall));
+    else if (FStrEq(pKey, "medium"))
+        Q_strncpy(m_szURLMedium, value.GetString(), sizeof(m_szURLMedium));
+    else if (FStrEq(pKey, "large"))
+        Q_strncpy(m_szURLLarge, value.GetString(), sizeof(m_szURLLarge));
+    else if (FStrEq(pKey, "updatedAt"))
+        Q_strncpy(m_szLastUpdatedDate, value.GetString(), sizeof(m_szLastUpdatedDate));
+}
+
+void MapImage::FromJsonEnd()
+{
+    m_bValid = m_uID > 0;
+}
+
 void MapImage::ToKV(KeyValues* pKv) const
 {
     pKv->SetInt("id", m_uID);
@@ -156,6 +214,24 @@ void MapCredit::FromKV(KeyValues* pKv)
     m_bValid = m_uID > 0;
 }
 
+void MapCredit::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "id"))
+        m_uID = value.GetInt();
+    else if (FStrEq(pKey, "type"))
+        m_eType = (MapCreditType_t) value.GetInt();
+}
+
+APIModel *MapCredit::FromJsonObject(const char *pKey)
+{
+    return FStrEq(pKey, "user") ? &m_User : nullptr;
+}
+
+void MapCredit::FromJsonEnd()
+{
+    m_bValid = m_uID > 0;
+}
+
 void MapCredit::ToKV(KeyValues* pKv) const
 {
     pKv->SetInt("id", m_uID);
@@ -186,7 +262,7 @@ MapCredit& MapCredit::operator=(const MapCredit& other)
     return *this;
 }
 
-Run::Run(): m_uID(0), m_bIsPersonalBest(false), m_fTickRate(0.0f), m_fTime(.0f), m_uFlags(0)
+Run::Run(): m_uID(0), m_bIsPersonalBest(false), m_bVIP(false), m_fTickRate(0.0f), m_fTime(.0f), m_uFlags(0)
 {
     m_szDownloadURL[0] = '\0';
     m_szFileHash[0] = '\0';
@@ -197,6 +273,7 @@ void Run::FromKV(KeyValues* pKv)
 {
     m_uID = pKv->GetUint64("id");
     m_bIsPersonalBest = pKv->GetBool("isPersonalBest");
+    m_bVIP = pKv->GetBool("vip");
     m_fTickRate = pKv->GetFloat("tickRate");
     Q_strncpy(m_szDateAchieved, pKv->GetString("createdAt"), sizeof(m_szDateAchieved));
     m_fTime = pKv->GetFloat("time");
@@ -206,10 +283,38 @@ void Run::FromKV(KeyValues* pKv)
     m_bValid = m_uID > 0;
 }
 
+void Run::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "id"))
+        m_uID = value.GetUint64();
+    else if (FStrEq(pKey, "isPersonalBest"))
+        m_bIsPersonalBest = value.GetBool();
+    else if (FStrEq(pKey, "vip"))
+        m_bVIP = value.GetBool();
+    else if (FStrEq(pKey, "tickRate"))
+        m_fTickRate = value.GetFloat();
+    else if (FStrEq(pKey, "createdAt"))
+        Q_strncpy(m_szDateAchieved, value.GetString(), sizeof(m_szDateAchieved));
+    else if (FStrEq(pKey, "time"))
+        m_fTime = value.GetFloat();
+    else if (FStrEq(pKey, "flags"))
+        m_uFlags = value.GetInt();
+    else if (FStrEq(pKey, "file"))
+        Q_strncpy(m_szDownloadURL, value.GetString(), sizeof(m_szDownloadURL));
+    else if (FStrEq(pKey, "hash"))
+        Q_strncpy(m_szFileHash, value.GetString(), sizeof(m_szFileHash));
+}
+
+void Run::FromJsonEnd()
+{
+    m_bValid = m_uID > 0;
+}
+
 void Run::ToKV(KeyValues* pKv) const
 {
     pKv->SetUint64("id", m_uID);
     pKv->SetBool("isPersonalBest", m_bIsPersonalBest);
+    pKv->SetBool("vip", m_bVIP);
     pKv->SetFloat("tickRate", m_fTickRate);
     pKv->SetString("createdAt", m_szDateAchieved);
     pKv->SetFloat("time", m_fTime);
@@ -230,6 +335,7 @@ Run& Run::operator=(const Run& other)
         m_bUpdated = !(*this == other);
         m_uID = other.m_uID;
         m_bIsPersonalBest = other.m_bIsPersonalBest;
+        m_bVIP = other.m_bVIP;
         m_fTickRate = other.m_fTickRate;
         Q_strncpy(m_szDateAchieved, other.m_szDateAchieved, sizeof(m_szDateAchieved));
         m_fTime = other.m_fTime;
@@ -276,6 +382,29 @@ void MapRank::FromKV(KeyValues* pKv)
     m_bValid = m_iRank > 0;
 }
 
+void MapRank::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "rank"))
+        m_iRank = value.GetInt();
+    else if (FStrEq(pKey, "rankXP"))
+        m_iRankXP = value.GetInt();
+}
+
+APIModel *MapRank::FromJsonObject(const char *pKey)
+{
+    if (FStrEq(pKey, "run"))
+        return &m_Run;
+    if (FStrEq(pKey, "user"))
+        return &m_User;
+
+    return nullptr;
+}
+
+void MapRank::FromJsonEnd()
+{
+    m_bValid = m_iRank > 0;
+}
+
 void MapRank::ToKV(KeyValues* pKv) const
 {
     pKv->SetInt("rank", m_iRank);
@@ -332,6 +461,23 @@ void MapTrack::FromKV(KeyValues *pKv)
     m_bValid = m_iNumZones && m_iDifficulty;
 }
 
+void MapTrack::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "trackNum"))
+        m_iTrackNum = (uint8) value.GetInt();
+    else if (FStrEq(pKey, "difficulty"))
+        m_iDifficulty = (uint8) value.GetInt();
+    else if (FStrEq(pKey, "numZones"))
+        m_iNumZones = (uint8) value.GetInt();
+    else if (FStrEq(pKey, "isLinear"))
+        m_bIsLinear = value.GetBool();
+}
+
+void MapTrack::FromJsonEnd()
+{
+    m_bValid = m_iNumZones && m_iDifficulty;
+}
+
 void MapTrack::ToKV(KeyValues *pKv) const
 {
     pKv->SetInt("trackNum", m_iTrackNum);
@@ -582,6 +728,107 @@ void MapData::FromKV(KeyValues* pMap)
     m_bValid = m_uID > 0;
 }
 
+void MapData::FromJsonStart()
+{
+    m_uID = 0;
+    m_szMapName[0] = '\0';
+    m_eType = GAMEMODE_UNKNOWN;
+    m_eMapStatus = STATUS_UNKNOWN;
+    m_szHash[0] = '\0';
+    m_szDownloadURL[0] = '\0';
+    m_szLastUpdated[0] = '\0';
+    m_szCreatedAt[0] = '\0';
+    m_bInFavorites = false;
+    m_bInLibrary = false;
+}
+
+void MapData::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "id"))
+        m_uID = value.GetInt();
+    else if (FStrEq(pKey, "name"))
+        Q_strncpy(m_szMapName, value.GetString(), sizeof(m_szMapName));
+    else if (FStrEq(pKey, "type"))
+        m_eType = (GameMode_t) value.GetInt();
+    else if (FStrEq(pKey, "statusFlag"))
+        m_eMapStatus = (MapUploadStatus_t) value.GetInt();
+    else if (FStrEq(pKey, "hash"))
+        Q_strncpy(m_szHash, value.GetString(), sizeof(m_szHash));
+    else if (FStrEq(pKey, "downloadURL"))
+        Q_strncpy(m_szDownloadURL, value.GetString(), sizeof(m_szDownloadURL));
+    else if (FStrEq(pKey, "updatedAt"))
+        Q_strncpy(m_szLastUpdated, value.GetString(), sizeof(m_szLastUpdated));
+    else if (FStrEq(pKey, "createdAt"))
+        Q_strncpy(m_szCreatedAt, value.GetString(), sizeof(m_szCreatedAt));
+}
+
+APIModel *MapData::FromJsonObject(const char *pKey)
+{
+    if (FStrEq(pKey, "info"))
+        return &m_Info;
+    if (FStrEq(pKey, "mainTrack"))
+        return &m_MainTrack;
+    if (FStrEq(pKey, "submitter"))
+        return &m_Submitter;
+    if (FStrEq(pKey, "thumbnail"))
+        return &m_Thumbnail;
+    if (FStrEq(pKey, "personalBest"))
+        return &m_PersonalBest;
+    if (FStrEq(pKey, "worldRecord"))
+        return &m_WorldRecord;
+
+    return nullptr;
+}
+
+APIModel *MapData::FromJsonArrayObject(const char *pKey)
+{
+    if (FStrEq(pKey, "credits"))
+        return &m_vecCredits[m_vecCredits.AddToTail()];
+    if (FStrEq(pKey, "images"))
+        return &m_vecImages[m_vecImages.AddToTail()];
+
+    // Only whether these have any entries matters
+    if (FStrEq(pKey, "favorites"))
+        m_bInFavorites = true;
+    else if (FStrEq(pKey, "libraryEntries"))
+        m_bInLibrary = true;
+
+    return nullptr;
+}
+
+// FromKV replaces an entry that is already there (by ID) instead of adding it again
+template <class T>
+static void MergeDuplicateEntries(CUtlVector<T> &vec)
+{
+    for (int i = 1; i < vec.Count();)
+    {
+        const int indx = vec.Find(vec[i]);
+        if (indx < i)
+        {
+            vec[indx] = vec[i];
+            vec.Remove(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void MapData::FromJsonEnd()
+{
+    if (m_eSource > MODEL_FROM_DISK)
+    {
+        MergeDuplicateEntries(m_vecCredits);
+        MergeDuplicateEntries(m_vecImages);
+    }
+
+    m_bInFavorites |= m_eSource == MODEL_FROM_FAVORITES_API_CALL;
+    m_bInLibrary |= m_eSource == MODEL_FROM_LIBRARY_API_CALL;
+    m_bMapFileNeedsUpdate = m_eSource == MODEL_FROM_LIBRARY_API_CALL;
+    m_bValid = m_uID > 0;
+}
+
 void MapData::ToKV(KeyValues* pKv) const
 {
     pKv->SetName(m_szMapName);
@@ -720,4 +967,141 @@ bool MapData::operator==(const MapData& other) const
         m_bInFavorites == other.m_bInFavorites && m_bInLibrary == other.m_bInLibrary &&
         m_Info == other.m_Info && m_PersonalBest == other.m_PersonalBest && m_WorldRecord == other.m_WorldRecord &&
         m_Thumbnail == other.m_Thumbnail;
-}
\ No newline at end of file
+}
+
+MapListResponse::MapListResponse(APIModelSource source, const char *pArrayKey, bool bEntries)
+    : m_iCount(0), m_bEntries(bEntries), m_bInEntry(false)
+{
+    m_eSource = source;
+    Q_strncpy(m_szArrayKey, pArrayKey, sizeof(m_szArrayKey));
+}
+
+MapListResponse::~MapListResponse()
+{
+    m_vecMaps.PurgeAndDeleteElements();
+}
+
+void MapListResponse::FromKV(KeyValues *pKv)
+{
+    m_iCount = pKv->GetInt("count");
+
+    KeyValues *pMaps = pKv->FindKey(m_szArrayKey);
+    if (pMaps)
+    {
+        FOR_EACH_SUBKEY(pMaps, pMap)
+        {
+            KeyValues *pMapKv = m_bEntries ? pMap->FindKey("map") : pMap;
+            if (!pMapKv)
+                continue;
+
+            MapData *pData = new MapData;
+            pData->m_eSource = m_eSource;
+            pData->FromKV(pMapKv);
+            m_vecMaps.AddToTail(pData);
+        }
+    }
+
+    m_bValid = true;
+}
+
+void MapListResponse::ToKV(KeyValues *pKv) const
+{
+    pKv->SetInt("count", m_iCount);
+
+    KeyValues *pMaps = pKv->FindKey(m_szArrayKey, true);
+    FOR_EACH_VEC(m_vecMaps, i)
+    {
+        KeyValues *pMap = pMaps->CreateNewKey();
+        m_vecMaps[i]->ToKV(m_bEntries ? pMap->FindKey("map", true) : pMap);
+    }
+}
+
+void MapListResponse::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (!m_bInEntry && FStrEq(pKey, "count"))
+        m_iCount = value.GetInt();
+}
+
+APIModel *MapListResponse::FromJsonObject(const char *pKey)
+{
+    if (!m_bInEntry || !FStrEq(pKey, "map"))
+        return nullptr;
+
+    MapData *pData = new MapData;
+    pData->m_eSource = m_eSource;
+    m_vecMaps.AddToTail(pData);
+    return pData;
+}
+
+APIModel *MapListResponse::FromJsonArrayObject(const char *pKey)
+{
+    if (m_bInEntry || !FStrEq(pKey, m_szArrayKey))
+        return nullptr;
+
+    // Entries are filled by the list itself, until their map object shows up
+    if (m_bEntries)
+    {
+        m_bInEntry = true;
+        return this;
+    }
+
+    MapData *pData = new MapData;
+    pData->m_eSource = m_eSource;
+    m_vecMaps.AddToTail(pData);
+    return pData;
+}
+
+void MapListResponse::FromJsonEnd()
+{
+    if (m_bInEntry)
+        m_bInEntry = false;
+    else
+        m_bValid = true;
+}
+
+RankListResponse::RankListResponse() : m_iCount(0)
+{
+}
+
+void RankListResponse::FromKV(KeyValues *pKv)
+{
+    m_iCount = pKv->GetInt("count");
+
+    KeyValues *pRanks = pKv->FindKey("ranks");
+    if (pRanks)
+    {
+        FOR_EACH_SUBKEY(pRanks, pRank)
+        {
+            m_vecRanks[m_vecRanks.AddToTail()].FromKV(pRank);
+        }
+    }
+
+    m_bValid = true;
+}
+
+void RankListResponse::ToKV(KeyValues *pKv) const
+{
+    pKv->SetInt("count", m_iCount);
+
+    KeyValues *pRanks = pKv->FindKey("ranks", true);
+    FOR_EACH_VEC(m_vecRanks, i)
+    {
+        m_vecRanks[i].ToKV(pRanks->CreateNewKey());
+    }
+}
+
+void RankListResponse::FromJsonValue(const char *pKey, const JsonValue_t &value)
+{
+    if (FStrEq(pKey, "count"))
+        m_iCount = value.GetInt();
+}
+
+APIModel *RankListResponse::FromJsonArrayObject(const char *pKey)
+{
+    return FStrEq(pKey, "ranks") ? &m_vecRanks[m_vecRanks.AddToTail()] : nullptr;
+}
+
+void RankListResponse::FromJsonEnd()
+{
+    m_bValid = true;
+}
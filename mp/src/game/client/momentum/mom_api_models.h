@@ -11,6 +11,8 @@ enum APIModelSource
     MODEL_FROM_INFO_API_CALL,
 };
 
+struct JsonValue_t;
+
 abstract_class APIModel
 {
 public:
@@ -21,6 +23,18 @@ public:
     APIModelSource m_eSource;
     virtual void FromKV(KeyValues *pKv) = 0;
     virtual void ToKV(KeyValues *pKv) const = 0;
+
+    // Filling the model straight from the JSON of an API response, see CJsonModelReader.
+    // Whatever the model doesn't know is skipped.
+    // The object this model fills from starts, fields FromKV always sets go back to what it gives missing keys
+    virtual void FromJsonStart() {}
+    virtual void FromJsonValue(const char *pKey, const JsonValue_t &value) {}
+    // The model that fills from the object under the key, null to skip the object
+    virtual APIModel *FromJsonObject(const char *pKey) { return nullptr; }
+    // The model that fills from the next object of the array under the key, null to skip the object
+    virtual APIModel *FromJsonArrayObject(const char *pKey) { return nullptr; }
+    // The object this model filled from ended
+    virtual void FromJsonEnd() {}
 };
 
 struct User : APIModel
@@ -28,10 +42,14 @@ struct User : APIModel
     uint32 m_uMainID;
     uint64 m_uSteamID;
     char m_szAlias[MAX_PLAYER_NAME_LENGTH];
+    int m_iRoles; // UserRoles_t flags
+    int m_iBans; // UserBans_t flags
     User();
 
     void FromKV(KeyValues* pKv) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     User& operator=(const User& src);
     bool operator==(const User &other) const;
 };
@@ -45,6 +63,8 @@ struct MapInfo : APIModel
 
     void FromKV(KeyValues *pKv) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     MapInfo& operator=(const MapInfo& other);
     bool operator==(const MapInfo &other) const;
 };
@@ -58,6 +78,8 @@ struct MapImage : APIModel
 
     void FromKV(KeyValues* pKv) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     bool operator==(const MapImage &other) const;
     MapImage& operator=(const MapImage& other);
 };
@@ -71,6 +93,9 @@ struct MapCredit : APIModel
 
     void FromKV(KeyValues* pKv) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    APIModel *FromJsonObject(const char *pKey) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     bool operator==(const MapCredit& other) const;
     MapCredit& operator=(const MapCredit& other);
 };
@@ -79,6 +104,7 @@ struct Run : APIModel
 {
     uint64 m_uID;
     bool m_bIsPersonalBest;
+    bool m_bVIP;
     float m_fTickRate;
     char m_szDateAchieved[32]; // ISO date
     float m_fTime; // In seconds
@@ -89,6 +115,8 @@ struct Run : APIModel
 
     void FromKV(KeyValues* pKv) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     bool operator==(const Run& other) const;
     Run& operator=(const Run& other);
 };
@@ -105,6 +133,9 @@ struct MapRank : APIModel
     void ResetUpdate();
     void FromKV(KeyValues* pKv) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    APIModel *FromJsonObject(const char *pKey) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     bool operator==(const MapRank& other) const;
     MapRank& operator=(const MapRank& other);
 };
@@ -119,6 +150,8 @@ struct MapTrack : APIModel
 
     void FromKV(KeyValues *pKv) OVERRIDE;
     void ToKV(KeyValues *pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     bool operator==(const MapTrack &other) const;
     MapTrack &operator=(const MapTrack &other);
 };
@@ -160,6 +193,49 @@ struct MapData : APIModel
     void DeleteMapFile();
     void FromKV(KeyValues* pMap) OVERRIDE;
     void ToKV(KeyValues* pKv) const OVERRIDE;
+    void FromJsonStart() OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    APIModel *FromJsonObject(const char *pKey) OVERRIDE;
+    APIModel *FromJsonArrayObject(const char *pKey) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
     MapData& operator=(const MapData& src);
     bool operator==(const MapData& other) const;
-};
\ No newline at end of file
+};
+
+// The data of the responses listing maps (search, library, favorites)
+struct MapListResponse : APIModel
+{
+    // Library and favorites entries wrap their map in a "map" object
+    MapListResponse(APIModelSource source, const char *pArrayKey, bool bEntries);
+    ~MapListResponse();
+
+    int m_iCount;
+    CUtlVector<MapData*> m_vecMaps; // Owned by the response, remove the ones that are kept
+
+    void FromKV(KeyValues *pKv) OVERRIDE;
+    void ToKV(KeyValues *pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    APIModel *FromJsonObject(const char *pKey) OVERRIDE;
+    APIModel *FromJsonArrayObject(const char *pKey) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
+
+private:
+    char m_szArrayKey[32];
+    bool m_bEntries;
+    bool m_bInEntry;
+};
+
+// The data of the leaderboard responses
+struct RankListResponse : APIModel
+{
+    RankListResponse();
+
+    int m_iCount;
+    CUtlVector<MapRank> m_vecRanks;
+
+    void FromKV(KeyValues *pKv) OVERRIDE;
+    void ToKV(KeyValues *pKv) const OVERRIDE;
+    void FromJsonValue(const char *pKey, const JsonValue_t &value) OVERRIDE;
+    APIModel *FromJsonArrayObject(const char *pKey) OVERRIDE;
+    void FromJsonEnd() OVERRIDE;
+};
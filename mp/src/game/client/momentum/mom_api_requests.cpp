@@ -7,12 +7,21 @@
 #include "filesystem.h"
 
 #include "MessageboxPanel.h"
+#include "util/mom_file_hash_cache.h"
+
+#include "tier0/valve_minmax_off.h"
+// These are wrapped by minmax_off/on due to Valve making a macro for min and max...
+#include "cryptopp/sha.h"
+// Now we can unwrap
+#include "tier0/valve_minmax_on.h"
 
 #include "tier0/memdbgon.h"
 
 static MAKE_TOGGLE_CONVAR(mom_api_log_requests, "0", FCVAR_ARCHIVE | FCVAR_REPLICATED, "If 1, API requests will be logged to console.\n");
 static MAKE_TOGGLE_CONVAR(mom_api_log_requests_sensitive, "0", FCVAR_ARCHIVE | FCVAR_REPLICATED, "If 1, API requests that are sensitive will also be logged to console.\n"
 "!!!!!!! DANGER! Only set this if you know what you are doing! This could potentially expose an API key! !!!!!!!");
+static MAKE_TOGGLE_CONVAR(mom_api_record_fixtures, "0", FCVAR_NONE, "If 1, the bodies of API responses decoded into models are saved to "
+                          "api_fixtures/ for mom_api_json_benchmark.\n");
 static ConVar mom_api_base_url("mom_api_base_url", "https://momentum-mod.org", FCVAR_ARCHIVE | FCVAR_REPLICATED, "The base URL for the API requests.\n");
 
 #define API_REQ(url) CFmtStr1024("%s/api/%s", mom_api_base_url.GetString(), (url)).Get()
@@ -31,6 +40,21 @@ static const char* const s_pHTTPMethods[] = {
     "PATCH",
 };
 
+DownloadRequest::~DownloadRequest()
+{
+    if (completeResult)
+        delete completeResult;
+
+    // Cancelled by shutting down, don't leave the partial file around
+    if (m_hTempFile != FILESYSTEM_INVALID_HANDLE)
+    {
+        g_pFullFileSystem->Close(m_hTempFile);
+        g_pFullFileSystem->RemoveFile(m_szTempFileName, m_szFilePathID);
+    }
+
+    delete m_pHash;
+}
+
 CAPIRequests::CAPIRequests() : CAutoGameSystem("CAPIRequests"), 
 m_hAuthTicket(k_HAuthTicketInvalid), m_bufAuthBuffer(nullptr),
 m_iAuthActualSize(0), m_pAPIKey(nullptr)
@@ -61,6 +85,7 @@ bool CAPIRequests::GetMaps(KeyValues *pKvFilters, CallbackFunc func)
     APIRequest *req = new APIRequest;
     if (CreateAPIRequest(req, API_REQ("maps"), k_EHTTPMethodGET))
     {
+        req->m_eResponseModel = API_RESPONSE_MAPS;
         if (pKvFilters && !pKvFilters->IsEmpty())
         {
             FOR_EACH_VALUE(pKvFilters, pKvFilter)
@@ -82,6 +107,7 @@ bool CAPIRequests::GetTop10MapTimes(uint32 mapID, CallbackFunc func, KeyValues *
     APIRequest *req = new APIRequest;
     if (CreateAPIRequest(req, API_REQ(CFmtStr("maps/%u/ranks", mapID).Get()), k_EHTTPMethodGET))
     {
+        req->m_eResponseModel = API_RESPONSE_RANKS;
         if (pKvFilters)
         {
             FOR_EACH_VALUE(pKvFilters, pKvFilter)
@@ -98,6 +124,7 @@ bool CAPIRequests::GetFriendsTimes(uint32 mapID, CallbackFunc func, KeyValues *p
     APIRequest *req = new APIRequest;
     if (CreateAPIRequest(req, API_REQ(CFmtStr("maps/%u/ranks/friends", mapID).Get()), k_EHTTPMethodGET))
     {
+        req->m_eResponseModel = API_RESPONSE_RANKS;
         if (pKvFilters)
         {
             FOR_EACH_VALUE(pKvFilters, pKvFilter)
@@ -114,6 +141,7 @@ bool CAPIRequests::GetAroundTimes(uint32 mapID, CallbackFunc func, KeyValues *pK
     APIRequest *req = new APIRequest;
     if (CreateAPIRequest(req, API_REQ(CFmtStr("maps/%u/ranks/around", mapID).Get()), k_EHTTPMethodGET))
     {
+        req->m_eResponseModel = API_RESPONSE_RANKS;
         if (pKvFilters)
         {
             FOR_EACH_VALUE(pKvFilters, pKvFilter)
@@ -171,6 +199,7 @@ bool CAPIRequests::GetUserMapLibrary(CallbackFunc func)
     APIRequest *req = new APIRequest;
     if (CreateAPIRequest(req, API_REQ("user/maps/library"), k_EHTTPMethodGET))
     {
+        req->m_eResponseModel = API_RESPONSE_LIBRARY;
         SteamHTTP()->SetHTTPRequestGetOrPostParameter(req->handle, "expand", "info,thumbnail,inFavorites,personalBest,worldRecord");
         SteamHTTP()->SetHTTPRequestGetOrPostParameter(req->handle, "limit", "0");
 
@@ -196,6 +225,7 @@ bool CAPIRequests::GetUserMapFavorites(CallbackFunc func)
     APIRequest *req = new APIRequest;
     if (CreateAPIRequest(req, API_REQ("user/maps/favorites"), k_EHTTPMethodGET))
     {
+        req->m_eResponseModel = API_RESPONSE_FAVORITES;
         SteamHTTP()->SetHTTPRequestGetOrPostParameter(req->handle, "limit", "0");
         SteamHTTP()->SetHTTPRequestGetOrPostParameter(req->handle, "expand", "info,inLibrary,worldRecord,personalBest");
 
@@ -315,7 +345,8 @@ bool CAPIRequests::GetUserRunHistory(uint32 userID, CallbackFunc func, KeyValues
 }
 
 HTTPRequestHandle CAPIRequests::DownloadFile(const char* pszURL, CallbackFunc size, CallbackFunc prog, CallbackFunc end, 
-                                             const char *pFileName, const char *pFilePathID /* = "GAME"*/, bool bAuth /*= false*/)
+                                             const char *pFileName, const char *pFilePathID /* = "GAME"*/, bool bAuth /*= false*/,
+                                             const char *pExpectedHash /* = nullptr*/)
 {
     HTTPRequestHandle handle = INVALID_HTTPREQUEST_HANDLE;
     APIRequest *req = new APIRequest;
@@ -339,6 +370,18 @@ HTTPRequestHandle CAPIRequests::DownloadFile(const char* pszURL, CallbackFunc si
             {
                 V_FixupPathName(callback->m_szFileName, sizeof(callback->m_szFileName), pFileName);
                 Q_strncpy(callback->m_szFilePathID, pFilePathID, sizeof(callback->m_szFilePathID));
+
+                Q_snprintf(callback->m_szTempFileName, sizeof(callback->m_szTempFileName), "%s.download", callback->m_szFileName);
+                callback->m_hTempFile = g_pFullFileSystem->Open(callback->m_szTempFileName, "wb", pFilePathID);
+                if (callback->m_hTempFile == FILESYSTEM_INVALID_HANDLE)
+                {
+                    Warning("%s --- Failed to open %s for downloading to!\n", __FUNCTION__, callback->m_szTempFileName);
+                    callback->m_bWriteFailed = true;
+                }
+
+                callback->m_pHash = new CryptoPP::SHA1;
+                if (pExpectedHash)
+                    Q_strncpy(callback->m_szExpectedHash, pExpectedHash, sizeof(callback->m_szExpectedHash));
             }
             callback->completeResult = new CCallResult<CAPIRequests, HTTPRequestCompleted_t>();
             callback->completeResult->Set(apiHandle, this, &CAPIRequests::OnDownloadHTTPComplete);
@@ -497,7 +540,8 @@ void CAPIRequests::OnDownloadHTTPHeader(HTTPRequestHeadersReceived_t* pCallback)
                     headers->SetUint64("size", fileSize);
 
                     DownloadRequest *call = m_mapDownloadCalls[downloadCallbackIndx];
-                    call->m_bufFileData.EnsureCapacity(fileSize);
+                    if (!call->m_bSaveToFile)
+                        call->m_bufFileData.EnsureCapacity(fileSize);
                     call->sizeFunc(headers);
                 }
             }
@@ -513,12 +557,28 @@ void CAPIRequests::OnDownloadHTTPData(HTTPRequestDataReceived_t* pCallback)
     const uint16 downloadCallbackIndx = m_mapDownloadCalls.Find(pCallback->m_hRequest);
     if (downloadCallbackIndx != m_mapDownloadCalls.InvalidIndex())
     {
-        uint8 *pDataTemp = new uint8[pCallback->m_cBytesReceived];
+        DownloadRequest *call = m_mapDownloadCalls[downloadCallbackIndx];
+
+        // Every chunk goes through the one chunk buffer, on its way to either the file or the request's buffer
+        m_DownloadChunk.EnsureCapacity(pCallback->m_cBytesReceived);
+        uint8 *pDataTemp = m_DownloadChunk.Base();
+
         if (SteamHTTP()->GetHTTPStreamingResponseBodyData(pCallback->m_hRequest, pCallback->m_cOffset, pDataTemp, pCallback->m_cBytesReceived))
         {
-            DownloadRequest *call = m_mapDownloadCalls[downloadCallbackIndx];
-            // Add the data to the download buffer
-            call->m_bufFileData.Put(pDataTemp, pCallback->m_cBytesReceived);
+            if (!call->m_bSaveToFile)
+            {
+                call->m_bufFileData.Put(pDataTemp, pCallback->m_cBytesReceived);
+            }
+            else if (!call->m_bWriteFailed)
+            {
+                // The chunks come in order, anything else can't be hashed as it streams
+                call->m_bWriteFailed = pCallback->m_cOffset != call->m_uBytesWritten ||
+                                       g_pFullFileSystem->Write(pDataTemp, pCallback->m_cBytesReceived, call->m_hTempFile) !=
+                                           static_cast<int>(pCallback->m_cBytesReceived);
+
+                call->m_pHash->Update(pDataTemp, pCallback->m_cBytesReceived);
+                call->m_uBytesWritten += pCallback->m_cBytesReceived;
+            }
 
             KeyValuesAD prog("Progress");
             prog->SetUint64("request", pCallback->m_hRequest);
@@ -529,10 +589,52 @@ void CAPIRequests::OnDownloadHTTPData(HTTPRequestDataReceived_t* pCallback)
             prog->SetInt("size", pCallback->m_cBytesReceived);
             call->progressFunc(prog);
         }
+    }
+}
+
+bool CAPIRequests::FinishDownloadFile(DownloadRequest *pCall, bool bSuccess, KeyValues *pComplete)
+{
+    if (pCall->m_hTempFile != FILESYSTEM_INVALID_HANDLE)
+    {
+        g_pFullFileSystem->Close(pCall->m_hTempFile);
+        pCall->m_hTempFile = FILESYSTEM_INVALID_HANDLE;
+    }
+
+    if (!bSuccess || pCall->m_bWriteFailed)
+    {
+        if (pCall->m_bWriteFailed)
+            Warning("Failed to write the download to %s!\n", pCall->m_szTempFileName);
+
+        g_pFullFileSystem->RemoveFile(pCall->m_szTempFileName, pCall->m_szFilePathID);
+        return false;
+    }
+
+    byte digest[CryptoPP::SHA1::DIGESTSIZE];
+    pCall->m_pHash->Final(digest);
+    char szHash[41];
+    V_binarytohex(digest, sizeof(digest), szHash, sizeof(szHash));
 
-        delete[] pDataTemp;
-        pDataTemp = nullptr;
+    if (pCall->m_szExpectedHash[0] && Q_stricmp(szHash, pCall->m_szExpectedHash))
+    {
+        Warning("The download of %s doesn't match its expected hash, discarding it!\n", pCall->m_szFileName);
+        pComplete->SetBool("hash", true);
+        g_pFullFileSystem->RemoveFile(pCall->m_szTempFileName, pCall->m_szFilePathID);
+        return false;
     }
+
+    // Only now does the old file go, nothing is left half-written if the download fails
+    if (g_pFullFileSystem->FileExists(pCall->m_szFileName, pCall->m_szFilePathID))
+        g_pFullFileSystem->RemoveFile(pCall->m_szFileName, pCall->m_szFilePathID);
+
+    if (!g_pFullFileSystem->RenameFile(pCall->m_szTempFileName, pCall->m_szFileName, pCall->m_szFilePathID))
+    {
+        Warning("Failed to move the download %s to %s!\n", pCall->m_szTempFileName, pCall->m_szFileName);
+        g_pFullFileSystem->RemoveFile(pCall->m_szTempFileName, pCall->m_szFilePathID);
+        return false;
+    }
+
+    g_pFileHashCache->SetFileHash(pCall->m_szFileName, pCall->m_szFilePathID, szHash);
+    return true;
 }
 
 void CAPIRequests::OnDownloadHTTPComplete(HTTPRequestCompleted_t* pCallback, bool bIO)
@@ -545,7 +647,10 @@ void CAPIRequests::OnDownloadHTTPComplete(HTTPRequestCompleted_t* pCallback, boo
         KeyValuesAD comp("Complete");
         comp->SetUint64("request", pCallback->m_hRequest);
         comp->SetFloat("duration", Plat_FloatTime() - call->m_dSentTime);
-        if (bIO || !pCallback->m_bRequestSuccessful || pCallback->m_eStatusCode != k_EHTTPStatusCode200OK)
+        const bool bSuccess = !bIO && pCallback->m_bRequestSuccessful && pCallback->m_eStatusCode == k_EHTTPStatusCode200OK;
+        // The temporary file gets cleaned up on failure too
+        const bool bWrote = call->m_bSaveToFile && FinishDownloadFile(call, bSuccess, comp);
+        if (!bSuccess)
         {
             comp->SetBool("error", true);
             comp->SetInt("code", pCallback->m_eStatusCode);
@@ -553,7 +658,6 @@ void CAPIRequests::OnDownloadHTTPComplete(HTTPRequestCompleted_t* pCallback, boo
         }
         else if (call->m_bSaveToFile)
         {
-            bool bWrote = g_pFullFileSystem->WriteFile(call->m_szFileName, call->m_szFilePathID, call->m_bufFileData);
             comp->SetBool("error", !bWrote);
         }
         else
@@ -599,9 +703,33 @@ void CAPIRequests::OnHTTPResp(HTTPRequestCompleted_t* pCallback, bool bIOFailure
             SteamHTTP()->GetHTTPResponseBodyData(pCallback->m_hRequest, pData, pCallback->m_unBodySize);
             pData[pCallback->m_unBodySize] = 0; // Make sure to null terminate
 
-            // Fourthly-B, parse this JSON and convert to KeyValues
             char *pDataPtr = reinterpret_cast<char*>(pData);
-            if (!CJsonToKeyValues::ConvertJsonToKeyValues(pDataPtr, pKvBodyData))
+            if (mom_api_record_fixtures.GetBool() && bRequestOK && req->m_eResponseModel != API_RESPONSE_KEYVALUES)
+                RecordResponseFixture(req->m_eResponseModel, pDataPtr, pCallback->m_unBodySize);
+
+            // Fourthly-B, parse this JSON and decode it into the model of the request, or convert it to KeyValues.
+            // Errors are always KeyValues.
+            if (bRequestOK && req->m_eResponseModel != API_RESPONSE_KEYVALUES)
+            {
+                // The model is decoded in place, so the log gets the body as it came in instead of a second conversion
+                if (mom_api_log_requests.GetBool())
+                    pKvBodyData->SetString("body", pDataPtr);
+
+                req->m_pResponseModel = CJsonModelReader::CreateResponseModel(req->m_eResponseModel);
+
+                char szError[128];
+                if (CJsonModelReader::ReadJson(pDataPtr, req->m_pResponseModel, szError, sizeof(szError)))
+                {
+                    pKvBodyData->SetPtr("model", req->m_pResponseModel);
+                }
+                else
+                {
+                    pKvBodyData->SetName("error"); // Ensure it's passed as an error
+                    pKvBodyData->SetString("err_parse", szError);
+                    Warning("Failed to parse! %s\n", szError);
+                }
+            }
+            else if (!CJsonToKeyValues::ConvertJsonToKeyValues(pDataPtr, pKvBodyData))
             {
                 pKvBodyData->SetName("error"); // Ensure it's passed as an error
                 Warning("Failed to parse! %s\n", pKvBodyData->GetString("err_parse"));
@@ -716,5 +844,30 @@ bool CAPIRequests::CheckAPIResponse(HTTPRequestCompleted_t* pCallback, bool bIOF
         !bIOFailure && pCallback->m_bRequestSuccessful;
 }
 
+void CAPIRequests::RecordResponseFixture(APIResponseModel_t type, const char *pBody, uint32 uBodySize)
+{
+    g_pFullFileSystem->CreateDirHierarchy("api_fixtures", "MOD");
+
+    const char *pName = CJsonModelReader::GetResponseModelName(type);
+    CFmtStr path;
+    for (int i = 0;; i++)
+    {
+        path.sprintf("api_fixtures/%s_%i.json", pName, i);
+        if (!g_pFullFileSystem->FileExists(path.Get(), "MOD"))
+            break;
+    }
+
+    const FileHandle_t hFile = g_pFullFileSystem->Open(path.Get(), "wb", "MOD");
+    if (!hFile)
+    {
+        Warning("Failed to record API response fixture %s!\n", path.Get());
+        return;
+    }
+
+    g_pFullFileSystem->Write(pBody, uBodySize, hFile);
+    g_pFullFileSystem->Close(hFile);
+    DevLog("Recorded API response fixture %s\n", path.Get());
+}
+
 CAPIRequests s_APIRequests;
 CAPIRequests *g_pAPIRequests = &s_APIRequests;
\ No newline at end of file
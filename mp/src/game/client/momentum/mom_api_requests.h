@@ -5,11 +5,18 @@
 #include "steam/isteamhttp.h"
 #include "steam/isteamuser.h"
 #include "utldelegate.h"
+#include "filesystem.h"
+#include "mom_api_json.h"
 
 typedef CUtlDelegate<void (KeyValues *pKv)> CallbackFunc;
 
 class CAPIRequests;
 
+namespace CryptoPP
+{
+class SHA1;
+}
+
 struct APIRequest
 {
     APIRequest() : handle(INVALID_HTTPREQUEST_HANDLE), callResult(nullptr)
@@ -19,17 +26,24 @@ struct APIRequest
         m_szCallingFunc[0] = '\0';
         m_bSensitive = false;
         m_dSentTime = -1;
+        m_eResponseModel = API_RESPONSE_KEYVALUES;
+        m_pResponseModel = nullptr;
     }
     ~APIRequest()
     {
         if (callResult)
             delete callResult; // Should call cancel if still in progress
+        if (m_pResponseModel)
+            delete m_pResponseModel;
     }
     char m_szCallingFunc[256];
     char m_szURL[256];
     char m_szMethod[12];
     bool m_bSensitive;
     double m_dSentTime;
+    // If not KeyValues, the response data is decoded straight into this model, passed as the "model" pointer of "data"
+    APIResponseModel_t m_eResponseModel;
+    APIModel *m_pResponseModel; // Lives until the callback returns, callbacks may take elements out of it
     HTTPRequestHandle handle;
     CallbackFunc callbackFunc;
     CCallResult<CAPIRequests, HTTPRequestCompleted_t> *callResult;
@@ -41,19 +55,18 @@ struct APIRequest
 
 struct DownloadRequest
 {
-    DownloadRequest() : handle(INVALID_HTTPREQUEST_HANDLE), completeResult(nullptr), m_bSaveToFile(true)
+    DownloadRequest() : handle(INVALID_HTTPREQUEST_HANDLE), completeResult(nullptr), m_bSaveToFile(true),
+        m_hTempFile(FILESYSTEM_INVALID_HANDLE), m_uBytesWritten(0), m_bWriteFailed(false), m_pHash(nullptr)
     {
         m_dSentTime = -1;
         m_szFileName[0] = '\0';
         m_szFilePathID[0] = '\0';
         m_szURL[0] = '\0';
+        m_szTempFileName[0] = '\0';
+        m_szExpectedHash[0] = '\0';
     }
 
-    ~DownloadRequest()
-    {
-        if (completeResult)
-            delete completeResult;
-    }
+    ~DownloadRequest();
     HTTPRequestHandle handle;
     CCallResult<CAPIRequests, HTTPRequestCompleted_t> *completeResult;
 
@@ -74,6 +87,7 @@ struct DownloadRequest
     //  "request"   (uint64)    The request handle that the download operates under
     //  "error"     (bool)      If the request fails in any way, will be true, otherwise false
     //  "code"      (int)       The HTTP status code of the request if it failed, otherwise 0
+    //  "hash"      (bool)      True if the file was downloaded but didn't match the expected hash (also an error)
     //  "duration"  (float)     The amount of time in seconds it took to download the file
     //  "buf"       (pointer)   If the request was created with a nullptr filename, a pointer to the buffer is passed here
     CallbackFunc completeFunc;
@@ -83,7 +97,16 @@ struct DownloadRequest
     char m_szFilePathID[16];
     bool m_bSaveToFile;
     double m_dSentTime;
-    CUtlBuffer m_bufFileData;
+    CUtlBuffer m_bufFileData; // Only for downloads that aren't saved to a file
+
+    // Downloads to files are streamed into a temporary file next to it and hashed as the chunks arrive,
+    // the file only replaces the real one once it's complete (and matches the expected hash, if there is one)
+    char m_szTempFileName[MAX_PATH];
+    FileHandle_t m_hTempFile;
+    uint32 m_uBytesWritten;
+    bool m_bWriteFailed;
+    CryptoPP::SHA1 *m_pHash;
+    char m_szExpectedHash[41];
 
     bool operator==(const DownloadRequest &other) const
     {
@@ -166,10 +189,13 @@ public:
      *                      end CallbackFunc, fetched by `->GetPtr("buf");`, and will not be saved to disk.
      * @param pFilePathID   (Optional) The pathID of where the file should be stored. Defaults to "GAME".
      * @param bAuth         (Optional) Whether this request should be authenticated. Defaults to false.
+     * @param pExpectedHash (Optional) The SHA1 the downloaded file has to match, checked as the file streams in.
+     *                      The file is also put in the file hash cache, so it doesn't need hashing again.
      * @return The handle of the request, will be an invalid handle if the request fails
      */
     HTTPRequestHandle DownloadFile(const char *pszURL, CallbackFunc size, CallbackFunc prog, CallbackFunc end,
-                                   const char *pFileName, const char *pFilePathID = "GAME", bool bAuth = false);
+                                   const char *pFileName, const char *pFilePathID = "GAME", bool bAuth = false,
+                                   const char *pExpectedHash = nullptr);
 
     /**
      * @param handle    The handle of the request to cancel
@@ -190,6 +216,8 @@ protected:
     STEAM_CALLBACK(CAPIRequests, OnDownloadHTTPHeader, HTTPRequestHeadersReceived_t);
     STEAM_CALLBACK(CAPIRequests, OnDownloadHTTPData, HTTPRequestDataReceived_t);
     void OnDownloadHTTPComplete(HTTPRequestCompleted_t *pParam, bool bIO);
+    // Closes the temporary file of a download to a file, moving it in place if it's complete and valid
+    bool FinishDownloadFile(DownloadRequest *pCall, bool bSuccess, KeyValues *pComplete);
 
     // Base HTTP response method, the CallbackFunc is passed the JSON object here
     void OnHTTPResp(HTTPRequestCompleted_t *pParam, bool bIOFailure);
@@ -201,9 +229,13 @@ private:
     bool SendAPIRequest(APIRequest *request, CallbackFunc func, const char *pCallingFunction, bool bPrioritize = false);
     // Check the response for errors
     bool CheckAPIResponse(HTTPRequestCompleted_t *pCallback, bool bIOFailure);
+    // Saves the body of a response to api_fixtures/<model name>_<n>.json, for benchmarking the JSON decoding
+    void RecordResponseFixture(APIResponseModel_t type, const char *pBody, uint32 uBodySize);
 
     CUtlMap<HTTPRequestHandle, APIRequest*> m_mapAPICalls;
     CUtlMap<HTTPRequestHandle, DownloadRequest*> m_mapDownloadCalls;
+    // Every chunk of the downloads passes through here on its way to the file or the request's buffer
+    CUtlMemory<uint8> m_DownloadChunk;
 
     // Auth ticket impl
     HAuthTicket m_hAuthTicket;
@@ -20,7 +20,82 @@
 
 #include "tier0/memdbgon.h"
 
-#define MAP_CACHE_FILE_NAME "map_cache.dat"
+#define MAP_CACHE_FILE_NAME "map_cache.bin"
+// The text KeyValues map cache of older versions, migrated when there is no binary one yet
+#define MAP_CACHE_TEXT_FILE_NAME "map_cache.dat"
+
+#define MAP_CACHE_MAGIC 0x434D4D4D // "MMMC"
+#define MAP_CACHE_VERSION 1
+
+enum MapCacheRecordFlags_t
+{
+    MAP_CACHE_IN_FAVORITES = 1 << 0,
+    MAP_CACHE_IN_LIBRARY = 1 << 1,
+    MAP_CACHE_FILE_EXISTS = 1 << 2,
+    MAP_CACHE_FILE_NEEDS_UPDATE = 1 << 3,
+};
+
+// The map cache file is the header, the records sorted by map ID, the string table of map names, then the
+// data of every map as binary KeyValues. Everything is used in place out of the loaded file.
+struct MapCacheHeader_t
+{
+    uint32 m_uMagic;
+    uint32 m_uVersion;
+    char m_szGameVersion[16]; // The caches of other game versions are ignored
+    uint32 m_uRecordCount;
+    uint32 m_uStringTableOffset;
+    uint32 m_uStringTableSize;
+};
+
+// Holds what listing the maps needs, the rest of the map data is only read when the map itself is needed
+struct MapCacheRecord_t
+{
+    uint32 m_uID;
+    uint32 m_uNameOffset; // Into the string table
+    uint32 m_uDataOffset; // From the start of the file
+    uint32 m_uDataSize;
+    uint32 m_uDataCapacity; // Data that changed but still fits gets rewritten in place
+    uint8 m_uGameMode;
+    int8 m_iStatus;
+    uint8 m_uFlags;
+    uint8 m_uPad;
+    uint64 m_uLastPlayed;
+};
+
+COMPILE_TIME_ASSERT(sizeof(MapCacheHeader_t) == 36);
+COMPILE_TIME_ASSERT(sizeof(MapCacheRecord_t) == 32);
+
+static void FillMapCacheRecord(const MapData *pData, MapCacheRecord_t &record)
+{
+    V_memset(&record, 0, sizeof(record));
+    record.m_uID = pData->m_uID;
+    record.m_uGameMode = pData->m_eType;
+    record.m_iStatus = pData->m_eMapStatus;
+    record.m_uLastPlayed = pData->m_tLastPlayed;
+    record.m_uFlags = (pData->m_bInFavorites ? MAP_CACHE_IN_FAVORITES : 0) |
+                      (pData->m_bInLibrary ? MAP_CACHE_IN_LIBRARY : 0) |
+                      (pData->m_bMapFileExists ? MAP_CACHE_FILE_EXISTS : 0) |
+                      (pData->m_bMapFileNeedsUpdate ? MAP_CACHE_FILE_NEEDS_UPDATE : 0);
+}
+
+static bool WriteMapCacheData(const MapData *pData, CUtlBuffer &buf)
+{
+    KeyValuesAD pMap("Map");
+    pData->ToKV(pMap);
+    return pMap->WriteAsBinary(buf);
+}
+
+static bool IsMapInList(MapListType_e type, int status, bool bInLibrary, bool bInFavorites)
+{
+    if (type == MAP_LIST_LIBRARY)
+        return bInLibrary;
+    if (type == MAP_LIST_FAVORITES)
+        return bInFavorites;
+    if (type == MAP_LIST_TESTING)
+        return status == MAP_PRIVATE_TESTING || status == MAP_PUBLIC_TESTING;
+
+    return status == MAP_APPROVED;
+}
 
 void DownloadQueueCallback(IConVar *var, const char *pOldValue, float flOldValue)
 {
@@ -146,7 +221,7 @@ bool CMapCache::StartDownloadingMap(MapData* pData)
                                                             UtlMakeDelegate(this, &CMapCache::MapDownloadSize),
                                                             UtlMakeDelegate(this, &CMapCache::MapDownloadProgress),
                                                             UtlMakeDelegate(this, &CMapCache::MapDownloadEnd),
-                                                            pFilePath, "GAME", true);
+                                                            pFilePath, "GAME", true, pData->m_szHash);
     if (handle != INVALID_HTTPREQUEST_HANDLE)
     {
         m_mapFileDownloads.Insert(handle, pData->m_uID);
@@ -258,24 +333,33 @@ MapData *CMapCache::GetMapDataByID(uint32 uMapID)
         return m_mapMapCache.Element(indx);
     }
 
+    const auto pRecord = FindCacheRecord(uMapID);
+    if (pRecord)
+        return ReadMapFromCache(pRecord);
+
     return nullptr;
 }
 
 void CMapCache::GetMapList(CUtlVector<MapData*>& vecMaps, MapListType_e type)
 {
+    // The records tell which maps of the cache file are in the list, only those get read
+    const int iRecordCount = GetCacheRecordCount();
+    for (int i = 0; i < iRecordCount; i++)
+    {
+        const auto pRecord = GetCacheRecord(i);
+        if (IsMapInList(type, pRecord->m_iStatus, pRecord->m_uFlags & MAP_CACHE_IN_LIBRARY,
+                        pRecord->m_uFlags & MAP_CACHE_IN_FAVORITES) &&
+            !m_mapMapCache.IsValidIndex(m_mapMapCache.Find(pRecord->m_uID)))
+        {
+            ReadMapFromCache(pRecord);
+        }
+    }
+
     auto indx = m_mapMapCache.FirstInorder();
     while (indx != m_mapMapCache.InvalidIndex())
     {
         MapData *pData = m_mapMapCache[indx];
-        bool bShouldAdd = pData->m_eMapStatus == MAP_APPROVED;
-        if (type == MAP_LIST_LIBRARY)
-            bShouldAdd = pData->m_bInLibrary;
-        else if (type == MAP_LIST_FAVORITES)
-            bShouldAdd = pData->m_bInFavorites;
-        else if (type == MAP_LIST_TESTING)
-            bShouldAdd = pData->m_eMapStatus == MAP_PRIVATE_TESTING || pData->m_eMapStatus == MAP_PUBLIC_TESTING;
-
-        if (bShouldAdd)
+        if (IsMapInList(type, pData->m_eMapStatus, pData->m_bInLibrary, pData->m_bInFavorites))
             vecMaps.AddToTail(m_mapMapCache[indx]);
 
         indx = m_mapMapCache.NextInorder(indx);
@@ -304,20 +388,46 @@ bool CMapCache::AddMapsToCache(KeyValues* pData, APIModelSource source)
     return true;
 }
 
+bool CMapCache::AddMapsToCache(CUtlVector<MapData*> &vecMaps, APIModelSource source)
+{
+    if (vecMaps.IsEmpty())
+        return false;
+
+    // The cache takes over the maps
+    FOR_EACH_VEC(vecMaps, i)
+    {
+        AddMapToCache(vecMaps[i]);
+    }
+    vecMaps.RemoveAll();
+
+    if (source != MODEL_FROM_DISK)
+    {
+        FireMapCacheUpdateEvent(source);
+    }
+
+    return true;
+}
+
 void CMapCache::AddMapToCache(KeyValues* pMap, APIModelSource source)
 {
     MapData *pData = new MapData;
     pData->m_eSource = source;
     pData->FromKV(pMap);
 
-    const auto indx = m_mapMapCache.Find(pData->m_uID);
-    if (m_mapMapCache.IsValidIndex(indx))
+    AddMapToCache(pData);
+}
+
+void CMapCache::AddMapToCache(MapData *pData)
+{
+    const APIModelSource source = pData->m_eSource;
+    const auto pExisting = GetMapDataByID(pData->m_uID);
+    if (pExisting)
     {
         // Update it
-        *m_mapMapCache[indx] = *pData;
+        *pExisting = *pData;
         // Update other UI about this update if need be
-        if (m_mapMapCache[indx]->WasUpdated())
-            m_mapMapCache[indx]->SendDataUpdate();
+        if (pExisting->WasUpdated())
+            pExisting->SendDataUpdate();
 
         delete pData;
     }
@@ -400,8 +510,9 @@ void CMapCache::UpdateFetchedMaps(KeyValues *pKv, bool bIsLibrary)
             (bIsLibrary ? vecOldMaps[i]->m_bInLibrary : vecOldMaps[i]->m_bInFavorites) = false;
         }
 
-        KeyValues *pEntries = pData->FindKey(bIsLibrary ? "entries" : "favorites");
-        AddMapsToCache(pEntries, bIsLibrary ? MODEL_FROM_LIBRARY_API_CALL : MODEL_FROM_FAVORITES_API_CALL);
+        MapListResponse *pEntries = static_cast<MapListResponse *>(pData->GetPtr("model"));
+        if (pEntries)
+            AddMapsToCache(pEntries->m_vecMaps, bIsLibrary ? MODEL_FROM_LIBRARY_API_CALL : MODEL_FROM_FAVORITES_API_CALL);
 
         // Remove ones no longer in library
         FOR_EACH_VEC(vecOldMaps, i)
@@ -691,15 +802,14 @@ void CMapCache::PreLevelInit(KeyValues* pKv)
     const auto dictIndx = m_dictMapNames.Find(pMapName);
     if (m_dictMapNames.IsValidIndex(dictIndx))
     {
-        const auto mapID = m_dictMapNames[dictIndx];
-        const auto mapIndx = m_mapMapCache.Find(mapID);
-        if (m_mapMapCache.IsValidIndex(mapIndx))
+        const auto pData = GetMapDataByID(m_dictMapNames[dictIndx]);
+        if (pData)
         {
             char hash[41];
             if (MomUtil::GetFileHash(hash, sizeof(hash), pKv->GetString("file")))
             {
-                if (FStrEq(hash, m_mapMapCache[mapIndx]->m_szHash))
-                    m_pCurrentMapData = m_mapMapCache[mapIndx];
+                if (FStrEq(hash, pData->m_szHash))
+                    m_pCurrentMapData = pData;
             }
 
             // Check the update need & severity
@@ -764,15 +874,135 @@ void CMapCache::Shutdown()
     SaveMapCacheToDisk();
 }
 
+int CMapCache::GetCacheRecordCount() const
+{
+    if (!m_bufMapCache.TellPut())
+        return 0;
+
+    return static_cast<const MapCacheHeader_t *>(m_bufMapCache.Base())->m_uRecordCount;
+}
+
+const MapCacheRecord_t *CMapCache::GetCacheRecord(int iRecord) const
+{
+    const auto pRecords = reinterpret_cast<const MapCacheRecord_t *>(static_cast<const byte *>(m_bufMapCache.Base()) +
+                                                                       sizeof(MapCacheHeader_t));
+    return &pRecords[iRecord];
+}
+
+const MapCacheRecord_t *CMapCache::FindCacheRecord(uint32 uMapID) const
+{
+    int iLow = 0, iHigh = GetCacheRecordCount() - 1;
+    while (iLow <= iHigh)
+    {
+        const int iMid = (iLow + iHigh) / 2;
+        const auto pRecord = GetCacheRecord(iMid);
+        if (pRecord->m_uID == uMapID)
+            return pRecord;
+
+        if (pRecord->m_uID < uMapID)
+            iLow = iMid + 1;
+        else
+            iHigh = iMid - 1;
+    }
+
+    return nullptr;
+}
+
+const char *CMapCache::GetCacheRecordName(const MapCacheRecord_t *pRecord) const
+{
+    const auto pHeader = static_cast<const MapCacheHeader_t *>(m_bufMapCache.Base());
+    return static_cast<const char *>(m_bufMapCache.Base()) + pHeader->m_uStringTableOffset + pRecord->m_uNameOffset;
+}
+
+MapData *CMapCache::ReadMapFromCache(const MapCacheRecord_t *pRecord)
+{
+    CUtlBuffer reader(static_cast<const byte *>(m_bufMapCache.Base()) + pRecord->m_uDataOffset, pRecord->m_uDataSize,
+                      CUtlBuffer::READ_ONLY);
+
+    KeyValuesAD pMap("Map");
+    if (!pMap->ReadAsBinary(reader))
+    {
+        Warning("The map cache entry of map %u is corrupt!\n", pRecord->m_uID);
+        return nullptr;
+    }
+
+    MapData *pData = new MapData;
+    pData->m_eSource = MODEL_FROM_DISK;
+    pData->FromKV(pMap);
+    pData->ResetUpdate();
+    m_mapMapCache.Insert(pData->m_uID, pData);
+
+    return pData;
+}
+
+bool CMapCache::LoadBinaryMapCache()
+{
+    if (!g_pFullFileSystem->ReadFile(MAP_CACHE_FILE_NAME, "MOD", m_bufMapCache))
+        return false;
+
+    // Everything is used in place later on, so check all of the offsets once here
+    const uint32 uFileSize = m_bufMapCache.TellPut();
+    if (uFileSize < sizeof(MapCacheHeader_t))
+    {
+        Warning("Map cache file is corrupt, ignoring it...\n");
+        m_bufMapCache.Purge();
+        return false;
+    }
+
+    const auto pHeader = static_cast<const MapCacheHeader_t *>(m_bufMapCache.Base());
+    bool bValid = pHeader->m_uMagic == MAP_CACHE_MAGIC && pHeader->m_uVersion == MAP_CACHE_VERSION &&
+                  pHeader->m_uRecordCount <= (uFileSize - sizeof(MapCacheHeader_t)) / sizeof(MapCacheRecord_t) &&
+                  pHeader->m_uStringTableOffset >= sizeof(MapCacheHeader_t) + pHeader->m_uRecordCount * sizeof(MapCacheRecord_t) &&
+                  pHeader->m_uStringTableOffset <= uFileSize &&
+                  pHeader->m_uStringTableSize <= uFileSize - pHeader->m_uStringTableOffset &&
+                  (!pHeader->m_uStringTableSize ||
+                   !static_cast<const char *>(m_bufMapCache.Base())[pHeader->m_uStringTableOffset + pHeader->m_uStringTableSize - 1]);
+
+    if (bValid && V_strncmp(pHeader->m_szGameVersion, MOM_CURRENT_VERSION, sizeof(pHeader->m_szGameVersion)))
+    {
+        Log("Map cache file exists but is an older version, ignoring it...\n");
+        m_bufMapCache.Purge();
+        return false;
+    }
+
+    for (uint32 i = 0; bValid && i < pHeader->m_uRecordCount; i++)
+    {
+        const auto pRecord = GetCacheRecord(i);
+        bValid = pRecord->m_uNameOffset < pHeader->m_uStringTableSize && pRecord->m_uDataSize <= pRecord->m_uDataCapacity &&
+                 pRecord->m_uDataOffset <= uFileSize && pRecord->m_uDataCapacity <= uFileSize - pRecord->m_uDataOffset &&
+                 (!i || GetCacheRecord(i - 1)->m_uID < pRecord->m_uID);
+    }
+
+    if (!bValid)
+    {
+        Warning("Map cache file is corrupt, ignoring it...\n");
+        m_bufMapCache.Purge();
+        return false;
+    }
+
+    for (uint32 i = 0; i < pHeader->m_uRecordCount; i++)
+    {
+        const auto pRecord = GetCacheRecord(i);
+        m_dictMapNames.Insert(GetCacheRecordName(pRecord), pRecord->m_uID);
+    }
+
+    return true;
+}
+
 void CMapCache::LoadMapCacheFromDisk()
 {
+    if (LoadBinaryMapCache())
+        return;
+
     KeyValuesAD pMapData("MapCacheData");
     pMapData->UsesEscapeSequences(true);
-    if (pMapData->LoadFromFile(g_pFullFileSystem, MAP_CACHE_FILE_NAME, "MOD"))
+    if (pMapData->LoadFromFile(g_pFullFileSystem, MAP_CACHE_TEXT_FILE_NAME, "MOD"))
     {
         KeyValues *pVersion = pMapData->FindKey(MOM_CURRENT_VERSION);
         if (pVersion)
         {
+            // Every map is read in, the binary cache gets written in full on save
+            Log("Migrating the text map cache to the binary one...\n");
             AddMapsToCache(pVersion, MODEL_FROM_DISK);
         }
         else
@@ -786,22 +1016,179 @@ void CMapCache::LoadMapCacheFromDisk()
     }
 }
 
+struct MapCacheWrite_t
+{
+    const MapCacheRecord_t *m_pOldRecord; // Null for the maps that aren't in the cache file yet
+    MapCacheRecord_t m_Record;
+    const char *m_pName;
+    const byte *m_pData;
+    int m_iDataStart; // Into the buffer of the changed map data, until it stops growing
+};
+
+static void PutMapCachePadding(CUtlBuffer &buf, int iBytes)
+{
+    static const byte zeros[64] = {};
+    while (iBytes > 0)
+    {
+        buf.Put(zeros, MIN(iBytes, (int) sizeof(zeros)));
+        iBytes -= sizeof(zeros);
+    }
+}
+
 void CMapCache::SaveMapCacheToDisk()
 {
-    KeyValuesAD pMapData("MapCacheData");
-    pMapData->UsesEscapeSequences(true);
+    // The maps that were never read out of the cache file can't have changed. Of the read ones only the ones whose
+    // data doesn't match their record anymore get written. m_bUpdated can't tell, it gets reset when the update
+    // event for the UI fires.
+    CUtlBuffer bufChanged;
+    CUtlMap<uint32, MapCacheWrite_t> mapWrites(DefLessFunc(uint32));
+    bool bRewrite = !m_bufMapCache.TellPut();
+
+    FOR_EACH_MAP_FAST(m_mapMapCache, i)
+    {
+        const MapData *pData = m_mapMapCache[i];
+
+        MapCacheWrite_t write;
+        write.m_pOldRecord = FindCacheRecord(pData->m_uID);
+        write.m_pName = pData->m_szMapName;
+        write.m_pData = nullptr;
+        write.m_iDataStart = bufChanged.TellPut();
+        FillMapCacheRecord(pData, write.m_Record);
 
-    KeyValues *pVersion = new KeyValues(MOM_CURRENT_VERSION);
-    pMapData->AddSubKey(pVersion);
+        if (!WriteMapCacheData(pData, bufChanged))
+        {
+            Warning("Failed to write the map cache entry of map %u!\n", pData->m_uID);
+            bufChanged.SeekPut(CUtlBuffer::SEEK_HEAD, write.m_iDataStart);
+            continue;
+        }
 
-    FOR_EACH_MAP(m_mapMapCache, i)
+        write.m_Record.m_uDataSize = bufChanged.TellPut() - write.m_iDataStart;
+
+        if (write.m_pOldRecord)
+        {
+            if (write.m_pOldRecord->m_uDataSize == write.m_Record.m_uDataSize &&
+                !V_memcmp(static_cast<const byte *>(m_bufMapCache.Base()) + write.m_pOldRecord->m_uDataOffset,
+                          static_cast<const byte *>(bufChanged.Base()) + write.m_iDataStart, write.m_Record.m_uDataSize))
+            {
+                bufChanged.SeekPut(CUtlBuffer::SEEK_HEAD, write.m_iDataStart);
+                continue;
+            }
+
+            bRewrite |= write.m_Record.m_uDataSize > write.m_pOldRecord->m_uDataCapacity ||
+                        !FStrEq(GetCacheRecordName(write.m_pOldRecord), pData->m_szMapName);
+        }
+        else
+        {
+            bRewrite = true;
+        }
+
+        mapWrites.Insert(pData->m_uID, write);
+    }
+
+    if (!bRewrite && !mapWrites.Count())
+        return;
+
+    FOR_EACH_MAP_FAST(mapWrites, i)
     {
-        KeyValues *pMap = pVersion->CreateNewKey();
-        m_mapMapCache[i]->ToKV(pMap);
+        mapWrites[i].m_pData = static_cast<const byte *>(bufChanged.Base()) + mapWrites[i].m_iDataStart;
+    }
+
+    if (!bRewrite)
+    {
+        // Everything fits where it was, overwrite just the changed records and their data
+        const FileHandle_t hFile = g_pFullFileSystem->Open(MAP_CACHE_FILE_NAME, "r+b", "MOD");
+        if (hFile)
+        {
+            FOR_EACH_MAP_FAST(mapWrites, i)
+            {
+                MapCacheWrite_t &write = mapWrites[i];
+                write.m_Record.m_uNameOffset = write.m_pOldRecord->m_uNameOffset;
+                write.m_Record.m_uDataOffset = write.m_pOldRecord->m_uDataOffset;
+                write.m_Record.m_uDataCapacity = write.m_pOldRecord->m_uDataCapacity;
+
+                // Keep the loaded file matching the one on disk
+                byte *pBase = static_cast<byte *>(m_bufMapCache.Base());
+                const int iRecordPos = reinterpret_cast<const byte *>(write.m_pOldRecord) - pBase;
+                V_memcpy(pBase + iRecordPos, &write.m_Record, sizeof(MapCacheRecord_t));
+                V_memcpy(pBase + write.m_Record.m_uDataOffset, write.m_pData, write.m_Record.m_uDataSize);
+
+                g_pFullFileSystem->Seek(hFile, iRecordPos, FILESYSTEM_SEEK_HEAD);
+                g_pFullFileSystem->Write(&write.m_Record, sizeof(MapCacheRecord_t), hFile);
+                g_pFullFileSystem->Seek(hFile, write.m_Record.m_uDataOffset, FILESYSTEM_SEEK_HEAD);
+                g_pFullFileSystem->Write(write.m_pData, write.m_Record.m_uDataSize, hFile);
+            }
+
+            g_pFullFileSystem->Close(hFile);
+            return;
+        }
+
+        DevLog("Failed to open the map cache to update it, rewriting it\n");
     }
 
-    if (!pMapData->SaveToFile(g_pFullFileSystem, MAP_CACHE_FILE_NAME, "MOD"))
+    // Add the unchanged maps of the old file, everything goes out in ID order
+    const int iRecordCount = GetCacheRecordCount();
+    for (int i = 0; i < iRecordCount; i++)
+    {
+        const auto pRecord = GetCacheRecord(i);
+        if (mapWrites.IsValidIndex(mapWrites.Find(pRecord->m_uID)))
+            continue;
+
+        MapCacheWrite_t write;
+        write.m_pOldRecord = pRecord;
+        write.m_Record = *pRecord;
+        write.m_pName = GetCacheRecordName(pRecord);
+        write.m_pData = static_cast<const byte *>(m_bufMapCache.Base()) + pRecord->m_uDataOffset;
+        write.m_iDataStart = 0;
+        mapWrites.Insert(pRecord->m_uID, write);
+    }
+
+    MapCacheHeader_t header;
+    V_memset(&header, 0, sizeof(header));
+    header.m_uMagic = MAP_CACHE_MAGIC;
+    header.m_uVersion = MAP_CACHE_VERSION;
+    Q_strncpy(header.m_szGameVersion, MOM_CURRENT_VERSION, sizeof(header.m_szGameVersion));
+    header.m_uRecordCount = mapWrites.Count();
+    header.m_uStringTableOffset = sizeof(MapCacheHeader_t) + header.m_uRecordCount * sizeof(MapCacheRecord_t);
+
+    CUtlBuffer bufStrings;
+    FOR_EACH_MAP(mapWrites, i)
+    {
+        mapWrites[i].m_Record.m_uNameOffset = bufStrings.TellPut();
+        bufStrings.PutString(mapWrites[i].m_pName);
+    }
+    header.m_uStringTableSize = bufStrings.TellPut();
+
+    CUtlBuffer writer;
+    writer.Put(&header, sizeof(header));
+    // Records get filled in once the data is placed
+    PutMapCachePadding(writer, header.m_uRecordCount * sizeof(MapCacheRecord_t));
+    writer.Put(bufStrings.Base(), bufStrings.TellPut());
+
+    FOR_EACH_MAP(mapWrites, i)
+    {
+        MapCacheRecord_t &record = mapWrites[i].m_Record;
+        // Leave some room for the map to grow, so updates to it can be written in place
+        record.m_uDataOffset = writer.TellPut();
+        record.m_uDataCapacity = AlignValue(record.m_uDataSize + record.m_uDataSize / 4, 16);
+        writer.Put(mapWrites[i].m_pData, record.m_uDataSize);
+        PutMapCachePadding(writer, record.m_uDataCapacity - record.m_uDataSize);
+    }
+
+    const int iEndPos = writer.TellPut();
+    writer.SeekPut(CUtlBuffer::SEEK_HEAD, sizeof(MapCacheHeader_t));
+    FOR_EACH_MAP(mapWrites, i)
+    {
+        writer.Put(&mapWrites[i].m_Record, sizeof(MapCacheRecord_t));
+    }
+    writer.SeekPut(CUtlBuffer::SEEK_HEAD, iEndPos);
+
+    if (!g_pFullFileSystem->WriteFile(MAP_CACHE_FILE_NAME, "MOD", writer))
+    {
         DevLog("Failed to log map cache out to file\n");
+        return;
+    }
+
+    m_bufMapCache.CopyBuffer(writer);
 }
 
 CMapCache s_mapCache;
@@ -3,6 +3,7 @@
 #include "mom_api_models.h"
 #include "steam/isteamhttp.h"
 #include "IMapList.h"
+#include "utlbuffer.h"
 
 enum MapDownloadResponse
 {
@@ -13,6 +14,8 @@ enum MapDownloadResponse
     MAP_DL_WILL_OVERWRITE_EXISTING,
 };
 
+struct MapCacheRecord_t;
+
 class CMapCache : public CAutoGameSystem, public CGameEventListener
 {
 public:
@@ -40,6 +43,8 @@ public:
 
     void GetMapList(CUtlVector<MapData*> &vecMaps, MapListType_e type);
     bool AddMapsToCache(KeyValues *pData, APIModelSource source);
+    // Takes the maps out of the vector
+    bool AddMapsToCache(CUtlVector<MapData*> &vecMaps, APIModelSource source);
     void AddMapToCache(KeyValues *pMap, APIModelSource source);
     void FireMapCacheUpdateEvent(APIModelSource source);
 
@@ -59,6 +64,7 @@ protected:
     void Shutdown() OVERRIDE;
 
     void LoadMapCacheFromDisk();
+    bool LoadBinaryMapCache();
     void SaveMapCacheToDisk();
 
     void SetMapGamemode(const char *pMapName = nullptr);
@@ -82,14 +88,27 @@ protected:
     void MapDownloadEnd(KeyValues *pKvComplete);
 private:
     void UpdateFetchedMaps(KeyValues *pKv, bool bIsLibrary);
+    // Takes ownership of the map, merging it into the cached one if there is one
+    void AddMapToCache(MapData *pData);
     void ToggleMapLibraryOrFavorite(KeyValues *pKv, bool bIsLibrary, bool bAdded);
     bool StartDownloadingMap(MapData *pData);
     bool AddMapToDownloadQueue(MapData *pData);
 
+    // Binary map cache file
+    int GetCacheRecordCount() const;
+    const MapCacheRecord_t *GetCacheRecord(int iRecord) const;
+    const MapCacheRecord_t *FindCacheRecord(uint32 uMapID) const;
+    const char *GetCacheRecordName(const MapCacheRecord_t *pRecord) const;
+    MapData *ReadMapFromCache(const MapCacheRecord_t *pRecord);
+
     MapData *m_pCurrentMapData;
 
+    // The contents of the binary map cache file. Maps are only read out of it the first time they're needed,
+    // until then they only exist as their record in here.
+    CUtlBuffer m_bufMapCache;
+
     CUtlDict<uint32> m_dictMapNames;
-    CUtlMap<uint32, MapData*> m_mapMapCache;
+    CUtlMap<uint32, MapData*> m_mapMapCache; // The maps read from the cache file or added since
     CUtlMap<uint32, MapData*> m_mapQueuedDelete;
     CUtlMap<uint32, MapData*> m_mapQueuedDownload;
     CUtlMap<HTTPRequestHandle, uint32> m_mapFileDownloads;
@@ -250,76 +250,36 @@ void CBaseMapsPage::ApplyFilters(MapFilters_t filters) { OnApplyFilters(filters)
 
 void CBaseMapsPage::OnApplyFilters(MapFilters_t filters)
 {
-    // loop through all the maps checking filters
-    FOR_EACH_MAP_FAST(m_mapMaps, i)
+    CLargeVarBitVec passing;
+    m_SearchIndex.Query(filters, passing);
+
+    // Only the maps whose visibility changed need touching
+    m_VisibleMaps.Resize(passing.GetNumBits());
+    CLargeVarBitVec changed(passing.GetNumBits());
+    passing.Xor(m_VisibleMaps, &changed);
+
+    bool bShownAny = false;
+    for (int i = changed.FindNextSetBit(0); i != -1; i = changed.FindNextSetBit(i + 1))
     {
-        MapDisplay_t *pMap = &m_mapMaps[i];
-        // Now we can check the filters
-        if (!MapPassesFilters(pMap->m_pMap, filters))
-        {
-            m_pMapList->SetItemVisible(pMap->m_iListID, false);
-            pMap->m_bNeedsShown = true;
-        }
-        else if (pMap->m_bNeedsShown)
-        {
-            m_pMapList->SetItemVisible(pMap->m_iListID, true);
-            pMap->m_bNeedsShown = false;
-        }
+        MapDisplay_t *pMap = GetMapDisplayByID(m_SearchIndex.GetMapInSlot(i)->m_uID);
+        if (!pMap)
+            continue;
+
+        const bool bVisible = passing.IsBitSet(i);
+        m_pMapList->SetItemVisible(pMap->m_iListID, bVisible);
+        pMap->m_bNeedsShown = !bVisible;
+        bShownAny |= bVisible;
     }
+    passing.CopyTo(&m_VisibleMaps);
 
     UpdateStatus();
-    m_pMapList->SortList();
+    // Hiding maps keeps the rest in order, only maps coming back need sorting in
+    if (bShownAny)
+        m_pMapList->SortList();
     InvalidateLayout();
     Repaint();
 }
 
-bool CBaseMapsPage::MapPassesFilters(MapData *pMap, MapFilters_t filters)
-{
-    if (!pMap)
-        return false;
-
-    // Needs to pass map name filter
-    // compare the first few characters of the filter
-    const char *szMapNameFilter = filters.m_szMapName;
-    int count = Q_strlen(szMapNameFilter);
-
-    // strstr returns null if the substring is not in the base string
-    if (count && !Q_strstr(pMap->m_szMapName, szMapNameFilter))
-        return false;
-
-    // Difficulty
-    int iDiffLowBound = filters.m_iDifficultyLow;
-    int iDiffHighBound = filters.m_iDifficultyHigh;
-    bool bPassesLower = true;
-    bool bPassesHigher = true;
-    if (iDiffLowBound)
-    {
-        bPassesLower = pMap->m_MainTrack.m_iDifficulty >= iDiffLowBound;
-    }
-    if (iDiffHighBound)
-    {
-        bPassesHigher = pMap->m_MainTrack.m_iDifficulty <= iDiffHighBound;
-    }
-    if (!(bPassesLower && bPassesHigher))
-        return false;
-
-    // Game mode (if it's a surf/bhop/etc map or not)
-    int iGameModeFilter = filters.m_iGameMode;
-    if (iGameModeFilter && iGameModeFilter != pMap->m_eType)
-        return false;
-
-    bool bHideCompleted = filters.m_bHideCompleted;
-    if (bHideCompleted && pMap->m_PersonalBest.m_bValid)
-        return false;
-
-    // Map layout (0 = all, 1 = show staged maps only, 2 = show linear maps only)
-    int iMapLayoutFilter = filters.m_iMapLayout;
-    if (iMapLayoutFilter && pMap->m_MainTrack.m_bIsLinear + 1 != iMapLayoutFilter)
-        return false;
-
-    return true;
-}
-
 //-----------------------------------------------------------------------------
 // Purpose: Resets UI map count
 //-----------------------------------------------------------------------------
@@ -350,6 +310,7 @@ void CBaseMapsPage::AddMapToList(MapData *pData)
     map.m_pMap = pData;
     map.m_bNeedsShown = true;
     m_mapMaps.Insert(pData->m_uID, map);
+    m_SearchIndex.AddMap(pData);
 
     // Add the map to the m_pMapList
     OnMapListDataUpdate(pData->m_uID);
@@ -393,6 +354,8 @@ void CBaseMapsPage::OnMapListDataUpdate(int mapID)
     if (!pMapDisplay)
         return;
 
+    m_SearchIndex.UpdateMap(pMapDisplay->m_pMap);
+
     if (m_pMapList->IsValidItemID(pMapDisplay->m_iListID))
     {
         m_pMapList->ApplyItemChanges(pMapDisplay->m_iListID);
@@ -404,6 +367,12 @@ void CBaseMapsPage::OnMapListDataUpdate(int mapID)
         if (pData)
         {
             pMapDisplay->m_iListID = m_pMapList->AddItem(pData->m_pKv, mapID, false, false, false);
+
+            // Added items start out visible
+            const int iSlot = m_SearchIndex.GetSlot(mapID);
+            if (iSlot >= m_VisibleMaps.GetNumBits())
+                m_VisibleMaps.Resize(m_SearchIndex.GetSlotCount());
+            m_VisibleMaps.Set(iSlot);
         }
         else
         {
@@ -507,6 +476,12 @@ void CBaseMapsPage::RemoveMap(MapDisplay_t &map)
     {
         // find the row in the list and kill
         m_pMapList->RemoveItem(map.m_iListID);
+
+        const int iSlot = m_SearchIndex.GetSlot(map.m_pMap->m_uID);
+        if (iSlot != -1 && iSlot < m_VisibleMaps.GetNumBits())
+            m_VisibleMaps.Clear(iSlot);
+        m_SearchIndex.RemoveMap(map.m_pMap->m_uID);
+
         m_mapMaps.Remove(map.m_pMap->m_uID);
     }
 
@@ -519,6 +494,8 @@ void CBaseMapsPage::RemoveMap(MapDisplay_t &map)
 void CBaseMapsPage::ClearMapList()
 {
     m_mapMaps.RemoveAll();
+    m_SearchIndex.Clear();
+    m_VisibleMaps.Resize(0, true);
     m_pMapList->RemoveAll();
 }
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "IMapList.h"
+#include "MapSearchIndex.h"
 #include "vgui_controls/PropertyPage.h"
 
 class MapFilterPanel;
@@ -77,7 +78,6 @@ public:
     virtual MapFilters_t GetFilters();
     void ApplyFilters(MapFilters_t filters) OVERRIDE;
     virtual void OnApplyFilters(MapFilters_t filters);
-    virtual bool MapPassesFilters(MapData *pData, MapFilters_t filters);
 
     // Called when the Feeling Lucky button is pressed
     virtual void StartRandomMap() OVERRIDE;
@@ -121,6 +121,10 @@ protected:
 
     CUtlMap<uint32, MapDisplay_t> m_mapMaps;
 
+    // Index over m_mapMaps for the filters, and the slots of it that are visible in the list
+    CMapSearchIndex m_SearchIndex;
+    CLargeVarBitVec m_VisibleMaps;
+
 private:
     vgui::HFont m_hFont;
 
@@ -46,8 +46,8 @@ void CBrowseMaps::MapsQueryCallback(KeyValues *pKvResponse)
 
     if (pKvData)
     {
-        KeyValues *pMaps = pKvData->FindKey("maps");
-        if (g_pMapCache->AddMapsToCache(pMaps, MODEL_FROM_SEARCH_API_CALL))
+        MapListResponse *pMaps = static_cast<MapListResponse *>(pKvData->GetPtr("model"));
+        if (pMaps && g_pMapCache->AddMapsToCache(pMaps->m_vecMaps, MODEL_FROM_SEARCH_API_CALL))
         {
             GetNewMapList();
             
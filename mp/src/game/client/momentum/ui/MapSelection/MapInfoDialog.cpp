@@ -361,22 +361,22 @@ void CDialogMapInfo::ParseAPITimes(KeyValues *pKvResponse, TimeType_t type)
     KeyValues *pErr = pKvResponse->FindKey("error");
     if (pData)
     {
-        KeyValues *pRanks = pData->FindKey("ranks");
+        const RankListResponse *pRanks = static_cast<RankListResponse *>(pData->GetPtr("model"));
 
         ClearPlayerList();
 
-        if (pRanks && pData->GetInt("count") > 0)
+        if (pRanks && pRanks->m_iCount > 0)
         {
             // Iterate through each loaded run
-            FOR_EACH_SUBKEY(pRanks, pRank)
+            FOR_EACH_VEC(pRanks->m_vecRanks, i)
             {
-                KeyValuesAD kvEntry("Entry");
-
-                KeyValues *pRun = pRank->FindKey("run");
-                if (!pRun) // Should never happen but you never know...
+                const MapRank &rank = pRanks->m_vecRanks[i];
+                if (!rank.m_Run.m_bValid) // Should never happen but you never know...
                     continue;
 
-                const float fTime = pRun->GetFloat("time");
+                KeyValuesAD kvEntry("Entry");
+
+                const float fTime = rank.m_Run.m_fTime;
                 kvEntry->SetFloat("time_f", fTime);
                 char buf[BUFSIZETIME];
                 MomUtil::FormatTime(fTime, buf);
@@ -385,25 +385,19 @@ void CDialogMapInfo::ParseAPITimes(KeyValues *pKvResponse, TimeType_t type)
                 // Date
                 char timeAgoStr[64];
 
-                if (MomUtil::GetTimeAgoString(pRun->GetString("createdAt"), timeAgoStr, sizeof(timeAgoStr)))
+                if (MomUtil::GetTimeAgoString(rank.m_Run.m_szDateAchieved, timeAgoStr, sizeof(timeAgoStr)))
                     kvEntry->SetString("date", timeAgoStr);
                 else
-                    kvEntry->SetString("date", pRun->GetString("createdAt"));
+                    kvEntry->SetString("date", rank.m_Run.m_szDateAchieved);
 
-                KeyValues *kvUserObj = pRank->FindKey("user");
-                if (kvUserObj)
+                if (rank.m_User.m_szAlias[0])
                 {
-                    /*uint64 steamID = kvUserObj->GetUint64("steamID");
-                    kvEntry->SetUint64("steamid", steamID);
-
-                    int permissions = kvUserObj->GetInt("permissions");*/
-
                     // MOM_TODO: check if alias banned
-                    kvEntry->SetString("name", kvUserObj->GetString("alias"));
+                    kvEntry->SetString("name", rank.m_User.m_szAlias);
                 }
 
                 // Rank
-                kvEntry->SetInt("rank", pRank->GetInt("rank"));
+                kvEntry->SetInt("rank", rank.m_iRank);
 
                 m_pTimesList->AddItem(kvEntry, 0, false, true);
             }
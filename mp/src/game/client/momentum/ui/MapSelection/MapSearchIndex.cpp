@@ -0,0 +1,297 @@
+#include "cbase.h"
+
+#include "MapSearchIndex.h"
+#include "mom_api_models.h"
+
+#include "tier0/memdbgon.h"
+
+static inline uint32 MakeTrigram(const char *pStr)
+{
+    return (uint8(pStr[0]) << 16) | (uint8(pStr[1]) << 8) | uint8(pStr[2]);
+}
+
+CMapSearchIndex::CMapSearchIndex() : m_iCapacity(0), m_bLastQueryValid(false)
+{
+    SetDefLessFunc(m_mapSlots);
+    SetDefLessFunc(m_mapDifficultyBuckets);
+    SetDefLessFunc(m_mapGameModeBuckets);
+    SetDefLessFunc(m_mapLayoutBuckets);
+    SetDefLessFunc(m_mapTrigrams);
+}
+
+CMapSearchIndex::~CMapSearchIndex()
+{
+    Clear();
+}
+
+void CMapSearchIndex::Clear()
+{
+    m_vecSlots.Purge();
+    m_vecFreeSlots.Purge();
+    m_mapSlots.Purge();
+    m_iCapacity = 0;
+
+    m_UsedSlots.Resize(0, true);
+    m_CompletedSlots.Resize(0, true);
+    m_mapDifficultyBuckets.PurgeAndDeleteElements();
+    m_mapGameModeBuckets.PurgeAndDeleteElements();
+    m_mapLayoutBuckets.PurgeAndDeleteElements();
+    m_mapTrigrams.PurgeAndDeleteElements();
+
+    m_bLastQueryValid = false;
+}
+
+int CMapSearchIndex::GetSlot(uint32 uMapID) const
+{
+    const auto indx = m_mapSlots.Find(uMapID);
+    return m_mapSlots.IsValidIndex(indx) ? m_mapSlots[indx] : -1;
+}
+
+void CMapSearchIndex::Grow(int iMinCapacity)
+{
+    if (iMinCapacity <= m_iCapacity)
+        return;
+
+    m_iCapacity = MAX(iMinCapacity, MAX(64, m_iCapacity * 2));
+
+    m_UsedSlots.Resize(m_iCapacity);
+    m_CompletedSlots.Resize(m_iCapacity);
+    FOR_EACH_MAP_FAST(m_mapDifficultyBuckets, i)
+        m_mapDifficultyBuckets[i]->Resize(m_iCapacity);
+    FOR_EACH_MAP_FAST(m_mapGameModeBuckets, i)
+        m_mapGameModeBuckets[i]->Resize(m_iCapacity);
+    FOR_EACH_MAP_FAST(m_mapLayoutBuckets, i)
+        m_mapLayoutBuckets[i]->Resize(m_iCapacity);
+}
+
+CLargeVarBitVec *CMapSearchIndex::GetBucket(CUtlMap<int, CLargeVarBitVec *> &buckets, int key, bool bCreate)
+{
+    const auto indx = buckets.Find(key);
+    if (buckets.IsValidIndex(indx))
+        return buckets[indx];
+
+    if (!bCreate)
+        return nullptr;
+
+    CLargeVarBitVec *pBucket = new CLargeVarBitVec(m_iCapacity);
+    buckets.Insert(key, pBucket);
+    return pBucket;
+}
+
+CUtlVector<int> *CMapSearchIndex::GetTrigramSlots(uint32 uTrigram, bool bCreate)
+{
+    const auto indx = m_mapTrigrams.Find(uTrigram);
+    if (m_mapTrigrams.IsValidIndex(indx))
+        return m_mapTrigrams[indx];
+
+    if (!bCreate)
+        return nullptr;
+
+    CUtlVector<int> *pSlots = new CUtlVector<int>;
+    m_mapTrigrams.Insert(uTrigram, pSlots);
+    return pSlots;
+}
+
+void CMapSearchIndex::IndexSlot(int iSlot)
+{
+    Slot_t &slot = m_vecSlots[iSlot];
+    const MapData *pData = slot.m_pMap;
+
+    Q_strncpy(slot.m_szName, pData->m_szMapName, sizeof(slot.m_szName));
+    Q_strlower(slot.m_szName);
+    slot.m_iDifficulty = pData->m_MainTrack.m_iDifficulty;
+    slot.m_iGameMode = pData->m_eType;
+    slot.m_iLayout = pData->m_MainTrack.m_bIsLinear + 1;
+    slot.m_bCompleted = pData->m_PersonalBest.m_bValid;
+
+    m_UsedSlots.Set(iSlot);
+    m_CompletedSlots.Set(iSlot, slot.m_bCompleted);
+    GetBucket(m_mapDifficultyBuckets, slot.m_iDifficulty, true)->Set(iSlot);
+    GetBucket(m_mapGameModeBuckets, slot.m_iGameMode, true)->Set(iSlot);
+    GetBucket(m_mapLayoutBuckets, slot.m_iLayout, true)->Set(iSlot);
+
+    const int len = Q_strlen(slot.m_szName);
+    for (int i = 0; i + 3 <= len; i++)
+    {
+        CUtlVector<int> *pSlots = GetTrigramSlots(MakeTrigram(slot.m_szName + i), true);
+        // Names repeating a trigram only go in once, keeping the slots sorted
+        int insertAt = pSlots->Count();
+        while (insertAt > 0 && pSlots->Element(insertAt - 1) > iSlot)
+            insertAt--;
+        if (insertAt == 0 || pSlots->Element(insertAt - 1) != iSlot)
+            pSlots->InsertBefore(insertAt, iSlot);
+    }
+}
+
+void CMapSearchIndex::UnindexSlot(int iSlot)
+{
+    const Slot_t &slot = m_vecSlots[iSlot];
+
+    m_UsedSlots.Clear(iSlot);
+    m_CompletedSlots.Clear(iSlot);
+    GetBucket(m_mapDifficultyBuckets, slot.m_iDifficulty, false)->Clear(iSlot);
+    GetBucket(m_mapGameModeBuckets, slot.m_iGameMode, false)->Clear(iSlot);
+    GetBucket(m_mapLayoutBuckets, slot.m_iLayout, false)->Clear(iSlot);
+
+    const int len = Q_strlen(slot.m_szName);
+    for (int i = 0; i + 3 <= len; i++)
+    {
+        CUtlVector<int> *pSlots = GetTrigramSlots(MakeTrigram(slot.m_szName + i), false);
+        if (pSlots)
+            pSlots->FindAndRemove(iSlot);
+    }
+}
+
+void CMapSearchIndex::AddMap(MapData *pData)
+{
+    if (GetSlot(pData->m_uID) != -1)
+    {
+        UpdateMap(pData);
+        return;
+    }
+
+    int iSlot;
+    if (m_vecFreeSlots.Count())
+    {
+        iSlot = m_vecFreeSlots.Tail();
+        m_vecFreeSlots.RemoveMultipleFromTail(1);
+    }
+    else
+    {
+        iSlot = m_vecSlots.AddToTail();
+        Grow(m_vecSlots.Count());
+    }
+
+    m_vecSlots[iSlot].m_pMap = pData;
+    m_mapSlots.Insert(pData->m_uID, iSlot);
+    IndexSlot(iSlot);
+
+    m_bLastQueryValid = false;
+}
+
+void CMapSearchIndex::UpdateMap(MapData *pData)
+{
+    const int iSlot = GetSlot(pData->m_uID);
+    if (iSlot == -1)
+        return;
+
+    UnindexSlot(iSlot);
+    m_vecSlots[iSlot].m_pMap = pData;
+    IndexSlot(iSlot);
+
+    m_bLastQueryValid = false;
+}
+
+void CMapSearchIndex::RemoveMap(uint32 uMapID)
+{
+    const auto indx = m_mapSlots.Find(uMapID);
+    if (!m_mapSlots.IsValidIndex(indx))
+        return;
+
+    const int iSlot = m_mapSlots[indx];
+    UnindexSlot(iSlot);
+    m_vecSlots[iSlot].m_pMap = nullptr;
+    m_vecFreeSlots.AddToTail(iSlot);
+    m_mapSlots.RemoveAt(indx);
+
+    m_bLastQueryValid = false;
+}
+
+void CMapSearchIndex::Query(const MapFilters_t &filters, CLargeVarBitVec &result)
+{
+    char szName[MAX_MAP_NAME];
+    Q_strncpy(szName, filters.m_szMapName, sizeof(szName));
+    Q_strlower(szName);
+    const int len = Q_strlen(szName);
+
+    const bool bNarrow = m_bLastQueryValid && filters.m_iDifficultyLow == m_LastFilters.m_iDifficultyLow &&
+                         filters.m_iDifficultyHigh == m_LastFilters.m_iDifficultyHigh &&
+                         filters.m_iGameMode == m_LastFilters.m_iGameMode &&
+                         filters.m_iMapLayout == m_LastFilters.m_iMapLayout &&
+                         filters.m_bHideCompleted == m_LastFilters.m_bHideCompleted &&
+                         Q_strstr(szName, m_LastFilters.m_szMapName);
+
+    if (bNarrow)
+    {
+        m_LastResult.CopyTo(&result);
+    }
+    else
+    {
+        m_UsedSlots.CopyTo(&result);
+        CLargeVarBitVec temp(m_iCapacity);
+
+        if (filters.m_iDifficultyLow || filters.m_iDifficultyHigh)
+        {
+            FOR_EACH_MAP_FAST(m_mapDifficultyBuckets, i)
+            {
+                const int difficulty = m_mapDifficultyBuckets.Key(i);
+                if ((!filters.m_iDifficultyLow || difficulty >= filters.m_iDifficultyLow) &&
+                    (!filters.m_iDifficultyHigh || difficulty <= filters.m_iDifficultyHigh))
+                {
+                    temp.Or(*m_mapDifficultyBuckets[i], &temp);
+                }
+            }
+            result.And(temp, &result);
+        }
+
+        if (filters.m_iGameMode)
+        {
+            const auto pBucket = GetBucket(m_mapGameModeBuckets, filters.m_iGameMode, false);
+            if (pBucket)
+                result.And(*pBucket, &result);
+            else
+                result.ClearAll();
+        }
+
+        if (filters.m_iMapLayout)
+        {
+            const auto pBucket = GetBucket(m_mapLayoutBuckets, filters.m_iMapLayout, false);
+            if (pBucket)
+                result.And(*pBucket, &result);
+            else
+                result.ClearAll();
+        }
+
+        if (filters.m_bHideCompleted)
+        {
+            m_CompletedSlots.Not(&temp);
+            result.And(temp, &result);
+        }
+
+        // The rarest trigram of the name filter narrows the maps down the most, the rest get checked below
+        if (len >= 3)
+        {
+            const CUtlVector<int> *pRarest = nullptr;
+            for (int i = 0; i + 3 <= len; i++)
+            {
+                const CUtlVector<int> *pSlots = GetTrigramSlots(MakeTrigram(szName + i), false);
+                if (!pRarest || !pSlots || pSlots->Count() < pRarest->Count())
+                    pRarest = pSlots;
+                if (!pRarest)
+                    break;
+            }
+
+            temp.ClearAll();
+            if (pRarest)
+            {
+                FOR_EACH_VEC(*pRarest, i)
+                    temp.Set(pRarest->Element(i));
+            }
+            result.And(temp, &result);
+        }
+    }
+
+    if (len)
+    {
+        for (int i = result.FindNextSetBit(0); i != -1; i = result.FindNextSetBit(i + 1))
+        {
+            if (!Q_strstr(m_vecSlots[i].m_szName, szName))
+                result.Clear(i);
+        }
+    }
+
+    m_LastFilters = filters;
+    Q_strncpy(m_LastFilters.m_szMapName, szName, sizeof(m_LastFilters.m_szMapName));
+    result.CopyTo(&m_LastResult);
+    m_bLastQueryValid = true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "bitvec.h"
+#include "IMapList.h"
+
+// In-memory index over the maps of a map list, so applying the filters doesn't check every map against every filter.
+// Map names are indexed by their trigrams, difficulty, gamemode, layout and completion by buckets of maps.
+// Every map lives in a slot, query results are bitsets over the slots.
+class CMapSearchIndex
+{
+  public:
+    CMapSearchIndex();
+    ~CMapSearchIndex();
+
+    void AddMap(MapData *pData);
+    // Re-indexes a map whose data changed
+    void UpdateMap(MapData *pData);
+    void RemoveMap(uint32 uMapID);
+    void Clear();
+
+    // Sets the slots of the maps that pass the filters. If only the name filter grew since the last query,
+    // the previous result gets narrowed down instead of starting over.
+    void Query(const MapFilters_t &filters, CLargeVarBitVec &result);
+
+    // Slots are stable for as long as the map is in the index
+    int GetSlot(uint32 uMapID) const;
+    int GetSlotCount() const { return m_iCapacity; }
+    MapData *GetMapInSlot(int iSlot) const { return m_vecSlots[iSlot].m_pMap; }
+
+  private:
+    struct Slot_t
+    {
+        MapData *m_pMap;
+        char m_szName[MAX_MAP_NAME]; // Lowercase
+        int m_iDifficulty;
+        int m_iGameMode;
+        int m_iLayout;
+        bool m_bCompleted;
+    };
+
+    void IndexSlot(int iSlot);
+    void UnindexSlot(int iSlot);
+    void Grow(int iMinCapacity);
+
+    CLargeVarBitVec *GetBucket(CUtlMap<int, CLargeVarBitVec *> &buckets, int key, bool bCreate);
+    CUtlVector<int> *GetTrigramSlots(uint32 uTrigram, bool bCreate);
+
+    CUtlVector<Slot_t> m_vecSlots;
+    CUtlVector<int> m_vecFreeSlots;
+    CUtlMap<uint32, int> m_mapSlots; // Map ID -> slot
+    int m_iCapacity;                 // Size of every bitset
+
+    CLargeVarBitVec m_UsedSlots;
+    CLargeVarBitVec m_CompletedSlots;
+    CUtlMap<int, CLargeVarBitVec *> m_mapDifficultyBuckets;
+    CUtlMap<int, CLargeVarBitVec *> m_mapGameModeBuckets;
+    CUtlMap<int, CLargeVarBitVec *> m_mapLayoutBuckets;
+    CUtlMap<uint32, CUtlVector<int> *> m_mapTrigrams; // Trigram -> sorted slots of the names containing it
+
+    // The last query, for narrowing it down
+    bool m_bLastQueryValid;
+    MapFilters_t m_LastFilters;
+    CLargeVarBitVec m_LastResult;
+};
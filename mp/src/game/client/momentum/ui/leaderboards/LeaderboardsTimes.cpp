@@ -20,7 +20,7 @@
 #include "run/mom_replay_base.h"
 #include "mom_map_cache.h"
 #include "mom_api_requests.h"
-#include "run/mom_replay_factory.h"
+#include "run/mom_replay_index.h"
 #include "filesystem.h"
 #include "fmtstr.h"
 #include "mom_system_gamemode.h"
@@ -355,29 +355,17 @@ void CLeaderboardsTimes::LoadLocalTimes(KeyValues* kv)
         // Clear the local times for a refresh
         m_vLocalTimes.PurgeAndDeleteElements();
 
-        char path[MAX_PATH];
-        Q_snprintf(path, MAX_PATH, "%s/%s-*%s", RECORDING_PATH, g_pGameRules->MapName(), EXT_RECORDING_FILE);
-        V_FixSlashes(path);
-
-        FileFindHandle_t found;
-        const char *pFoundFile = filesystem->FindFirstEx(path, "MOD", &found);
-        while (pFoundFile)
+        const auto &replays = g_ReplayIndex.GetMapReplays(g_pGameRules->MapName());
+        FOR_EACH_DICT_FAST(replays, i)
         {
             // NOTE: THIS NEEDS TO BE MANUALLY CLEANED UP!
-            char pReplayPath[MAX_PATH];
-            V_ComposeFileName(RECORDING_PATH, pFoundFile, pReplayPath, MAX_PATH);
-
-            CMomReplayBase *pBase = g_ReplayFactory.LoadReplayFile(pReplayPath, false);
+            CMomReplayBase *pBase = replays[i]->CreateReplay();
             Assert(pBase != nullptr);
 
             if (pBase)
                 m_vLocalTimes.InsertNoSort(pBase);
-
-            pFoundFile = filesystem->FindNext(found);
         }
 
-        filesystem->FindClose(found);
-
         if (!m_vLocalTimes.IsEmpty())
         {
             m_vLocalTimes.RedoSort();
@@ -685,78 +673,76 @@ void CLeaderboardsTimes::ParseTimesCallback(KeyValues* pKv, TimeType_t type)
     KeyValues *pErr = pKv->FindKey("error");
     if (pData)
     {
-        KeyValues *pRanks = pData->FindKey("ranks");
+        const RankListResponse *pRanks = static_cast<RankListResponse *>(pData->GetPtr("model"));
 
-        if (pRanks && pData->GetInt("count") > 0)
+        if (pRanks && pRanks->m_iCount > 0)
         {
             CUtlVector<TimeOnline*> *vecs[] = { nullptr, &m_vOnlineTimes, &m_vFriendsTimes, &m_vAroundTimes };
             // By now we're pretty sure everything will be ok, so we can do this
             vecs[type]->PurgeAndDeleteElements();
 
             // Iterate through each loaded run
-            FOR_EACH_SUBKEY(pRanks, pRank)
+            FOR_EACH_VEC(pRanks->m_vecRanks, i)
             {
-                KeyValues *kvEntry = new KeyValues("Entry");
-
-                KeyValues *pRun = pRank->FindKey("run");
-                if (!pRun) // Should never happen but you never know...
+                const MapRank &rank = pRanks->m_vecRanks[i];
+                if (!rank.m_Run.m_bValid) // Should never happen but you never know...
                     continue;
 
+                const Run &run = rank.m_Run;
+                KeyValues *kvEntry = new KeyValues("Entry");
+
                 // Time
-                kvEntry->SetFloat("time", pRun->GetFloat("time"));
+                kvEntry->SetFloat("time", run.m_fTime);
                 // Format the time as well
                 char timeString[BUFSIZETIME];
-                MomUtil::FormatTime(pRun->GetFloat("time"), timeString);
+                MomUtil::FormatTime(run.m_fTime, timeString);
                 kvEntry->SetString("time_f", timeString);
 
                 // Tickrate
-                kvEntry->SetFloat("rate", pRun->GetFloat("tickRate"));
+                kvEntry->SetFloat("rate", run.m_fTickRate);
 
                 // Date
                 char timeAgoStr[64];
-                if (MomUtil::GetTimeAgoString(pRun->GetString("createdAt"), timeAgoStr, sizeof(timeAgoStr)))
+                if (MomUtil::GetTimeAgoString(run.m_szDateAchieved, timeAgoStr, sizeof(timeAgoStr)))
                     kvEntry->SetString("date", timeAgoStr);
                 else
-                    kvEntry->SetString("date", pRun->GetString("createdAt"));
+                    kvEntry->SetString("date", run.m_szDateAchieved);
 
                 // ID
-                kvEntry->SetUint64("id", pRun->GetUint64("id"));
+                kvEntry->SetUint64("id", run.m_uID);
 
                 // File
-                kvEntry->SetString("file", pRun->GetString("file"));
+                kvEntry->SetString("file", run.m_szDownloadURL);
 
                 // Hash
-                kvEntry->SetString("hash", pRun->GetString("hash"));
+                kvEntry->SetString("hash", run.m_szFileHash);
 
-                KeyValues *kvUserObj = pRank->FindKey("user");
-                if (kvUserObj)
+                const User &user = rank.m_User;
+                if (user.m_uSteamID)
                 {
-                    uint64 steamID = kvUserObj->GetUint64("steamID");
+                    const uint64 steamID = user.m_uSteamID;
                     kvEntry->SetUint64("steamid", steamID);
 
-                    const auto roles = kvUserObj->GetInt("roles");
-                    const auto bans = kvUserObj->GetInt("bans");
-
                     // Is part of the momentum team?
                     // MOM_TODO: Make this the actual permission
-                    kvEntry->SetBool("tm", roles & (USER_ADMIN | USER_MODERATOR));
+                    kvEntry->SetBool("tm", user.m_iRoles & (USER_ADMIN | USER_MODERATOR));
 
                     // Is vip?
                     // MOM_TODO: Make this the actual permission
-                    kvEntry->SetBool("vip", pRun->GetBool("vip"));
+                    kvEntry->SetBool("vip", run.m_bVIP);
 
                     // MOM_TODO Set an icon for the map creator?
 
-                    kvEntry->SetString("personaname", kvUserObj->GetString("alias"));
+                    kvEntry->SetString("personaname", user.m_szAlias);
 
-                    const auto bAvatarBanned = bans & USER_BANNED_AVATAR;
+                    const auto bAvatarBanned = user.m_iBans & USER_BANNED_AVATAR;
                     kvEntry->SetInt("avatar", bAvatarBanned ? ICON_DEFAULT_AVATAR : TryAddAvatar(steamID, &m_mapAvatarsToImageList, m_pImageList));
 
                     kvEntry->SetBool("is_friend", SteamFriends()->HasFriend(CSteamID(steamID), k_EFriendFlagImmediate));
                 }
 
                 // Rank
-                kvEntry->SetInt("rank", pRank->GetInt("rank"));
+                kvEntry->SetInt("rank", rank.m_iRank);
 
                 // Add this baby to the online times vector
                 vecs[type]->AddToTail(new TimeOnline(kvEntry));
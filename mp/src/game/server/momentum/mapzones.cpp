@@ -7,9 +7,14 @@
 #include "fmtstr.h"
 #include "mom_system_gamemode.h"
 #include "mom_system_tricks.h"
+#include "util/mom_util.h"
+#include "utlbuffer.h"
 
 #include "tier0/memdbgon.h"
 
+#define ZONE_CACHE_MAGIC 0x435A4D4D // "MMZC"
+#define ZONE_CACHE_VERSION 1
+
 CON_COMMAND_F(mom_zone_generate, "Generates the .zon file for map zones.", FCVAR_MAPPING)
 {
     if (g_pGameModeSystem->GameModeIs(GAMEMODE_TRICKSURF))
@@ -28,9 +33,17 @@ class CMapZone
     CMapZone(int track, int zone, int type, const KeyValues *values);
     ~CMapZone();
 
+    // Spawns the zone trigger. Zones read from the zone cache restore their decomposed collision
+    // instead of building it from the points again.
     void SpawnZone();
 
+    // Writes this zone to/reads it from the zone cache
+    void WriteToCache(CUtlBuffer &buf);
+    static CMapZone *ReadFromCache(CUtlBuffer &buf);
+
     int GetType() const { return m_iType; }
+    int GetTrack() const { return m_iTrack; }
+    int GetZone() const { return m_iZone; }
 
   private:
     int m_iType;
@@ -38,6 +51,8 @@ class CMapZone
     int m_iZone; // Zone number
     // KeyValues containing all the values describing the zone
     KeyValues *m_pZoneValues;
+    // Output of the point zone builder, empty for box zones
+    CUtlBuffer m_BuiltZone;
 
     CBaseMomZoneTrigger *m_pTrigger;
 };
@@ -77,8 +92,31 @@ void CMapZone::SpawnZone()
         m_pTrigger->SetTrackNumber(m_iTrack);
 
         CMomBaseZoneBuilder* pBaseBuilder = CreateZoneBuilderFromKeyValues(m_pZoneValues);
+        const auto pPointBuilder = dynamic_cast<CMomPointZoneBuilder *>(pBaseBuilder);
+
+        bool bRestored = false;
+        if (pPointBuilder && m_BuiltZone.TellPut() > 0)
+        {
+            m_BuiltZone.SeekGet(CUtlBuffer::SEEK_HEAD, 0);
+            bRestored = pPointBuilder->ReadBuiltZone(m_BuiltZone);
+
+            // Reading wipes the builder, give it its points back to build from
+            if (!bRestored)
+            {
+                pPointBuilder->Reset();
+                pPointBuilder->Load(m_pZoneValues);
+            }
+        }
+
+        if (!bRestored)
+        {
+            pBaseBuilder->BuildZone();
+
+            m_BuiltZone.Purge();
+            if (pPointBuilder)
+                pPointBuilder->WriteBuiltZone(m_BuiltZone);
+        }
 
-        pBaseBuilder->BuildZone();
         m_pTrigger->Spawn();
         pBaseBuilder->FinishZone(m_pTrigger);
 
@@ -88,6 +126,37 @@ void CMapZone::SpawnZone()
     }
 }
 
+void CMapZone::WriteToCache(CUtlBuffer &buf)
+{
+    buf.PutInt(m_iTrack);
+    buf.PutInt(m_iZone);
+    buf.PutInt(m_iType);
+    m_pZoneValues->WriteAsBinary(buf);
+    buf.PutInt(m_BuiltZone.TellPut());
+    buf.Put(m_BuiltZone.Base(), m_BuiltZone.TellPut());
+}
+
+CMapZone *CMapZone::ReadFromCache(CUtlBuffer &buf)
+{
+    const int track = buf.GetInt();
+    const int zone = buf.GetInt();
+    const int type = buf.GetInt();
+
+    KeyValuesAD pKvZone("");
+    if (!buf.IsValid() || !pKvZone->ReadAsBinary(buf))
+        return nullptr;
+
+    const int builtSize = buf.GetInt();
+    if (!buf.IsValid() || builtSize < 0 || builtSize > buf.GetBytesRemaining())
+        return nullptr;
+
+    const auto pZone = new CMapZone(track, zone, type, pKvZone);
+    pZone->m_BuiltZone.Put(buf.PeekGet(), builtSize);
+    buf.SeekGet(CUtlBuffer::SEEK_CURRENT, builtSize);
+
+    return pZone;
+}
+
 CMapZoneSystem::CMapZoneSystem() : CAutoGameSystemPerFrame("CMapZoneSystem"), m_iLinearTracks(0), m_iHighestTrackNum(0)
 {
     m_bLoadedFromSite = false;
@@ -163,7 +232,23 @@ void CMapZoneSystem::ClearMapZones()
 
 void CMapZoneSystem::LoadZonesFromSite(KeyValues *pKvTracks, CBaseEntity *pEnt)
 {
-    if (LoadZonesFromKeyValues(pKvTracks, true))
+    if (!pKvTracks || pKvTracks->IsEmpty())
+        return;
+
+    // Site zones don't come from a file, so they're keyed by the hash of their data instead
+    char zoneHash[41];
+    CUtlBuffer zoneData;
+    const bool bHashed = pKvTracks->WriteAsBinary(zoneData) && MomUtil::GetSHA1Hash(zoneData, zoneHash, sizeof(zoneHash));
+
+    bool bLoaded = bHashed && LoadZonesFromCache(zoneHash);
+    if (!bLoaded)
+    {
+        bLoaded = LoadZonesFromKeyValues(pKvTracks, true);
+        if (bLoaded && bHashed)
+            SaveZoneCache(zoneHash);
+    }
+
+    if (bLoaded)
     {
         m_bLoadedFromSite = true;
         const auto pPlayer = dynamic_cast<CMomentumPlayer*>(pEnt);
@@ -182,11 +267,22 @@ void CMapZoneSystem::LoadZonesFromFile()
     V_SetExtension(zoneFilePath, EXT_ZONE_FILE, MAX_PATH);
     DevLog("Looking for zone file: %s \n", zoneFilePath);
 
+    char zoneHash[41];
+    const bool bHashed = MomUtil::GetFileHash(zoneHash, sizeof(zoneHash), zoneFilePath, "GAME");
+    if (bHashed && LoadZonesFromCache(zoneHash))
+    {
+        DevLog("Successfully loaded map zones for %s from the zone cache!\n", zoneFilePath);
+        return;
+    }
+
     KeyValuesAD fileKV("tracks");
     if (fileKV->LoadFromFile(filesystem, zoneFilePath, "GAME"))
     {
         const auto bSuccess = LoadZonesFromKeyValues(fileKV, false);
         DevLog("%s map zone file %s!\n", bSuccess ? "Successfully loaded" : "Failed to load", zoneFilePath);
+
+        if (bSuccess && bHashed)
+            SaveZoneCache(zoneHash);
     }
 }
 
@@ -224,33 +320,48 @@ bool CMapZoneSystem::LoadZonesFromKeyValues(KeyValues *pKvTracks, bool bFromSite
                             continue;
                         }
 
-                        if (zoneType != ZONE_TYPE_STOP)
-                        {
-                            if (trackNum > -1 && trackNum < MAX_TRACKS)
-                            {
-                                if (trackNum > m_iHighestTrackNum)
-                                    m_iHighestTrackNum = trackNum;
-
-                                if (zoneNum > m_iZoneCount[trackNum])
-                                    m_iZoneCount[trackNum] = zoneNum;
-
-                                if (zoneType == ZONE_TYPE_CHECKPOINT)
-                                    m_iLinearTracks |= (1ULL << trackNum);
-                            }
-                            else if (trackNum == -1)
-                                globalZones++;
-                        }
-
-                        // Add element
-                        auto pMapZone = new CMapZone(trackNum, zoneNum, zoneType, triggerKV);
-                        pMapZone->SpawnZone();
-                        m_Zones.AddToTail(pMapZone);
+                        AddMapZone(new CMapZone(trackNum, zoneNum, zoneType, triggerKV), globalZones);
                     }
                 }
             }
         }
     }
 
+    AddGlobalZoneCounts(globalZones);
+
+    return !m_Zones.IsEmpty();
+}
+
+void CMapZoneSystem::AddMapZone(CMapZone *pMapZone, int &globalZones)
+{
+    const auto trackNum = pMapZone->GetTrack();
+    const auto zoneNum = pMapZone->GetZone();
+    const auto zoneType = pMapZone->GetType();
+
+    if (zoneType != ZONE_TYPE_STOP)
+    {
+        if (trackNum > -1 && trackNum < MAX_TRACKS)
+        {
+            if (trackNum > m_iHighestTrackNum)
+                m_iHighestTrackNum = trackNum;
+
+            if (zoneNum > m_iZoneCount[trackNum])
+                m_iZoneCount[trackNum] = zoneNum;
+
+            if (zoneType == ZONE_TYPE_CHECKPOINT)
+                m_iLinearTracks |= (1ULL << trackNum);
+        }
+        else if (trackNum == -1)
+            globalZones++;
+    }
+
+    // Add element
+    pMapZone->SpawnZone();
+    m_Zones.AddToTail(pMapZone);
+}
+
+void CMapZoneSystem::AddGlobalZoneCounts(int globalZones)
+{
     // Add in all the global zones, if we have any
     if (globalZones)
     {
@@ -259,8 +370,81 @@ bool CMapZoneSystem::LoadZonesFromKeyValues(KeyValues *pKvTracks, bool bFromSite
             m_iZoneCount[i] += globalZones;
         }
     }
+}
 
-    return !m_Zones.IsEmpty();
+void CMapZoneSystem::GetZoneCacheFilePath(char *pOut, int outSize)
+{
+    V_ComposeFileName(ZONE_FOLDER, gpGlobals->mapname.ToCStr(), pOut, outSize);
+    V_SetExtension(pOut, EXT_ZONE_CACHE_FILE, outSize);
+}
+
+bool CMapZoneSystem::LoadZonesFromCache(const char *pSourceHash)
+{
+    char cachePath[MAX_PATH];
+    GetZoneCacheFilePath(cachePath, MAX_PATH);
+
+    CUtlBuffer reader;
+    if (!filesystem->ReadFile(cachePath, "MOD", reader))
+        return false;
+
+    if (reader.GetUnsignedInt() != ZONE_CACHE_MAGIC || reader.GetUnsignedChar() != ZONE_CACHE_VERSION)
+        return false;
+
+    char cachedHash[41];
+    reader.GetString(cachedHash);
+    if (!FStrEq(cachedHash, pSourceHash))
+        return false;
+
+    // Read everything before spawning anything, a corrupt cache falls back to the zone data
+    CUtlVector<CMapZone *> cachedZones;
+    const int count = reader.GetInt();
+    for (int i = 0; i < count && reader.IsValid(); ++i)
+    {
+        const auto pZone = CMapZone::ReadFromCache(reader);
+        if (!pZone)
+            break;
+
+        cachedZones.AddToTail(pZone);
+    }
+
+    if (!reader.IsValid() || cachedZones.Count() != count || !count)
+    {
+        Warning("Zone cache %s is corrupt, rebuilding it...\n", cachePath);
+        cachedZones.PurgeAndDeleteElements();
+        return false;
+    }
+
+    ResetCounts();
+    int globalZones = 0;
+
+    FOR_EACH_VEC(cachedZones, i)
+    {
+        AddMapZone(cachedZones[i], globalZones);
+    }
+
+    AddGlobalZoneCounts(globalZones);
+
+    return true;
+}
+
+void CMapZoneSystem::SaveZoneCache(const char *pSourceHash)
+{
+    char cachePath[MAX_PATH];
+    GetZoneCacheFilePath(cachePath, MAX_PATH);
+
+    CUtlBuffer writer;
+    writer.PutUnsignedInt(ZONE_CACHE_MAGIC);
+    writer.PutUnsignedChar(ZONE_CACHE_VERSION);
+    writer.PutString(pSourceHash);
+    writer.PutInt(m_Zones.Count());
+
+    FOR_EACH_VEC(m_Zones, i)
+    {
+        m_Zones[i]->WriteToCache(writer);
+    }
+
+    if (!filesystem->WriteFile(cachePath, "MOD", writer))
+        Warning("Failed to write the zone cache %s!\n", cachePath);
 }
 
 void CMapZoneSystem::SaveZoneTrigger(CBaseMomZoneTrigger *pZoneTrigger, KeyValues *pKvInto)
@@ -41,6 +41,16 @@ public:
 private:
     void ResetCounts();
 
+    // Counts and spawns the zone, taking ownership of it
+    void AddMapZone(CMapZone *pMapZone, int &globalZones);
+    void AddGlobalZoneCounts(int globalZones);
+
+    // The zone cache (zones/<map>.zonc) stores the zones along with their already decomposed collision,
+    // keyed by the hash of the zone data it was built from
+    void GetZoneCacheFilePath(char *pOut, int outSize);
+    bool LoadZonesFromCache(const char *pSourceHash);
+    void SaveZoneCache(const char *pSourceHash);
+
     bool m_bLoadedFromSite;
     CMapZoneEdit m_Editor;
     CUtlVector<CMapZone*> m_Zones;
@@ -3,6 +3,7 @@
 #include "mom_triggers.h"
 #include "mapzones_build.h"
 #include "fmtstr.h"
+#include "utlbuffer.h"
 
 #include "tier0/memdbgon.h"
 
@@ -489,6 +490,57 @@ bool CMomPointZoneBuilder::Save(KeyValues *pTriggerKV)
     return true;
 }
 
+bool CMomPointZoneBuilder::WriteBuiltZone(CUtlBuffer &buf)
+{
+    if (!m_pPhysCollide)
+        return false;
+
+    const int collideSize = physcollision->CollideSize(m_pPhysCollide);
+    if (collideSize <= 0)
+        return false;
+
+    // BuildZone may have moved the points down for negative heights, so the built points are stored as well
+    buf.PutFloat(m_flHeight);
+    buf.PutInt(m_vPoints.Count());
+    buf.Put(m_vPoints.Base(), m_vPoints.Count() * sizeof(Vector));
+    buf.Put(&m_vecCenter, sizeof(Vector));
+    buf.Put(&m_vecMins, sizeof(Vector));
+    buf.Put(&m_vecMaxs, sizeof(Vector));
+
+    buf.PutInt(collideSize);
+    buf.EnsureCapacity(buf.TellPut() + collideSize);
+    physcollision->CollideWrite(static_cast<char *>(buf.PeekPut()), m_pPhysCollide);
+    buf.SeekPut(CUtlBuffer::SEEK_CURRENT, collideSize);
+
+    return buf.IsValid();
+}
+
+bool CMomPointZoneBuilder::ReadBuiltZone(CUtlBuffer &buf)
+{
+    ResetMe();
+
+    m_flHeight = buf.GetFloat();
+    const int nPoints = buf.GetInt();
+    if (!buf.IsValid() || nPoints < 3 || nPoints * static_cast<int>(sizeof(Vector)) > buf.GetBytesRemaining())
+        return false;
+
+    m_vPoints.SetCount(nPoints);
+    buf.Get(m_vPoints.Base(), nPoints * sizeof(Vector));
+    buf.Get(&m_vecCenter, sizeof(Vector));
+    buf.Get(&m_vecMins, sizeof(Vector));
+    buf.Get(&m_vecMaxs, sizeof(Vector));
+
+    const int collideSize = buf.GetInt();
+    if (!buf.IsValid() || collideSize <= 0 || collideSize > buf.GetBytesRemaining())
+        return false;
+
+    m_pPhysCollide = physcollision->UnserializeCollide(static_cast<char *>(const_cast<void *>(buf.PeekGet())), collideSize, 0);
+    buf.SeekGet(CUtlBuffer::SEEK_CURRENT, collideSize);
+    m_bFreePhysCollide = true;
+
+    return m_pPhysCollide != nullptr;
+}
+
 int CMomPointZoneBuilder::GetSelectedPoint(const Vector &pos, const Vector &fwd) const
 {
     // We have to be looking fairly close to the point
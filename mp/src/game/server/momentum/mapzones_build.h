@@ -1,6 +1,7 @@
 #pragma once
 
 class CBaseMomZoneTrigger;
+class CUtlBuffer;
 
 // These are used for convenience-sake, only allocating once.
 
@@ -112,6 +113,11 @@ public:
 
 
 
+    // Writes/reads the result of BuildZone (decomposed collision, center and bounds) so it can be
+    // restored later without decomposing the points again
+    bool WriteBuiltZone(CUtlBuffer &buf);
+    bool ReadBuiltZone(CUtlBuffer &buf);
+
     const CUtlVector<Vector>&   GetPoints() const { return m_vPoints; }
     void                        CopyPoints(const CUtlVector<Vector>& vec);
 
@@ -0,0 +1,100 @@
+#include "cbase.h"
+
+#include "mom_ghost_jitter_buffer.h"
+
+#include "tier0/memdbgon.h"
+
+COMPILE_TIME_ASSERT((GHOST_JITTER_BUFFER_SIZE & (GHOST_JITTER_BUFFER_SIZE - 1)) == 0);
+
+// Arrivals further off the expected time than this restart the timestamps (lag spike, the other player stalled)
+#define JITTER_RESYNC_TIME 0.25
+// How far each arrival pulls the timestamps and the send interval estimate towards it
+#define JITTER_SMOOTHING 0.1
+// Above this the movement between two packets is taken as a teleport, which doesn't get interpolated
+#define JITTER_TELEPORT_SPEED 10000.0f
+
+CGhostJitterBuffer::CGhostJitterBuffer() : m_iWrite(0), m_iRead(0), m_flLastRecvTime(0.0), m_flLastStamp(0.0),
+    m_flSendInterval(0.0)
+{
+}
+
+void CGhostJitterBuffer::Push(const PositionPacket &packet, double flRecvTime)
+{
+    const int iWrite = m_iWrite;
+    if (iWrite - m_iRead >= GHOST_JITTER_BUFFER_SIZE)
+        return;
+
+    double flStamp = flRecvTime;
+    if (m_flSendInterval > 0.0)
+    {
+        const double flExpected = m_flLastStamp + m_flSendInterval;
+        if (fabs(flRecvTime - flExpected) < JITTER_RESYNC_TIME)
+        {
+            flStamp = flExpected + (flRecvTime - flExpected) * JITTER_SMOOTHING;
+            m_flSendInterval += (flRecvTime - m_flLastRecvTime - m_flSendInterval) * JITTER_SMOOTHING;
+        }
+    }
+    else if (m_flLastRecvTime > 0.0 && flRecvTime - m_flLastRecvTime < JITTER_RESYNC_TIME)
+    {
+        m_flSendInterval = flRecvTime - m_flLastRecvTime;
+    }
+
+    // Packets arriving in one burst still get played one after the other
+    if (flStamp <= m_flLastStamp)
+        flStamp = m_flLastStamp + 0.001;
+
+    m_flLastRecvTime = flRecvTime;
+    m_flLastStamp = flStamp;
+
+    Frame_t &frame = m_Frames[iWrite & (GHOST_JITTER_BUFFER_SIZE - 1)];
+    frame.m_flTime = flStamp;
+    frame.m_Packet = packet;
+
+    // Publishes the frame, the increment is a full barrier
+    ++m_iWrite;
+}
+
+bool CGhostJitterBuffer::Sample(double flTime, PositionPacket &out)
+{
+    const int iWrite = m_iWrite;
+    int iRead = m_iRead;
+    if (iRead == iWrite)
+        return false;
+
+    // Drop the packets that are fully in the past, keeping the last one before the sampled time
+    while (iRead + 1 != iWrite && m_Frames[(iRead + 1) & (GHOST_JITTER_BUFFER_SIZE - 1)].m_flTime <= flTime)
+        iRead++;
+    m_iRead = iRead;
+
+    const Frame_t &from = m_Frames[iRead & (GHOST_JITTER_BUFFER_SIZE - 1)];
+    if (flTime < from.m_flTime)
+        return false;
+
+    // Ran out of packets, hold the last one until more arrive
+    if (iRead + 1 == iWrite)
+    {
+        out = from.m_Packet;
+        return true;
+    }
+
+    const Frame_t &to = m_Frames[(iRead + 1) & (GHOST_JITTER_BUFFER_SIZE - 1)];
+    const float flDelta = float(to.m_flTime - from.m_flTime);
+    const float flFraction = clamp(float(flTime - from.m_flTime) / flDelta, 0.0f, 1.0f);
+
+    out = from.m_Packet;
+    if ((to.m_Packet.Position - from.m_Packet.Position).Length() > JITTER_TELEPORT_SPEED * flDelta)
+        return true;
+
+    out.Position = Lerp(flFraction, from.m_Packet.Position, to.m_Packet.Position);
+    out.Velocity = Lerp(flFraction, from.m_Packet.Velocity, to.m_Packet.Velocity);
+    out.ViewOffset = Lerp(flFraction, from.m_Packet.ViewOffset, to.m_Packet.ViewOffset);
+    for (int i = 0; i < 3; i++)
+        out.EyeAngle[i] = from.m_Packet.EyeAngle[i] + AngleDiff(to.m_Packet.EyeAngle[i], from.m_Packet.EyeAngle[i]) * flFraction;
+
+    return true;
+}
+
+void CGhostJitterBuffer::Clear()
+{
+    m_iRead = int(m_iWrite);
+}
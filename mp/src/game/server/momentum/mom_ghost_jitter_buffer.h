@@ -0,0 +1,45 @@
+#pragma once
+
+#include "mom_ghostdefs.h"
+
+// Number of position packets one online ghost can have buffered, must be a power of two
+#define GHOST_JITTER_BUFFER_SIZE 128
+
+// The preallocated buffer of position packets of one online ghost. The network thread pushes packets in, the game
+// thread samples them at a point in the past. Single producer and single consumer, so it needs no locks.
+//
+// Packets are timestamped when they arrive, smoothed against the estimated send interval of the other player so
+// jitter in the arrival times doesn't make it into the playback. Sampling interpolates between the two packets
+// around the sampled time.
+class CGhostJitterBuffer
+{
+  public:
+    CGhostJitterBuffer();
+
+    // Network thread: adds a packet received at the given Plat_FloatTime. Drops it if the buffer is full.
+    void Push(const PositionPacket &packet, double flRecvTime);
+
+    // Game thread: fills in the ghost at the given time, in the same clock as the receive times.
+    // Returns false if there is nothing to show at that time yet.
+    bool Sample(double flTime, PositionPacket &out);
+    // Game thread: drops every buffered packet
+    void Clear();
+
+  private:
+    struct Frame_t
+    {
+        double m_flTime;
+        PositionPacket m_Packet;
+    };
+
+    Frame_t m_Frames[GHOST_JITTER_BUFFER_SIZE];
+
+    // Both only ever grow, the slot is the index masked with the size
+    CInterlockedInt m_iWrite; // Owned by the network thread
+    CInterlockedInt m_iRead;  // Owned by the game thread
+
+    // Network thread only
+    double m_flLastRecvTime;
+    double m_flLastStamp;
+    double m_flSendInterval;
+};
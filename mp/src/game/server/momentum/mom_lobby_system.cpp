@@ -178,14 +178,15 @@ void CMomentumLobbySystem::HandleLobbyJoin(GameLobbyJoinRequested_t* pJoin)
     TryJoinLobby(pJoin->m_steamIDLobby);
 }
 
-CMomentumLobbySystem::CMomentumLobbySystem() : m_bHostingLobby(false)
+CMomentumLobbySystem::CMomentumLobbySystem() : m_bHostingLobby(false), m_hReceiveThread(nullptr), m_bStopReceiving(0)
 {
     SetDefLessFunc(m_mapLobbyGhosts);
+    SetDefLessFunc(m_mapPositionBuffers);
 }
 
 CMomentumLobbySystem::~CMomentumLobbySystem()
 {
-    
+    StopReceiveThread();
 }
 
 // Called when we created the lobby
@@ -349,6 +350,12 @@ CMomentumOnlineGhostEntity* CMomentumLobbySystem::GetLobbyMemberEntity(const uin
 
 void CMomentumLobbySystem::ClearCurrentGhosts(bool bLeavingLobby)
 {
+    StopReceiveThread();
+
+    // Whatever the lobby still sent us is of no use anymore
+    if (bLeavingLobby)
+        PurgeMessageQueue();
+
     if (m_mapLobbyGhosts.Count() == 0)
         return;
 
@@ -579,6 +586,9 @@ void CMomentumLobbySystem::OnLobbyMemberLeave(const CSteamID &member)
     }
 
     m_mapLobbyGhosts.RemoveAt(findIndex);
+
+    if (m_mapLobbyGhosts.Count() == 0)
+        StopReceiveThread();
 }
 
 void CMomentumLobbySystem::HandleLobbyDataUpdate(LobbyDataUpdate_t* pParam)
@@ -705,6 +715,7 @@ void CMomentumLobbySystem::CreateLobbyGhostEntity(const CSteamID &lobbyMember)
         UpdateLobbyEntityFromMemberData(pNewPlayer);
 
         m_mapLobbyGhosts.Insert(lobbyMemberID, pNewPlayer);
+        RegisterPositionBuffer(lobbyMemberID, pNewPlayer->GetPositionBuffer());
 
         if (m_flNextUpdateTime < 0)
             m_flNextUpdateTime = gpGlobals->curtime + (1.0f / mm_updaterate.GetFloat());
@@ -793,137 +804,226 @@ void CMomentumLobbySystem::SendAndReceiveP2PPackets()
     ReceiveP2PPackets();
 }
 
+#define MAX_MESSAGES_PER_READ 64
+
 void CMomentumLobbySystem::ReceiveP2PPackets()
 {
     CHECK_STEAM_API(SteamNetworkingMessages());
 
-#define MAX_MESSAGES_PER_READ 64
+    if (!m_hReceiveThread)
+        StartReceiveThread();
 
-    SteamNetworkingMessage_t *messages[MAX_MESSAGES_PER_READ];
-    int read = SteamNetworkingMessages()->ReceiveMessagesOnChannel(0, messages, MAX_MESSAGES_PER_READ);
-    while (read > 0)
+    // Couldn't start the thread, receive here instead
+    if (!m_hReceiveThread)
     {
-        for (int i = 0; i < read; i++)
+        while (ReceiveMessages())
         {
-            auto pMessage = messages[i];
+        }
+    }
+
+    SteamNetworkingMessage_t *pMessage;
+    while (m_queueMessages.PopItem(&pMessage))
+    {
+        HandleMessage(pMessage);
+        pMessage->Release();
+    }
+}
+
+unsigned CMomentumLobbySystem::ReceiveThreadFn(void *pParam)
+{
+    const auto pLobbySystem = static_cast<CMomentumLobbySystem *>(pParam);
+
+    while (!pLobbySystem->m_bStopReceiving)
+    {
+        if (!pLobbySystem->ReceiveMessages())
+            ThreadSleep(1);
+    }
+
+    return 0;
+}
+
+void CMomentumLobbySystem::StartReceiveThread()
+{
+    m_bStopReceiving = 0;
+    m_hReceiveThread = CreateSimpleThread(ReceiveThreadFn, this);
+
+    if (!m_hReceiveThread)
+        DevWarning("Failed to start the lobby receive thread, receiving on the game thread instead.\n");
+}
+
+void CMomentumLobbySystem::StopReceiveThread()
+{
+    if (!m_hReceiveThread)
+        return;
+
+    m_bStopReceiving = 1;
+    ThreadJoin(m_hReceiveThread);
+    ReleaseThreadHandle(m_hReceiveThread);
+    m_hReceiveThread = nullptr;
+}
+
+void CMomentumLobbySystem::RegisterPositionBuffer(uint64 id, CGhostJitterBuffer *pBuffer)
+{
+    AUTO_LOCK(m_PositionBufferMutex);
+    m_mapPositionBuffers.InsertOrReplace(id, pBuffer);
+}
+
+void CMomentumLobbySystem::UnregisterPositionBuffer(uint64 id, CGhostJitterBuffer *pBuffer)
+{
+    AUTO_LOCK(m_PositionBufferMutex);
+    const auto index = m_mapPositionBuffers.Find(id);
+    if (m_mapPositionBuffers.IsValidIndex(index) && m_mapPositionBuffers[index] == pBuffer)
+        m_mapPositionBuffers.RemoveAt(index);
+}
+
+void CMomentumLobbySystem::PurgeMessageQueue()
+{
+    SteamNetworkingMessage_t *pMessage;
+    while (m_queueMessages.PopItem(&pMessage))
+        pMessage->Release();
+}
+
+bool CMomentumLobbySystem::ReceiveMessages()
+{
+    SteamNetworkingMessage_t *messages[MAX_MESSAGES_PER_READ];
+    const int read = SteamNetworkingMessages()->ReceiveMessagesOnChannel(0, messages, MAX_MESSAGES_PER_READ);
+    if (read <= 0)
+        return false;
+
+    const double flRecvTime = Plat_FloatTime();
 
-            CSteamID fromWho = pMessage->m_identityPeer.GetSteamID();
+    AUTO_LOCK(m_PositionBufferMutex);
+    for (int i = 0; i < read; i++)
+    {
+        const auto pMessage = messages[i];
+        if (pMessage->m_cbSize < 1 || static_cast<const uint8 *>(pMessage->m_pData)[0] != PACKET_TYPE_POSITION)
+        {
+            m_queueMessages.PushItem(pMessage);
+            continue;
+        }
 
+        const auto index = m_mapPositionBuffers.Find(pMessage->m_identityPeer.GetSteamID64());
+        if (m_mapPositionBuffers.IsValidIndex(index))
+        {
             CUtlBuffer buf(pMessage->m_pData, pMessage->m_cbSize, CUtlBuffer::READ_ONLY);
             buf.SetBigEndian(false);
+            buf.GetUnsignedChar();
 
-            const auto type = buf.GetUnsignedChar();
-            switch (type)
-            {
-            case PACKET_TYPE_POSITION:
-            {
-                PositionPacket frame(buf);
-                CMomentumOnlineGhostEntity *pEntity = GetLobbyMemberEntity(fromWho);
-                if (pEntity)
-                    pEntity->AddPositionFrame(frame);
-            }
-            break;
-            case PACKET_TYPE_DECAL:
-            {
-                DecalPacket decals(buf);
-                if (decals.decal_type == DECAL_INVALID)
-                    break;
+            PositionPacket frame(buf);
+            m_mapPositionBuffers[index]->Push(frame, flRecvTime);
+        }
 
-                const auto pEntity = GetLobbyMemberEntity(fromWho);
-                if (pEntity)
-                {
-                    pEntity->AddDecalFrame(decals);
-                }
-            }
-            break;
-            case PACKET_TYPE_SAVELOC_REQ:
-            {
-                SavelocReqPacket saveloc(buf);
+        pMessage->Release();
+    }
 
-                // Done/fail states:
-                // 1. They hit "cancel" (most common)
-                // 2. They leave the map (same as 1, just accidental maybe)
-                // 3. They leave the lobby/server (manually, due to power outage, etc)
-                // 4. We leave the map
-                // 5. We leave the lobby/server
-                // 6. They get the savelocs they need
+    return true;
+}
 
-                // Of the above, 1 and 6 are the ones that are manually sent.
-                // 2<->5 can be automatically detected with lobby/server hooks
+void CMomentumLobbySystem::HandleMessage(SteamNetworkingMessage_t *pMessage)
+{
+    CSteamID fromWho = pMessage->m_identityPeer.GetSteamID();
 
-                // Fail requirements:
-                // Requester: set "requesting" to false, close the request UI
-                // Requestee: remove requester from requesters vector
+    CUtlBuffer buf(pMessage->m_pData, pMessage->m_cbSize, CUtlBuffer::READ_ONLY);
+    buf.SetBigEndian(false);
 
-                if (mom_lobby_debug.GetBool())
-                    Log("Received a stage %i saveloc request packet!\n", saveloc.stage);
+    const auto type = buf.GetUnsignedChar();
+    switch (type)
+    {
+    case PACKET_TYPE_DECAL:
+    {
+        DecalPacket decals(buf);
+        if (decals.decal_type == DECAL_INVALID)
+            break;
 
-                switch (saveloc.stage)
-                {
-                case SAVELOC_REQ_STAGE_COUNT_REQ:
-                {
-                    if (!g_pSavelocSystem->AddSavelocRequester(fromWho.ConvertToUint64()))
-                        break;
+        const auto pEntity = GetLobbyMemberEntity(fromWho);
+        if (pEntity)
+        {
+            pEntity->AddDecalFrame(decals);
+        }
+    }
+    break;
+    case PACKET_TYPE_SAVELOC_REQ:
+    {
+        SavelocReqPacket saveloc(buf);
 
-                    SavelocReqPacket response;
-                    response.stage = SAVELOC_REQ_STAGE_COUNT_ACK;
-                    response.saveloc_count = g_pSavelocSystem->GetSavelocCount();
+        // Done/fail states:
+        // 1. They hit "cancel" (most common)
+        // 2. They leave the map (same as 1, just accidental maybe)
+        // 3. They leave the lobby/server (manually, due to power outage, etc)
+        // 4. We leave the map
+        // 5. We leave the lobby/server
+        // 6. They get the savelocs they need
 
-                    SendPacket(&response, fromWho, k_nSteamNetworkingSend_Reliable);
-                }
-                break;
-                case SAVELOC_REQ_STAGE_COUNT_ACK:
-                {
-                    KeyValues *pKV = new KeyValues("req_savelocs");
-                    pKV->SetInt("stage", SAVELOC_REQ_STAGE_COUNT_ACK);
-                    pKV->SetInt("count", saveloc.saveloc_count);
-                    g_pModuleComms->FireEvent(pKV);
-                }
-                break;
-                case SAVELOC_REQ_STAGE_SAVELOC_REQ:
-                {
-                    SavelocReqPacket response;
-                    response.stage = SAVELOC_REQ_STAGE_SAVELOC_ACK;
+        // Of the above, 1 and 6 are the ones that are manually sent.
+        // 2<->5 can be automatically detected with lobby/server hooks
 
-                    if (g_pSavelocSystem->WriteRequestedSavelocs(&saveloc, &response, fromWho.ConvertToUint64()))
-                        SendPacket(&response, fromWho, k_nSteamNetworkingSend_Reliable);
-                }
-                break;
-                case SAVELOC_REQ_STAGE_SAVELOC_ACK:
-                {
-                    if (g_pSavelocSystem->ReadReceivedSavelocs(&saveloc, fromWho.ConvertToUint64()))
-                    {
-                        SavelocReqPacket response;
-                        response.stage = SAVELOC_REQ_STAGE_DONE;
-                        if (SendPacket(&response, fromWho, k_nSteamNetworkingSend_Reliable))
-                        {
-                            KeyValues *pKv = new KeyValues("req_savelocs");
-                            pKv->SetInt("stage", SAVELOC_REQ_STAGE_DONE);
-                            g_pModuleComms->FireEvent(pKv);
-                        }
-                    }
-                }
+        // Fail requirements:
+        // Requester: set "requesting" to false, close the request UI
+        // Requestee: remove requester from requesters vector
+
+        if (mom_lobby_debug.GetBool())
+            Log("Received a stage %i saveloc request packet!\n", saveloc.stage);
+
+        switch (saveloc.stage)
+        {
+        case SAVELOC_REQ_STAGE_COUNT_REQ:
+        {
+            if (!g_pSavelocSystem->AddSavelocRequester(fromWho.ConvertToUint64()))
                 break;
-                case SAVELOC_REQ_STAGE_DONE:
+
+            SavelocReqPacket response;
+            response.stage = SAVELOC_REQ_STAGE_COUNT_ACK;
+            response.saveloc_count = g_pSavelocSystem->GetSavelocCount();
+
+            SendPacket(&response, fromWho, k_nSteamNetworkingSend_Reliable);
+        }
+        break;
+        case SAVELOC_REQ_STAGE_COUNT_ACK:
+        {
+            KeyValues *pKV = new KeyValues("req_savelocs");
+            pKV->SetInt("stage", SAVELOC_REQ_STAGE_COUNT_ACK);
+            pKV->SetInt("count", saveloc.saveloc_count);
+            g_pModuleComms->FireEvent(pKV);
+        }
+        break;
+        case SAVELOC_REQ_STAGE_SAVELOC_REQ:
+        {
+            SavelocReqPacket response;
+            response.stage = SAVELOC_REQ_STAGE_SAVELOC_ACK;
+
+            if (g_pSavelocSystem->WriteRequestedSavelocs(&saveloc, &response, fromWho.ConvertToUint64()))
+                SendPacket(&response, fromWho, k_nSteamNetworkingSend_Reliable);
+        }
+        break;
+        case SAVELOC_REQ_STAGE_SAVELOC_ACK:
+        {
+            if (g_pSavelocSystem->ReadReceivedSavelocs(&saveloc, fromWho.ConvertToUint64()))
+            {
+                SavelocReqPacket response;
+                response.stage = SAVELOC_REQ_STAGE_DONE;
+                if (SendPacket(&response, fromWho, k_nSteamNetworkingSend_Reliable))
                 {
-                    g_pSavelocSystem->RequesterLeft(fromWho.ConvertToUint64());
-                }
-                break;
-                case SAVELOC_REQ_STAGE_INVALID:
-                default:
-                    DevWarning(2, "Invalid stage for the saveloc request packet!\n");
-                    break;
+                    KeyValues *pKv = new KeyValues("req_savelocs");
+                    pKv->SetInt("stage", SAVELOC_REQ_STAGE_DONE);
+                    g_pModuleComms->FireEvent(pKv);
                 }
             }
+        }
+        break;
+        case SAVELOC_REQ_STAGE_DONE:
+        {
+            g_pSavelocSystem->RequesterLeft(fromWho.ConvertToUint64());
+        }
+        break;
+        case SAVELOC_REQ_STAGE_INVALID:
+        default:
+            DevWarning(2, "Invalid stage for the saveloc request packet!\n");
             break;
-            default:
-                break;
-            }
-
-            pMessage->Release();
         }
-
-        read = SteamNetworkingMessages()->ReceiveMessagesOnChannel(0, messages, MAX_MESSAGES_PER_READ);
+    }
+    break;
+    default:
+        break;
     }
 }
 
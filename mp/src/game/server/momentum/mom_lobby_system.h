@@ -1,12 +1,16 @@
 #pragma once
 
 #include "mom_shareddefs.h"
+#include "tier0/threadtools.h"
+#include "tier0/tslist.h"
 
 class MomentumPacket;
 class DecalPacket;
 class SavelocReqPacket;
 struct AppearanceData_t;
 class CMomentumOnlineGhostEntity;
+class CGhostJitterBuffer;
+struct SteamNetworkingMessage_t;
 
 class CMomentumLobbySystem
 {
@@ -67,6 +71,11 @@ public:
 
     void ClearCurrentGhosts(bool bLeavingLobby); // Clears the current ghosts stored in the map
 
+    // The buffer the receive thread puts the position packets of the given lobby member into
+    void RegisterPositionBuffer(uint64 id, CGhostJitterBuffer *pBuffer);
+    // Only unregisters the buffer if it's still the one of the member, a rejoined member's new ghost may have replaced it
+    void UnregisterPositionBuffer(uint64 id, CGhostJitterBuffer *pBuffer);
+
     CUtlMap<uint64, CMomentumOnlineGhostEntity*> *GetOnlineEntMap() { return &m_mapLobbyGhosts;}
 
 private:
@@ -96,6 +105,21 @@ private:
     // When the lobby member leaves either the map or the lobby
     void OnLobbyMemberLeave(const CSteamID &member);
 
+    // Packets are received and decoded off the game thread. Position packets go straight into the ghosts'
+    // buffers, everything else is queued up for the game thread to handle.
+    static unsigned ReceiveThreadFn(void *pParam);
+    void StartReceiveThread();
+    void StopReceiveThread();
+    bool ReceiveMessages(); // Returns false if there was nothing to receive
+    void PurgeMessageQueue(); // Releases the queued messages without handling them, the receive thread must be stopped
+    void HandleMessage(SteamNetworkingMessage_t *pMessage);
+
+    ThreadHandle_t m_hReceiveThread;
+    CInterlockedInt m_bStopReceiving;
+    CThreadFastMutex m_PositionBufferMutex; // Guards m_mapPositionBuffers
+    CUtlMap<uint64, CGhostJitterBuffer*> m_mapPositionBuffers;
+    CTSQueue<SteamNetworkingMessage_t*> m_queueMessages;
+
     CCallResult<CMomentumLobbySystem, LobbyCreated_t> m_cLobbyCreated;
     CCallResult<CMomentumLobbySystem, LobbyEnter_t> m_cLobbyJoined;
 };
@@ -0,0 +1,331 @@
+#include "cbase.h"
+
+#include "filesystem.h"
+#include "mom_movement_profiler.h"
+#include "mom_player.h"
+#include "mom_replay_simulator.h"
+#include "mom_system_gamemode.h"
+#include "mom_timer.h"
+#include "run/mom_replay_base.h"
+#include "run/mom_replay_factory.h"
+#include "util/baseautocompletefilelist.h"
+
+#include "tier0/memdbgon.h"
+
+// The benchmark corpus, replays of any map and gamemode. Only the ones of the current map run.
+#define MOVEMENT_BENCHMARK_PATH "replays/benchmark"
+#define MOVEMENT_BENCHMARK_RESULTS_FILE "movement_benchmark.txt"
+#define MOVEMENT_BENCHMARK_BASELINE_FILE "movement_benchmark_baseline.txt"
+
+static ConVar mom_movement_benchmark_iterations("mom_movement_benchmark_iterations", "5", FCVAR_NONE,
+                                                "Timed passes over every benchmark replay, the fastest pass counts.",
+                                                true, 1, true, 100);
+static ConVar mom_movement_benchmark_threshold("mom_movement_benchmark_threshold", "5", FCVAR_NONE,
+                                               "Percentage of ns/tick over the baseline at which a benchmark result "
+                                               "is reported as a regression.",
+                                               true, 0, false, 0);
+
+static const char *const s_pGameModeNames[] = {"unknown", "surf", "bhop", "kz", "rj", "sj",
+                                               "tricksurf", "ahop", "parkour", "conc", "defrag"};
+COMPILE_TIME_ASSERT(ARRAYSIZE(s_pGameModeNames) == GAMEMODE_COUNT);
+
+// Gamemodes whose movement comes from projectiles and explosions can't be reproduced from the inputs alone
+static bool IsBenchmarkGameMode(GameMode_t type)
+{
+    return type != GAMEMODE_RJ && type != GAMEMODE_SJ && type != GAMEMODE_CONC && type != GAMEMODE_DEFRAG;
+}
+
+static void PrintGameModeSummary(KeyValues *pResults)
+{
+    Msg("%-10s %6s %10s %12s %14s\n", "gamemode", "maps", "ticks", "ns/tick", "traces/tick");
+    FOR_EACH_TRUE_SUBKEY(pResults, pGameMode)
+    {
+        int maps = 0;
+        int64 ticks = 0;
+        double time = 0.0, traces = 0.0;
+        FOR_EACH_TRUE_SUBKEY(pGameMode, pMap)
+        {
+            const int mapTicks = pMap->GetInt("ticks");
+            maps++;
+            ticks += mapTicks;
+            time += double(pMap->GetFloat("ns_per_tick")) * mapTicks;
+            traces += double(pMap->GetFloat("traces_per_tick")) * mapTicks;
+        }
+
+        if (ticks)
+            Msg("%-10s %6i %10lld %12.1f %14.2f\n", pGameMode->GetName(), maps, ticks, time / ticks, traces / ticks);
+    }
+}
+
+static void SimulateReplay(CMomentumPlayer *pPlayer, CMomReplayBase *pReplay, ReplaySimulationResult_t &result)
+{
+    CMomReplaySimulator simulator(pPlayer);
+    simulator.Simulate(pReplay, REPLAY_SIMULATION_TOLERANCE, false, result);
+}
+
+static bool CanRunBenchmark(CMomentumPlayer *pPlayer)
+{
+    if (!pPlayer || g_pMomentumTimer->IsRunning() || pPlayer->GetObserverMode() != OBS_MODE_NONE)
+    {
+        Warning("Stop your timer and stop spectating to run the movement benchmark.\n");
+        return false;
+    }
+
+    const GameMode_t type = g_pGameModeSystem->GetGameMode()->GetType();
+    if (!IsBenchmarkGameMode(type))
+    {
+        Warning("%s maps can't be benchmarked, their movement depends on projectiles that replays don't reproduce.\n",
+                s_pGameModeNames[type]);
+        return false;
+    }
+
+    return true;
+}
+
+CON_COMMAND(mom_movement_benchmark, "Runs the inputs of the benchmark replays (" MOVEMENT_BENCHMARK_PATH ") of the current "
+                                    "map through the movement and reports ns/tick and traces/tick, comparing them "
+                                    "to the baseline. Resets the movement profiler.\n"
+                                    "Usage: mom_movement_benchmark [replay]")
+{
+    const auto pPlayer = CMomentumPlayer::GetLocalPlayer();
+    if (!CanRunBenchmark(pPlayer))
+        return;
+
+    const char *pMapName = gpGlobals->mapname.ToCStr();
+
+    CUtlVector<CMomReplayBase *> vecReplays;
+    char path[MAX_PATH];
+    if (args.ArgC() > 1)
+    {
+        Q_snprintf(path, MAX_PATH, "%s/%s", MOVEMENT_BENCHMARK_PATH, args.Arg(1));
+        V_SetExtension(path, EXT_RECORDING_FILE, MAX_PATH);
+        V_FixSlashes(path);
+
+        CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(path);
+        if (pReplay)
+            vecReplays.AddToTail(pReplay);
+    }
+    else
+    {
+        Q_snprintf(path, MAX_PATH, "%s/*%s", MOVEMENT_BENCHMARK_PATH, EXT_RECORDING_FILE);
+        V_FixSlashes(path);
+
+        FileFindHandle_t found;
+        const char *pFoundFile = g_pFullFileSystem->FindFirstEx(path, "MOD", &found);
+        while (pFoundFile)
+        {
+            char replayPath[MAX_PATH];
+            V_ComposeFileName(MOVEMENT_BENCHMARK_PATH, pFoundFile, replayPath, MAX_PATH);
+
+            CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(replayPath);
+            if (pReplay)
+            {
+                if (FStrEq(pReplay->GetMapName(), pMapName))
+                    vecReplays.AddToTail(pReplay);
+                else
+                    delete pReplay;
+            }
+
+            pFoundFile = g_pFullFileSystem->FindNext(found);
+        }
+        g_pFullFileSystem->FindClose(found);
+    }
+
+    FOR_EACH_VEC_BACK(vecReplays, i)
+    {
+        if (!FStrEq(vecReplays[i]->GetMapName(), pMapName) ||
+            !CloseEnough(vecReplays[i]->GetTickInterval(), gpGlobals->interval_per_tick, FLT_EPSILON))
+        {
+            Warning("Skipping a replay of %s at tick interval %f.\n", vecReplays[i]->GetMapName(), vecReplays[i]->GetTickInterval());
+            delete vecReplays[i];
+            vecReplays.Remove(i);
+        }
+    }
+
+    if (vecReplays.IsEmpty())
+    {
+        Warning("No benchmark replays of %s found in %s!\n", pMapName, MOVEMENT_BENCHMARK_PATH);
+        return;
+    }
+
+    // A replay the movement doesn't reproduce anymore would only run up to where it diverges, so it's left out
+    FOR_EACH_VEC_BACK(vecReplays, i)
+    {
+        ReplaySimulationResult_t result;
+        SimulateReplay(pPlayer, vecReplays[i], result);
+        if (result.m_iFirstDivergence >= 0)
+        {
+            Warning("Skipping a replay of %s by %s, the movement diverges from it at frame %i!\n", pMapName,
+                    vecReplays[i]->GetPlayerName(), result.m_iFirstDivergence);
+            delete vecReplays[i];
+            vecReplays.Remove(i);
+        }
+    }
+
+    if (vecReplays.IsEmpty())
+    {
+        Warning("None of the benchmark replays of %s can be reproduced!\n", pMapName);
+        return;
+    }
+
+    // One profiled pass for the trace counts, profiling is kept off for the timed passes so it doesn't skew them
+    g_pMovementProfiler->Reset();
+    g_pMovementProfiler->SetForced(1);
+    FOR_EACH_VEC(vecReplays, i)
+    {
+        ReplaySimulationResult_t result;
+        SimulateReplay(pPlayer, vecReplays[i], result);
+    }
+    const int64 traces = g_pMovementProfiler->GetTotalTraces();
+    const int ticks = g_pMovementProfiler->GetTicks();
+    g_pMovementProfiler->SetForced(0);
+
+    double bestTime = 0.0;
+    FOR_EACH_VEC(vecReplays, i)
+    {
+        double replayBest = DBL_MAX;
+        for (int iteration = 0; iteration < mom_movement_benchmark_iterations.GetInt(); iteration++)
+        {
+            ReplaySimulationResult_t result;
+            const double start = Plat_FloatTime();
+            SimulateReplay(pPlayer, vecReplays[i], result);
+            replayBest = MIN(replayBest, Plat_FloatTime() - start);
+        }
+
+        bestTime += replayBest;
+    }
+
+    g_pMovementProfiler->SetForced(-1);
+    g_pMovementProfiler->Reset();
+    vecReplays.PurgeAndDeleteElements();
+
+    if (!ticks)
+    {
+        Warning("The benchmark replays of %s have no movement ticks to simulate!\n", pMapName);
+        return;
+    }
+
+    const char *pGameMode = s_pGameModeNames[g_pGameModeSystem->GetGameMode()->GetType()];
+    const float flNsPerTick = float(bestTime * 1000000000.0 / ticks);
+    const float flTracesPerTick = float(double(traces) / ticks);
+    Msg("%s (%s): %i ticks, %.1f ns/tick, %.2f traces/tick\n", pMapName, pGameMode, ticks, flNsPerTick, flTracesPerTick);
+
+    KeyValuesAD pBaseline("MovementBenchmark");
+    if (pBaseline->LoadFromFile(g_pFullFileSystem, MOVEMENT_BENCHMARK_BASELINE_FILE, "MOD"))
+    {
+        const auto pBaseMap = pBaseline->FindKey(pGameMode) ? pBaseline->FindKey(pGameMode)->FindKey(pMapName) : nullptr;
+        if (pBaseMap && pBaseMap->GetInt("ticks") == ticks)
+        {
+            const float flBaseNs = pBaseMap->GetFloat("ns_per_tick");
+            const float flBaseTraces = pBaseMap->GetFloat("traces_per_tick");
+            const float flChange = flBaseNs > 0.0f ? 100.0f * (flNsPerTick - flBaseNs) / flBaseNs : 0.0f;
+
+            if (flChange > mom_movement_benchmark_threshold.GetFloat())
+                Warning("Regression: %.1f ns/tick is %.1f%% over the baseline of %.1f ns/tick\n", flNsPerTick, flChange, flBaseNs);
+            else
+                Msg("%+.1f%% ns/tick against the baseline of %.1f ns/tick\n", flChange, flBaseNs);
+
+            if (flTracesPerTick > flBaseTraces + 0.005f)
+                Warning("Regression: %.2f traces/tick is more than the baseline of %.2f traces/tick\n", flTracesPerTick, flBaseTraces);
+        }
+        else if (pBaseMap)
+        {
+            Warning("The baseline of %s was made with a different set of replays, not comparing.\n", pMapName);
+        }
+    }
+
+    KeyValuesAD pResults("MovementBenchmark");
+    pResults->LoadFromFile(g_pFullFileSystem, MOVEMENT_BENCHMARK_RESULTS_FILE, "MOD");
+    KeyValues *pMapResults = pResults->FindKey(pGameMode, true)->FindKey(pMapName, true);
+    pMapResults->SetInt("ticks", ticks);
+    pMapResults->SetFloat("ns_per_tick", flNsPerTick);
+    pMapResults->SetFloat("traces_per_tick", flTracesPerTick);
+    if (!pResults->SaveToFile(g_pFullFileSystem, MOVEMENT_BENCHMARK_RESULTS_FILE, "MOD"))
+        Warning("Failed to save the benchmark results to %s!\n", MOVEMENT_BENCHMARK_RESULTS_FILE);
+
+    PrintGameModeSummary(pResults);
+}
+
+CON_COMMAND(mom_movement_benchmark_report, "Prints the latest movement benchmark results of every map, per gamemode.")
+{
+    KeyValuesAD pResults("MovementBenchmark");
+    if (!pResults->LoadFromFile(g_pFullFileSystem, MOVEMENT_BENCHMARK_RESULTS_FILE, "MOD"))
+    {
+        Msg("No movement benchmark results yet, run mom_movement_benchmark on the benchmark maps first.\n");
+        return;
+    }
+
+    PrintGameModeSummary(pResults);
+}
+
+CON_COMMAND(mom_movement_benchmark_baseline, "Makes the latest movement benchmark results the baseline later runs are compared to.")
+{
+    KeyValuesAD pResults("MovementBenchmark");
+    if (!pResults->LoadFromFile(g_pFullFileSystem, MOVEMENT_BENCHMARK_RESULTS_FILE, "MOD"))
+    {
+        Warning("No movement benchmark results to make the baseline from!\n");
+        return;
+    }
+
+    if (pResults->SaveToFile(g_pFullFileSystem, MOVEMENT_BENCHMARK_BASELINE_FILE, "MOD"))
+        Msg("Saved the movement benchmark baseline to %s.\n", MOVEMENT_BENCHMARK_BASELINE_FILE);
+}
+
+static void AddBenchmarkReplay(const CCommand &args)
+{
+    if (args.ArgC() < 2)
+    {
+        Msg("Usage: mom_movement_benchmark_add <replay>\n");
+        return;
+    }
+
+    const auto pPlayer = CMomentumPlayer::GetLocalPlayer();
+    if (!CanRunBenchmark(pPlayer))
+        return;
+
+    char filename[MAX_PATH], replayPath[MAX_PATH], benchmarkPath[MAX_PATH];
+    Q_strncpy(filename, args.Arg(1), MAX_PATH);
+    V_SetExtension(filename, EXT_RECORDING_FILE, MAX_PATH);
+    V_ComposeFileName(RECORDING_PATH, filename, replayPath, MAX_PATH);
+    V_ComposeFileName(MOVEMENT_BENCHMARK_PATH, filename, benchmarkPath, MAX_PATH);
+
+    CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(replayPath);
+    if (!pReplay)
+        return;
+
+    // Only replays the movement reproduces from start to end make useful benchmark cases
+    bool bReproduced = false;
+    if (!FStrEq(pReplay->GetMapName(), gpGlobals->mapname.ToCStr()) ||
+        !CloseEnough(pReplay->GetTickInterval(), gpGlobals->interval_per_tick, FLT_EPSILON))
+    {
+        Warning("%s is a replay of %s at tick interval %f, load its map to add it.\n", replayPath, pReplay->GetMapName(),
+                pReplay->GetTickInterval());
+    }
+    else
+    {
+        ReplaySimulationResult_t result;
+        SimulateReplay(pPlayer, pReplay, result);
+        if (result.m_iFirstDivergence >= 0)
+            Warning("The movement diverges from %s at frame %i, it can't be benchmarked.\n", replayPath, result.m_iFirstDivergence);
+        else
+            bReproduced = true;
+    }
+
+    delete pReplay;
+
+    if (!bReproduced)
+        return;
+
+    CUtlBuffer buf;
+    g_pFullFileSystem->CreateDirHierarchy(MOVEMENT_BENCHMARK_PATH, "MOD");
+    if (g_pFullFileSystem->ReadFile(replayPath, "MOD", buf) && g_pFullFileSystem->WriteFile(benchmarkPath, "MOD", buf))
+        Msg("Added %s to the movement benchmark replays, make a new baseline after the next benchmark run.\n", filename);
+    else
+        Warning("Failed to copy %s to %s!\n", replayPath, benchmarkPath);
+}
+
+CON_COMMAND_AUTOCOMPLETEFILE(mom_movement_benchmark_add, AddBenchmarkReplay,
+                             "Adds a replay of the current map to the movement benchmark replays (" MOVEMENT_BENCHMARK_PATH "), "
+                             "if the movement reproduces it.\n"
+                             "Usage: mom_movement_benchmark_add <replay>",
+                             RECORDING_PATH, EXT_RECORDING_FILE);
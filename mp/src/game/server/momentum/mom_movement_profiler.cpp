@@ -0,0 +1,260 @@
+#include "cbase.h"
+
+#include "filesystem.h"
+#include "mom_movement_profiler.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar mom_movement_profile("mom_movement_profile", "0", FCVAR_NONE,
+                                   "Profiles the traces and time spent per movement phase every movement tick.\n"
+                                   "See mom_movement_profile_print and mom_movement_profile_csv.");
+static ConVar mom_movement_profile_trace_budget("mom_movement_profile_trace_budget", "64", FCVAR_NONE,
+                                                "Movement ticks using more traces than this are reported as over budget by the profiler.",
+                                                true, 1, false, 0);
+
+static const char *const s_pPhaseNames[MOVEPHASE_COUNT] = {"other", "ground", "air", "ladder", "wallrun", "rampfix"};
+
+CON_COMMAND(mom_movement_profile_print, "Prints the movement profiler's per phase statistics and traces per tick histogram.")
+{
+    g_pMovementProfiler->PrintReport();
+}
+
+CON_COMMAND(mom_movement_profile_reset, "Resets the movement profiler's statistics.")
+{
+    g_pMovementProfiler->Reset();
+}
+
+CON_COMMAND(mom_movement_profile_csv, "Dumps every profiled movement tick to the given CSV file, or stops dumping if no file is given.\n"
+                                      "Usage: mom_movement_profile_csv [file.csv]")
+{
+    if (args.ArgC() > 1)
+    {
+        if (g_pMovementProfiler->StartCSV(args.Arg(1)))
+            Msg("Dumping movement ticks to %s, make sure mom_movement_profile is enabled.\n", args.Arg(1));
+    }
+    else
+    {
+        g_pMovementProfiler->StopCSV();
+    }
+}
+
+CMomMovementProfiler::CMomMovementProfiler() : CAutoGameSystem("CMomMovementProfiler"), m_bActive(false), m_iForced(-1),
+    m_iTickPlayer(0), m_flTickSpeed(0.0f), m_iPhaseDepth(0), m_flLastSwitchTime(0.0), m_hCSVFile(FILESYSTEM_INVALID_HANDLE)
+{
+    m_Phases[0] = MOVEPHASE_OTHER;
+    Reset();
+}
+
+void CMomMovementProfiler::LevelShutdownPostEntity()
+{
+    StopCSV();
+}
+
+void CMomMovementProfiler::Shutdown()
+{
+    StopCSV();
+}
+
+void CMomMovementProfiler::Reset()
+{
+    m_iTicks = 0;
+    m_iTicksOverBudget = 0;
+    m_iWorstTick = -1;
+    m_iWorstTickTraces = 0;
+    m_vecWorstTickOrigin.Init();
+
+    for (int i = 0; i < MOVEPHASE_COUNT; i++)
+    {
+        m_iTotalTraces[i] = 0;
+        m_flTotalTime[i] = 0.0;
+        m_iMaxTraces[i] = 0;
+        m_flMaxTime[i] = 0.0;
+    }
+
+    for (int i = 0; i < MOVEPROF_HISTOGRAM_BUCKETS; i++)
+        m_iHistogram[i] = 0;
+}
+
+int64 CMomMovementProfiler::GetTotalTraces() const
+{
+    int64 traces = 0;
+    for (int i = 0; i < MOVEPHASE_COUNT; i++)
+        traces += m_iTotalTraces[i];
+    return traces;
+}
+
+void CMomMovementProfiler::BeginTick(CBasePlayer *pPlayer)
+{
+    m_bActive = m_iForced < 0 ? mom_movement_profile.GetBool() : m_iForced > 0;
+    if (!m_bActive)
+        return;
+
+    m_iTickPlayer = pPlayer->entindex();
+    m_vecTickOrigin = pPlayer->GetAbsOrigin();
+    m_flTickSpeed = pPlayer->GetAbsVelocity().Length();
+
+    for (int i = 0; i < MOVEPHASE_COUNT; i++)
+    {
+        m_iTickTraces[i] = 0;
+        m_flTickTime[i] = 0.0;
+    }
+
+    m_iPhaseDepth = 0;
+    m_flLastSwitchTime = Plat_FloatTime();
+}
+
+void CMomMovementProfiler::EndTick()
+{
+    if (!m_bActive)
+        return;
+
+    SwitchPhase();
+    m_bActive = false;
+
+    int tickTraces = 0;
+    double tickTime = 0.0;
+    for (int i = 0; i < MOVEPHASE_COUNT; i++)
+    {
+        tickTraces += m_iTickTraces[i];
+        tickTime += m_flTickTime[i];
+
+        m_iTotalTraces[i] += m_iTickTraces[i];
+        m_flTotalTime[i] += m_flTickTime[i];
+        m_iMaxTraces[i] = MAX(m_iMaxTraces[i], m_iTickTraces[i]);
+        m_flMaxTime[i] = MAX(m_flMaxTime[i], m_flTickTime[i]);
+    }
+
+    m_iTicks++;
+
+    int bucket = 0;
+    for (int traces = tickTraces; traces > 0 && bucket < MOVEPROF_HISTOGRAM_BUCKETS - 1; traces >>= 1)
+        bucket++;
+    m_iHistogram[bucket]++;
+
+    if (tickTraces > mom_movement_profile_trace_budget.GetInt())
+    {
+        m_iTicksOverBudget++;
+        DevWarning("Movement tick %i used %i traces (budget %i) at %.1f %.1f %.1f\n", gpGlobals->tickcount, tickTraces,
+                   mom_movement_profile_trace_budget.GetInt(), m_vecTickOrigin.x, m_vecTickOrigin.y, m_vecTickOrigin.z);
+    }
+
+    if (tickTraces > m_iWorstTickTraces)
+    {
+        m_iWorstTick = gpGlobals->tickcount;
+        m_iWorstTickTraces = tickTraces;
+        m_vecWorstTickOrigin = m_vecTickOrigin;
+    }
+
+    if (m_hCSVFile != FILESYSTEM_INVALID_HANDLE)
+    {
+        g_pFullFileSystem->FPrintf(m_hCSVFile, "%i,%i,%.3f,%.3f,%.3f,%.3f,%i,%.2f", gpGlobals->tickcount, m_iTickPlayer,
+                                   m_vecTickOrigin.x, m_vecTickOrigin.y, m_vecTickOrigin.z, m_flTickSpeed, tickTraces,
+                                   tickTime * 1000000.0);
+        for (int i = 0; i < MOVEPHASE_COUNT; i++)
+            g_pFullFileSystem->FPrintf(m_hCSVFile, ",%i,%.2f", m_iTickTraces[i], m_flTickTime[i] * 1000000.0);
+        g_pFullFileSystem->FPrintf(m_hCSVFile, "\n");
+    }
+}
+
+void CMomMovementProfiler::SwitchPhase()
+{
+    const double now = Plat_FloatTime();
+    m_flTickTime[m_Phases[m_iPhaseDepth]] += now - m_flLastSwitchTime;
+    m_flLastSwitchTime = now;
+}
+
+void CMomMovementProfiler::PushPhase(MovementPhase_t phase)
+{
+    SwitchPhase();
+
+    // Deeper nesting than this doesn't happen in practice, keep attributing to the innermost phase we track
+    if (m_iPhaseDepth < ARRAYSIZE(m_Phases) - 1)
+        m_iPhaseDepth++;
+    m_Phases[m_iPhaseDepth] = phase;
+}
+
+void CMomMovementProfiler::PopPhase()
+{
+    SwitchPhase();
+
+    if (m_iPhaseDepth > 0)
+        m_iPhaseDepth--;
+}
+
+void CMomMovementProfiler::PrintReport()
+{
+    if (!m_iTicks)
+    {
+        Msg("No movement ticks profiled yet, enable mom_movement_profile first.\n");
+        return;
+    }
+
+    Msg("Movement profile over %i ticks (%i over the budget of %i traces):\n", m_iTicks, m_iTicksOverBudget,
+        mom_movement_profile_trace_budget.GetInt());
+    Msg("%-10s %12s %12s %12s %12s\n", "phase", "avg traces", "max traces", "avg us", "max us");
+    for (int i = 0; i < MOVEPHASE_COUNT; i++)
+    {
+        Msg("%-10s %12.2f %12i %12.2f %12.2f\n", s_pPhaseNames[i], double(m_iTotalTraces[i]) / m_iTicks, m_iMaxTraces[i],
+            m_flTotalTime[i] * 1000000.0 / m_iTicks, m_flMaxTime[i] * 1000000.0);
+    }
+
+    Msg("Traces per tick:\n");
+    int maxBucket = 1;
+    for (int i = 0; i < MOVEPROF_HISTOGRAM_BUCKETS; i++)
+        maxBucket = MAX(maxBucket, m_iHistogram[i]);
+
+    for (int i = 0; i < MOVEPROF_HISTOGRAM_BUCKETS; i++)
+    {
+        char range[32];
+        if (i == 0)
+            Q_strncpy(range, "0", sizeof(range));
+        else if (i == MOVEPROF_HISTOGRAM_BUCKETS - 1)
+            Q_snprintf(range, sizeof(range), "%i+", 1 << (i - 1));
+        else
+            Q_snprintf(range, sizeof(range), "%i-%i", 1 << (i - 1), (1 << i) - 1);
+
+        char bar[41];
+        const int barLength = m_iHistogram[i] * (sizeof(bar) - 1) / maxBucket;
+        V_memset(bar, '#', barLength);
+        bar[barLength] = '\0';
+
+        Msg("%10s %8i %s\n", range, m_iHistogram[i], bar);
+    }
+
+    if (m_iWorstTick >= 0)
+    {
+        Msg("Worst tick: %i with %i traces at %.1f %.1f %.1f\n", m_iWorstTick, m_iWorstTickTraces,
+            m_vecWorstTickOrigin.x, m_vecWorstTickOrigin.y, m_vecWorstTickOrigin.z);
+    }
+}
+
+bool CMomMovementProfiler::StartCSV(const char *pFileName)
+{
+    StopCSV();
+
+    m_hCSVFile = g_pFullFileSystem->Open(pFileName, "w", "MOD");
+    if (m_hCSVFile == FILESYSTEM_INVALID_HANDLE)
+    {
+        Warning("Failed to open %s for writing!\n", pFileName);
+        return false;
+    }
+
+    g_pFullFileSystem->FPrintf(m_hCSVFile, "tick,player,x,y,z,speed,traces,us");
+    for (int i = 0; i < MOVEPHASE_COUNT; i++)
+        g_pFullFileSystem->FPrintf(m_hCSVFile, ",%s_traces,%s_us", s_pPhaseNames[i], s_pPhaseNames[i]);
+    g_pFullFileSystem->FPrintf(m_hCSVFile, "\n");
+
+    return true;
+}
+
+void CMomMovementProfiler::StopCSV()
+{
+    if (m_hCSVFile == FILESYSTEM_INVALID_HANDLE)
+        return;
+
+    g_pFullFileSystem->Close(m_hCSVFile);
+    m_hCSVFile = FILESYSTEM_INVALID_HANDLE;
+}
+
+static CMomMovementProfiler s_MovementProfiler;
+CMomMovementProfiler *g_pMovementProfiler = &s_MovementProfiler;
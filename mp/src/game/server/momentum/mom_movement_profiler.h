@@ -0,0 +1,109 @@
+#pragma once
+
+#include "igamesystem.h"
+#include "filesystem.h"
+
+// The parts of a movement tick that traces and time get attributed to
+enum MovementPhase_t
+{
+    MOVEPHASE_OTHER = 0, // Anything not covered below (categorize position, ducking, stuck checks...)
+    MOVEPHASE_GROUND,
+    MOVEPHASE_AIR,
+    MOVEPHASE_LADDER,
+    MOVEPHASE_WALLRUN,
+    MOVEPHASE_RAMPFIX,
+
+    MOVEPHASE_COUNT
+};
+
+// Traces per tick histogram buckets: 0, 1, 2-3, 4-7, ... 256+
+#define MOVEPROF_HISTOGRAM_BUCKETS 10
+
+// Counts the traces and time spent in each movement phase per player movement tick, aggregating them
+// into a histogram and optionally dumping every tick to a CSV file. Only active while mom_movement_profile is set.
+class CMomMovementProfiler : public CAutoGameSystem
+{
+  public:
+    CMomMovementProfiler();
+
+    void LevelShutdownPostEntity() OVERRIDE;
+    void Shutdown() OVERRIDE;
+
+    bool IsActive() const { return m_bActive; }
+    // Overrides mom_movement_profile for benchmarks: 1 profiles every tick, 0 none, -1 follows the convar again
+    void SetForced(int iForced) { m_iForced = iForced; }
+
+    int GetTicks() const { return m_iTicks; }
+    int64 GetTotalTraces() const;
+
+    void BeginTick(CBasePlayer *pPlayer);
+    void EndTick();
+
+    void PushPhase(MovementPhase_t phase);
+    void PopPhase();
+
+    void AddTrace() { m_iTickTraces[m_Phases[m_iPhaseDepth]]++; }
+
+    void Reset();
+    void PrintReport();
+
+    bool StartCSV(const char *pFileName);
+    void StopCSV();
+
+  private:
+    // Attributes the time since the last phase change to the current phase
+    void SwitchPhase();
+
+    bool m_bActive;
+    int m_iForced;
+
+    // Current tick
+    int m_iTickPlayer;
+    Vector m_vecTickOrigin;
+    float m_flTickSpeed;
+    MovementPhase_t m_Phases[16];
+    int m_iPhaseDepth;
+    double m_flLastSwitchTime;
+    int m_iTickTraces[MOVEPHASE_COUNT];
+    double m_flTickTime[MOVEPHASE_COUNT];
+
+    // Aggregates
+    int m_iTicks;
+    int m_iTicksOverBudget;
+    int64 m_iTotalTraces[MOVEPHASE_COUNT];
+    double m_flTotalTime[MOVEPHASE_COUNT];
+    int m_iMaxTraces[MOVEPHASE_COUNT];
+    double m_flMaxTime[MOVEPHASE_COUNT];
+    int m_iHistogram[MOVEPROF_HISTOGRAM_BUCKETS];
+
+    int m_iWorstTick;
+    int m_iWorstTickTraces;
+    Vector m_vecWorstTickOrigin;
+
+    FileHandle_t m_hCSVFile;
+};
+
+extern CMomMovementProfiler *g_pMovementProfiler;
+
+// Attributes the traces and time of the enclosing scope to the given movement phase
+class CMovementProfileScope
+{
+  public:
+    CMovementProfileScope(MovementPhase_t phase) : m_bActive(g_pMovementProfiler->IsActive())
+    {
+        if (m_bActive)
+            g_pMovementProfiler->PushPhase(phase);
+    }
+
+    ~CMovementProfileScope()
+    {
+        if (m_bActive)
+            g_pMovementProfiler->PopPhase();
+    }
+
+  private:
+    bool m_bActive;
+};
+
+#define MOVEMENT_PROFILE_PHASE(phase) CMovementProfileScope movementProfileScope_##phase(phase)
+#define MOVEMENT_PROFILE_TRACE() if (g_pMovementProfiler->IsActive()) g_pMovementProfiler->AddTrace()
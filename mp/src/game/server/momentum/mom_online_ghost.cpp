@@ -10,6 +10,7 @@
 #include "weapon/weapon_def.h"
 #include "weapon/weapon_knife.h"
 #include "ghost_client.h"
+#include "mom_lobby_system.h"
 #include "mom_stickybomb.h"
 
 #include "tier0/memdbgon.h"
@@ -34,7 +35,7 @@ static void RefreshGhostData(IConVar *var, const char *pValue, float oldValue)
 static MAKE_CONVAR(mom_ghost_online_lerp, "0.5", FCVAR_REPLICATED | FCVAR_ARCHIVE, "The amount of time to render in the past (in seconds).\n", 0.1f, 2.0f);
 
 static MAKE_TOGGLE_CONVAR(mom_ghost_online_rotations, "0", FCVAR_REPLICATED | FCVAR_ARCHIVE, "Allows wonky rotations of ghosts to be set.\n");
-static MAKE_CONVAR(mom_ghost_online_interp_ticks, "0", FCVAR_REPLICATED | FCVAR_ARCHIVE, "Interpolation ticks to add to rendering online ghosts.\n", 0.0f, 100.0f);
+static MAKE_CONVAR(mom_ghost_online_interp_ticks, "0", FCVAR_REPLICATED | FCVAR_ARCHIVE, "Interpolation ticks to add to the time online ghosts are rendered in the past.\n", 0.0f, 100.0f);
 
 static MAKE_TOGGLE_CONVAR(mom_ghost_online_sounds, "1", FCVAR_REPLICATED | FCVAR_ARCHIVE,
                           "Toggle other player's flashlight sounds. 0 = OFF, 1 = ON.\n");
@@ -54,7 +55,7 @@ static MAKE_TOGGLE_CONVAR_C(mom_ghost_online_flashlights_enable, "1", FCVAR_ARCH
 
 static MAKE_CONVAR(mom_ghost_online_sticky_alpha, "50", FCVAR_ARCHIVE | FCVAR_REPLICATED, "Sets the ghost stickybomb alpha value. 10 = more transparent, 255 = opaque.", 10.0f, 255.0f);
 
-CMomentumOnlineGhostEntity::CMomentumOnlineGhostEntity() : m_pCurrentFrame(nullptr), m_pNextFrame(nullptr), m_cvarPaintSound("mom_paint_apply_sound")
+CMomentumOnlineGhostEntity::CMomentumOnlineGhostEntity() : m_cvarPaintSound("mom_paint_apply_sound")
 {
     ListenForGameEvent("mapfinished_panel_closed");
     m_nGhostButtons = 0;
@@ -64,13 +65,11 @@ CMomentumOnlineGhostEntity::CMomentumOnlineGhostEntity() : m_pCurrentFrame(nullp
 
 CMomentumOnlineGhostEntity::~CMomentumOnlineGhostEntity()
 {
-    m_vecPositionPackets.Purge();
-    m_vecDecalPackets.Purge();
-}
+    // The receive thread must be done with our buffer before it goes away
+    g_pMomentumLobbySystem->UnregisterPositionBuffer(GetSteamID(), GetPositionBuffer());
 
-void CMomentumOnlineGhostEntity::AddPositionFrame(const PositionPacket &newFrame)
-{
-    m_vecPositionPackets.Insert(new ReceivedFrame_t<PositionPacket>(gpGlobals->curtime, newFrame));
+    while (!m_vecDecalPackets.IsEmpty())
+        delete m_vecDecalPackets.RemoveAtHead();
 }
 
 void CMomentumOnlineGhostEntity::AddDecalFrame(const DecalPacket &decal)
@@ -288,9 +287,10 @@ void CMomentumOnlineGhostEntity::Think()
     if (m_pCurrentSpecPlayer)
         HandleGhostFirstPerson();
 
-    // Emulate at the update rate (or slightly slower) for the smoothest interpolation
-    SetNextThink(gpGlobals->curtime + 1.0f / mm_updaterate.GetFloat() + (gpGlobals->interval_per_tick * mom_ghost_online_interp_ticks.GetFloat()));
+    // Interpolated every tick, independent of the rate the packets come in at
+    SetNextThink(gpGlobals->curtime + gpGlobals->interval_per_tick);
 }
+
 void CMomentumOnlineGhostEntity::HandleGhost()
 {
     float flCurtime = gpGlobals->curtime - mom_ghost_online_lerp.GetFloat(); // Render in a predetermined past buffer (allow some dropped packets)
@@ -315,45 +315,25 @@ void CMomentumOnlineGhostEntity::HandleGhost()
         }
     }
 
-    if (!m_vecPositionPackets.IsEmpty())
-    {
-        // The fast-forward logic:
-        // Realistically, we're going to have a buffer of about MOM_GHOST_LERP * update rate. So for 25 updates
-        // in a second, a lerp of 0.1 seconds would make there be about 2.5 packets in the queue at all times.
-        // If there's ever any excess, we need to get rid of it, immediately.
-        int upperBound = static_cast<int>(ceil(mom_ghost_online_lerp.GetFloat() * mm_updaterate.GetFloat()));
-        while (m_vecPositionPackets.Count() > upperBound)
-        {
-            ReceivedFrame_t<PositionPacket> *pTemp = m_vecPositionPackets.RemoveAtHead();
-            delete pTemp;
-        }
-
-        if (!m_pCurrentFrame)
-        {
-            ReceivedFrame_t<PositionPacket> *pHead = m_vecPositionPackets.Head();
-            if (flCurtime > pHead->recvTime)
-                m_pCurrentFrame = m_vecPositionPackets.RemoveAtHead();
-        }
-    }
+    // Render in a predetermined past buffer, so there are packets on both sides of the rendered time
+    const double flRenderTime = Plat_FloatTime() - mom_ghost_online_lerp.GetFloat() -
+                                gpGlobals->interval_per_tick * mom_ghost_online_interp_ticks.GetFloat();
 
-    if (m_pCurrentFrame)
+    PositionPacket frame;
+    if (m_PositionBuffer.Sample(flRenderTime, frame))
     {
-        SetAbsOrigin(m_pCurrentFrame->frame.Position);
+        SetAbsOrigin(frame.Position);
 
-        m_vecLookAngles = m_pCurrentFrame->frame.EyeAngle;
+        m_vecLookAngles = frame.EyeAngle;
         if (m_pCurrentSpecPlayer || mom_ghost_online_rotations.GetBool())
             SetAbsAngles(m_vecLookAngles);
         else
             SetAbsAngles(QAngle(0, m_vecLookAngles.y, m_vecLookAngles.z));
 
-        SetViewOffset(Vector(0, 0, m_pCurrentFrame->frame.ViewOffset));
-        SetAbsVelocity(m_pCurrentFrame->frame.Velocity);
-
-        m_nGhostButtons = m_pCurrentFrame->frame.Buttons;
+        SetViewOffset(Vector(0, 0, frame.ViewOffset));
+        SetAbsVelocity(frame.Velocity);
 
-        // Get rid of our current frame
-        delete m_pCurrentFrame;
-        m_pCurrentFrame = nullptr;
+        m_nGhostButtons = frame.Buttons;
     }
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mom_ghost_base.h"
+#include "mom_ghost_jitter_buffer.h"
 #include "utlqueue.h"
 #include "GameEventListener.h"
 
@@ -14,8 +15,8 @@ public:
     CMomentumOnlineGhostEntity();
     ~CMomentumOnlineGhostEntity();
 
-    // Adds a position frame to the queue for processing
-    void AddPositionFrame(const PositionPacket &newFrame);
+    // The buffer the position packets of this ghost are received into, filled by the lobby's receive thread
+    CGhostJitterBuffer *GetPositionBuffer() { return &m_PositionBuffer; }
     // Adds a decal frame to the queue of processing
     // Note: We have to delay the decal packets to sort of sync up to position, to make spectating more accurate.
     void AddDecalFrame(const DecalPacket &decal);
@@ -67,9 +68,7 @@ private:
 
     void SetIsSpectating(bool bState);
 
-    CUtlQueue<ReceivedFrame_t<PositionPacket>*> m_vecPositionPackets;
-    ReceivedFrame_t<PositionPacket>* m_pCurrentFrame;
-    ReceivedFrame_t<PositionPacket>* m_pNextFrame;
+    CGhostJitterBuffer m_PositionBuffer;
     CUtlQueue<ReceivedFrame_t<DecalPacket>*> m_vecDecalPackets;
 
     ConVarRef m_cvarPaintSound;
@@ -492,9 +492,9 @@ void CMomentumPlayer::Spawn()
 
         // Load startmarks after player spawn
         if (g_pSavelocSystem->LoadStartMarks())
-            DevLog("Loaded startmarks from the savedlocs file!\n");
+            DevLog("Loaded startmarks from the saveloc file!\n");
         else
-            DevWarning("ERROR: Failed loading startmarks from the savedlocs file.\n");
+            DevWarning("ERROR: Failed loading startmarks from the saveloc file.\n");
 
         g_MapZoneSystem.DispatchMapInfo(this);
 
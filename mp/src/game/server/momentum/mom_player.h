@@ -382,6 +382,8 @@ class CMomentumPlayer : public CBasePlayer, public CGameEventListener, public CM
 
     // for detecting bhop
     friend class CMomentumGameMovement;
+    // Saves and restores the movement state around replay simulations
+    friend class CMomReplaySimulator;
     float m_flPunishTime;
     int m_iLastBlock;
 
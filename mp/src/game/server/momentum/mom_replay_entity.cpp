@@ -7,6 +7,7 @@
 #include "util/mom_util.h"
 #include "mom_player_shared.h"
 #include "run/mom_replay_base.h"
+#include "run/mom_replay_frame_store.h"
 #include "in_buttons.h"
 #include "mom_replay_system.h"
 
@@ -28,10 +29,16 @@ END_SEND_TABLE();
 BEGIN_DATADESC(CMomentumReplayGhostEntity)
 END_DATADESC();
 
+ReplayPlaybackState_t::ReplayPlaybackState_t()
+    : m_iTick(0), m_bTimerRunning(false), m_bMapFinished(false), m_bIsInZone(true), m_iCurrentZone(1),
+      m_angLastEyeAngle(vec3_angle), m_flLastSyncVelocity(0), m_nStrafeTicks(0), m_nPerfectSyncTicks(0), m_nAccelTicks(0),
+      m_nOldReplayButtons(0), m_vecLastVel(vec3_origin)
+{
+}
+
 CMomentumReplayGhostEntity::CMomentumReplayGhostEntity()
-    : m_bIsActive(false), m_bReplayFirstPerson(false), m_pPlaybackReplay(nullptr), m_bHasJumped(false),
-      m_flLastSyncVelocity(0), m_nStrafeTicks(0), m_nPerfectSyncTicks(0), m_nAccelTicks(0), m_nOldReplayButtons(0),
-      m_vecLastVel(vec3_origin), m_cvarMapFinMoveEnable("mom_mapfinished_movement_enable")
+    : m_bIsActive(false), m_bReplayFirstPerson(false), m_bRaceGhost(false), m_bRecordedGround(false), m_pPlaybackReplay(nullptr), m_pFrames(nullptr),
+      m_flPlaybackTick(0.0), m_bTeleportedThisTick(false), m_bHasJumped(false), m_vecLastVel(vec3_origin), m_cvarMapFinMoveEnable("mom_mapfinished_movement_enable")
 {
     m_RunStats.Init();
     m_bIsPaused = false;
@@ -47,6 +54,10 @@ void CMomentumReplayGhostEntity::Precache(void) { BaseClass::Precache(); }
 
 void CMomentumReplayGhostEntity::FireGameEvent(IGameEvent *pEvent)
 {
+    // Race ghosts live until the race is cleared
+    if (m_bRaceGhost)
+        return;
+
     if (!Q_strcmp(pEvent->GetName(), "mapfinished_panel_closed"))
     {
         if (pEvent->GetBool("restart"))
@@ -119,13 +130,18 @@ void CMomentumReplayGhostEntity::StartRun(bool firstPerson)
         }
 
         m_iCurrentTick = 0;
-        SetAbsOrigin(m_pPlaybackReplay->GetFrame(m_iCurrentTick)->PlayerOrigin());
+        m_flPlaybackTick = 0.0;
+        m_bTeleportedThisTick = false;
+        SetAbsOrigin(GetCurrentStep().PlayerOrigin());
+
+        m_PlaybackState = ReplayPlaybackState_t();
 
         m_iTotalTicks = m_pPlaybackReplay->GetFrameCount() - 1;
 
         m_Data.m_iCurrentTrack = m_pPlaybackReplay->GetTrackNumber();
 
-        SetNextThink(gpGlobals->curtime + gpGlobals->interval_per_tick);
+        if (!m_bRaceGhost)
+            SetNextThink(gpGlobals->curtime + gpGlobals->interval_per_tick);
     }
     else
     {
@@ -134,30 +150,11 @@ void CMomentumReplayGhostEntity::StartRun(bool firstPerson)
     }
 }
 
-void CMomentumReplayGhostEntity::UpdateStep(int Skip)
-{
-    // Managed by replayui now
-    if (!m_pPlaybackReplay)
-        return;
-
-    if (m_bIsPaused)
-    {
-        if (mom_replay_selection.GetInt() == 1)
-            m_iCurrentTick -= Skip;
-        else if (mom_replay_selection.GetInt() == 2)
-            m_iCurrentTick += Skip;
-    }
-    else
-    {
-        m_iCurrentTick += Skip;
-    }
-
-    m_iCurrentTick = clamp<int>(m_iCurrentTick, 0, m_iTotalTicks);
-}
-
-void CMomentumReplayGhostEntity::LoadFromReplayBase(CMomReplayBase *pReplay)
+void CMomentumReplayGhostEntity::LoadFromReplayBase(CMomReplayBase *pReplay, bool bRaceGhost)
 {
     m_pPlaybackReplay = pReplay;
+    m_pFrames = &pReplay->GetFrameStore();
+    m_bRaceGhost = bRaceGhost;
 
     SetSteamID(pReplay->GetPlayerSteamID());
 
@@ -167,7 +164,19 @@ void CMomentumReplayGhostEntity::LoadFromReplayBase(CMomReplayBase *pReplay)
     m_Data.m_flTickRate = m_pPlaybackReplay->GetTickInterval();
     m_Data.m_iStartTick = m_pPlaybackReplay->GetStartTick();
 
-    m_pPlaybackReplay->SetRunEntity(this);
+    // A shared replay can drive any number of race ghosts, it only points back to the playback ghost
+    if (!m_bRaceGhost)
+        m_pPlaybackReplay->SetRunEntity(this);
+
+    // Replays recorded before frames had the ground state have to trace for it
+    m_bRecordedGround = false;
+    for (int i = 0; i < m_pFrames->Count() && !m_bRecordedGround; i++)
+        m_bRecordedGround = (*m_pFrames)[i].OnGround();
+
+    m_PlaybackState = ReplayPlaybackState_t();
+    m_KeyframeBuildState = ReplayPlaybackState_t();
+    m_vecKeyframes.RemoveAll();
+    m_vecKeyframes.AddToTail(m_PlaybackState);
 }
 
 void CMomentumReplayGhostEntity::Think()
@@ -182,7 +191,40 @@ void CMomentumReplayGhostEntity::Think()
         return;
     }
 
-    if (m_iCurrentTick == m_Data.m_iStartTick)
+    UpdatePlayback();
+
+    // The playback clock takes care of the timescale, so the ghost moves every tick at any speed
+    SetNextThink(gpGlobals->curtime + gpGlobals->interval_per_tick);
+}
+
+void CMomentumReplayGhostEntity::UpdatePlayback()
+{
+    if (!m_bIsActive || !m_pPlaybackReplay)
+        return;
+
+    // Keep building the keyframes while paused too, the replay UI seeks then
+    if (!m_bRaceGhost || m_pCurrentSpecPlayer)
+        BuildKeyframes(REPLAY_KEYFRAME_BUILD_FRAMES);
+
+    const double flLastTick = m_flPlaybackTick;
+
+    if (!AdvancePlaybackClock())
+    {
+        // If we're not looping and we've reached the end of the video then stop and wait for the player
+        // to make a choice about if it should repeat, or end.
+        if (m_pCurrentSpecPlayer && m_iCurrentTick >= m_iTotalTicks)
+        {
+            const CReplayFrame &currentStep = GetCurrentStep();
+            SetAbsOrigin(currentStep.PlayerOrigin());
+            SetGhostAngles(currentStep.EyeAngles());
+            DetermineGhostVisibility();
+            SetAbsVelocity(vec3_origin);
+        }
+        return;
+    }
+
+    const double flStartTick = static_cast<double>(m_Data.m_iStartTick);
+    if (flLastTick < flStartTick && m_flPlaybackTick >= flStartTick)
     {
         m_Data.m_bIsInZone = false;
         m_Data.m_bMapFinished = false;
@@ -200,131 +242,71 @@ void CMomentumReplayGhostEntity::Think()
         }
     }
 
-    float fTimeScale = mom_replay_timescale.GetFloat();
+    // Nobody sees the stats of a race ghost that isn't spectated, they catch up from a keyframe once it is
+    if (!m_bRaceGhost || m_pCurrentSpecPlayer)
+        UpdatePlaybackState();
 
-    // move the ghost
-    if (m_iCurrentTick < 0 || m_iCurrentTick >= m_iTotalTicks)
-    {
-        // If we're not looping and we've reached the end of the video then stop and wait for the player
-        // to make a choice about if it should repeat, or end.
-        if (m_pCurrentSpecPlayer)
-        {
-            CReplayFrame *currentStep = GetCurrentStep();
-            SetAbsOrigin(currentStep->PlayerOrigin());
-            SetGhostAngles(currentStep->EyeAngles());
-            DetermineGhostVisibility();
-            SetAbsVelocity(vec3_origin);
-        }
-    }
+    if (m_pCurrentSpecPlayer)
+        HandleGhostFirstPerson();
     else
-    {
-        if (fTimeScale <= 1.0f)
-            UpdateStep(1);
-        else
-        {
-            // MOM_TODO: IMPORTANT! Remember, this is probably not the proper way of speeding up the replay.
-            // Because it skips the steps that normally the engine would have "compensated".
-            // So it can results to unsmooth results, but this is probably the best you can get.
-            // Until we can find something else to modify timescale properly.
-            // We do it this way, because SetNextThink / engine doesn't allow faster updates at this timescale.
-
-            // Calculate our next step
-            int iNextStep = static_cast<int>(fTimeScale) + 1;
-
-            // Calculate the average of ticks that will be used for the next step or the current one
-            float fTicksAverage = (1.0f - (static_cast<float>(iNextStep) - fTimeScale));
-
-            // If it's null, then we just run the current step
-            if (fTicksAverage == 0.0f)
-            {
-                UpdateStep(iNextStep - 1);
-            }
-
-            // Otherwise if it's 1 we must run the next step
-            else if (fTicksAverage == 1.0f)
-            {
-                UpdateStep(iNextStep);
-            }
-
-            // Else, we calculate when we should be on the next step or the current one
-            else
-            {
-
-                // If we should first update on the next step or not
-                bool bShouldNextStepInstead = false;
-
-                // If the next step that must be run is higher than the current steps:
-                // We invert roles between current steps and next steps.
-                if (fTicksAverage > 0.5f)
-                {
-                    fTicksAverage = 0.5f - (fTicksAverage - 0.5f);
-                    bShouldNextStepInstead = true;
-                }
-
-                // Actually we don't need to check for the tickrate, we will let engine compensate it.
-                float fInvTicksAverage = 1.0f / fTicksAverage;
-
-                int iInvTicksAverage = static_cast<int>(fInvTicksAverage + 0.5f);
-
-                // 1) If the ticks elapsed is higher or equal to the ticks calculated we must run the next step or the
-                // current one depending on the average of current steps and next steps.
-                if (m_iTickElapsed >= iInvTicksAverage)
-                {
-                    // BLOCK1
+        HandleGhost();
+}
 
-                    // If the average of next steps are higher than current steps, the current step must be called here.
-                    // Otherwise the next step must be called.
+bool CMomentumReplayGhostEntity::AdvancePlaybackClock()
+{
+    // Race ghosts keep up with the player, the timescale only applies to the watched replay
+    double flRate = m_bRaceGhost ? 1.0 : mom_replay_timescale.GetFloat();
 
-                    UpdateStep(bShouldNextStepInstead ? (iNextStep - 1) : iNextStep);
+    if (m_bIsPaused)
+    {
+        // Managed by replayui now
+        if (mom_replay_selection.GetInt() == 1)
+            flRate = -flRate;
+        else if (mom_replay_selection.GetInt() != 2)
+            flRate = 0.0;
+    }
 
-                    // Reset our elapsed ticks, to know when we will perform a new current step or a new next step.
-                    // At tick 1, because we're increasing only elapsed ticks after the condition of 1) and not before.
-                    // If we don't do this, we will be in late of 1 tick.
+    const double flNewTick = clamp(m_flPlaybackTick + flRate, 0.0, static_cast<double>(m_iTotalTicks));
+    if (flNewTick == m_flPlaybackTick)
+        return false;
 
-                    /* --------------------------------------------------------------------------------------------------------------------------
-                    For example if m_flTimeScale = 3,5 -> then iInvTicksAverage is equal to 2 (1/0.5), and that we're
-                    resetting iTickElapsed on 0, it means that we will wait 2 ticks before being on that BLOCK1. And we
-                    don't want that because, we want the 1/2 of time the code running on both blocks and not 1/3 on
-                    BLOCK1 then 2/3 on BLOCK2, when timescale is 3,5. If we wait 2 ticks on BLOCK2 and only 1 on BLOCK1,
-                    logically, it won't correspond to 3,5 of m_flTimeScale. So we're doing like this way: iTickElapsed =
-                    1, or iInvTicksAverage = iInvTicksAverage - 1, to make it correspond perfectly to timescale. I hope
-                    you understood what I've meant. If not then contact that XutaxKamay ***** and tell him to fix his
-                    comments.
-                    ------------------------------------------------------------------------------------------------------------------------------
-                    */
+    const int iLastTick = m_iCurrentTick;
+    m_flPlaybackTick = flNewTick;
+    m_iCurrentTick = static_cast<int>(flNewTick);
 
-                    m_iTickElapsed = 1;
-                }
-                else
-                {
+    // Frame i being flagged means the player teleported between frame i - 1 and i,
+    // look at every frame we passed since the rate can skip over more than one
+    m_bTeleportedThisTick = false;
+    const int iFirst = MIN(iLastTick, m_iCurrentTick.Get()) + 1;
+    const int iLast = MAX(iLastTick, m_iCurrentTick.Get());
+    for (int i = iFirst; i <= iLast && !m_bTeleportedThisTick; ++i)
+        m_bTeleportedThisTick = (*m_pFrames)[i].Teleported();
 
-                    // BLOCK2
+    return true;
+}
 
-                    // If the average of next steps are higher than current steps, the next step must be called here.
-                    // Otherwise the current step must be called.
+void CMomentumReplayGhostEntity::SamplePlayback(Vector &origin, QAngle &angles, float &viewOffset) const
+{
+    const CReplayFrame &frame = GetCurrentStep();
+    origin = frame.PlayerOrigin();
+    angles = frame.EyeAngles();
+    viewOffset = frame.PlayerViewOffset();
 
-                    UpdateStep(bShouldNextStepInstead ? (iNextStep) : (iNextStep - 1));
+    const float flFraction = static_cast<float>(m_flPlaybackTick - m_iCurrentTick);
+    if (flFraction <= 0.0f || m_iCurrentTick + 1 >= m_pFrames->Count())
+        return;
 
-                    // Wait for the ticks elapsing before we change to our current step or our next step.
-                    m_iTickElapsed++;
-                }
-            }
-        }
+    // Don't smear the ghost across a teleport
+    const CReplayFrame &nextFrame = (*m_pFrames)[m_iCurrentTick + 1];
+    if (nextFrame.Teleported())
+        return;
 
-        if (m_pCurrentSpecPlayer)
-            HandleGhostFirstPerson();
-        else
-            HandleGhost();
-    }
+    origin = Lerp(flFraction, origin, nextFrame.PlayerOrigin());
+    viewOffset = Lerp(flFraction, viewOffset, nextFrame.PlayerViewOffset());
 
-    if (fTimeScale < 1.0f)
-    {
-        SetNextThink(gpGlobals->curtime + gpGlobals->interval_per_tick * (1.0f / fTimeScale));
-    }
-    else
-    {
-        SetNextThink(gpGlobals->curtime + gpGlobals->interval_per_tick);
-    }
+    const QAngle nextAngles = nextFrame.EyeAngles();
+    for (int i = 0; i < 3; i++)
+        angles[i] = AngleNormalize(angles[i] + AngleDiff(nextAngles[i], angles[i]) * flFraction);
 }
 
 //-----------------------------------------------------------------------------
@@ -334,59 +316,25 @@ void CMomentumReplayGhostEntity::HandleGhostFirstPerson()
 {
     if (m_pCurrentSpecPlayer)
     {
-        CReplayFrame *currentStep = nullptr;
-        CReplayFrame *nextStep = nullptr;
-        CReplayFrame *prevStep = nullptr;
-
-        // MOM_TODO
-        // If the player is in practice, let's stuck the player, if the current tick is between the start and end of
-        // timestamps.
-        /*if (m_SrvData.m_iCurrentTick >= m_iPracticeTimeStampStart &&
-            m_SrvData.m_iCurrentTick <= m_iPracticeTimeStampEnd)
-        {
-            m_SrvData.m_bHasPracticeMode = true;
-            // To get the real tick of where the practice mode have been enabled, we need to add the tick remainder,
-            // but since we want to be stuck at the start of the timestamp and not in the end of our timestamp, we need
-            // to get how many ticks have elapsed between those two, and subtract it. Usually this calculation is
-            // useless if m_iTickRemainder had only increment once in the loop for getting the timestamps.
-            nextStep = currentStep = m_pPlaybackReplay->GetFrame(
-                m_iPracticeTimeStampStart - (m_iTickRemainder - (m_iPracticeTimeStampEnd - m_iPracticeTimeStampStart)));
-        }
-        else*/
-        {
-            // Otherwise process normally.
-            nextStep = GetNextStep();
-            currentStep = GetCurrentStep();
-            prevStep = GetPreviousStep();
+        const CReplayFrame &currentStep = GetCurrentStep();
+        const CReplayFrame &nextStep = (*m_pFrames)[MIN(m_iCurrentTick + 1, m_pFrames->Count() - 1)];
 
-        }
-        SetAbsOrigin(currentStep->PlayerOrigin());
-
-        SetGhostAngles(currentStep->EyeAngles());
-        DetermineGhostVisibility();
+        Vector origin;
+        QAngle angles;
+        float viewOffset;
+        SamplePlayback(origin, angles, viewOffset);
 
-        bool bTeleportedThisFrame = (mom_replay_selection.GetInt() == 1) // Going backwards?
-            ? prevStep->Teleported() : currentStep->Teleported();
+        SetAbsOrigin(origin);
 
-        bool bTeleportedNextFrame = nextStep->Teleported();
+        SetGhostAngles(angles);
+        DetermineGhostVisibility();
 
         Vector interpolatedVel;
 
-        if (!bTeleportedNextFrame)
+        if (!nextStep.Teleported())
         {
-            float fTimeScale = mom_replay_timescale.GetFloat();
-
-            // interpolate vel from difference in origin
-            const Vector &pPlayerCurrentOrigin = currentStep->PlayerOrigin();
-            const Vector &pPlayerNextOrigin = nextStep->PlayerOrigin();
-
-            const float distX = pPlayerNextOrigin.x - pPlayerCurrentOrigin.x;
-            const float distY = pPlayerNextOrigin.y - pPlayerCurrentOrigin.y;
-            const float distZ = pPlayerNextOrigin.z - pPlayerCurrentOrigin.z;
-            const float fDeltaTime = fTimeScale < 1.0f
-                ? gpGlobals->interval_per_tick * (1.0f / fTimeScale) : gpGlobals->interval_per_tick;
-
-            interpolatedVel = Vector(distX, distY, distZ) / fDeltaTime;
+            // The velocity the player had in the run, whatever speed the replay is playing at
+            interpolatedVel = (nextStep.PlayerOrigin() - currentStep.PlayerOrigin()) / gpGlobals->interval_per_tick;
             m_vecLastVel = interpolatedVel;
         }
         else
@@ -395,7 +343,7 @@ void CMomentumReplayGhostEntity::HandleGhostFirstPerson()
             interpolatedVel = m_vecLastVel;
         }
 
-        if (bTeleportedThisFrame)
+        if (m_bTeleportedThisTick)
         {
             // Fix teleporting being interpolated.
             IncrementInterpolationFrame();
@@ -407,12 +355,9 @@ void CMomentumReplayGhostEntity::HandleGhostFirstPerson()
         }
 
         // networked var that allows the replay to control keypress display on the client
-        m_nGhostButtons = currentStep->PlayerButtons();
-
-        if (m_Data.m_bTimerRunning)
-            UpdateStats(interpolatedVel);
+        m_nGhostButtons = currentStep.PlayerButtons();
 
-        SetViewOffset(Vector(0, 0, currentStep->PlayerViewOffset()));
+        SetViewOffset(Vector(0, 0, viewOffset));
 
         HandleDucking();
     }
@@ -443,31 +388,17 @@ void CMomentumReplayGhostEntity::DetermineGhostVisibility()
 
 void CMomentumReplayGhostEntity::HandleGhost()
 {
-    CReplayFrame *currentStep = nullptr;
+    Vector origin;
+    QAngle angles;
+    float viewOffset;
+    SamplePlayback(origin, angles, viewOffset);
 
-    // If the player is in practice, let's stuck the player, if the current tick is between the start and end of
-    // timestamps.
-    /*if (m_SrvData.m_iCurrentTick >= m_iPracticeTimeStampStart && m_SrvData.m_iCurrentTick <= m_iPracticeTimeStampEnd)
-    {
-        m_SrvData.m_bHasPracticeMode = true;
-        // To get the real tick of where the practice mode have been enabled, we need to add the tick remainder,
-        // but since we want to be stuck at the start of the timestamp and not in the end of our timestamp, we need to
-        // get how many ticks have elapsed between those two, and subtract it. Usually this calculation is useless if
-        // m_iTickRemainder had only increment once in the loop for getting the timestamps.
-        currentStep = m_pPlaybackReplay->GetFrame(
-            m_iPracticeTimeStampStart - (m_iTickRemainder - (m_iPracticeTimeStampEnd - m_iPracticeTimeStampStart)));
-    }
-    else*/
-    {
-        // Otherwise process normally.
-        currentStep = GetCurrentStep();
+    if (m_bTeleportedThisTick)
+        IncrementInterpolationFrame();
 
-    }
-
-    SetAbsOrigin(currentStep->PlayerOrigin());
-    SetAbsAngles(QAngle(currentStep->EyeAngles().x /
-                        GHOST_PITCH_REDUCTION_VALUE, // we divide x angle (pitch) by 10 so the ghost doesn't look really stupid
-                        currentStep->EyeAngles().y, currentStep->EyeAngles().z));
+    SetAbsOrigin(origin);
+    // we divide x angle (pitch) by 10 so the ghost doesn't look really stupid
+    SetAbsAngles(QAngle(angles.x / GHOST_PITCH_REDUCTION_VALUE, angles.y, angles.z));
 
     // remove the nodraw effects
     UnHideGhost();
@@ -475,39 +406,18 @@ void CMomentumReplayGhostEntity::HandleGhost()
 
 void CMomentumReplayGhostEntity::UpdateStats(const Vector &ghostVel)
 {
-    // --- STRAFE SYNC ---
-    // calculate strafe sync based on replay ghost's movement, in order to update the player's HUD
-
-    auto currentStep = GetCurrentStep();
-    float SyncVelocity = ghostVel.Length2DSqr(); // we always want HVEL for checking velocity sync
-
-    if (GetGroundEntity() == nullptr) // The ghost is in the air
+    // The strafe sync is accumulated from the replay frames by the playback state, see StepPlaybackState
+    if (m_PlaybackState.m_nStrafeTicks && m_PlaybackState.m_nAccelTicks && m_PlaybackState.m_nPerfectSyncTicks)
     {
-        m_bHasJumped = false;
-
-        if (EyeAngles().y > m_angLastEyeAngle.y) // player turned left
-        {
-            m_nStrafeTicks++;
-            if ((currentStep->PlayerButtons() & IN_MOVELEFT) && !(currentStep->PlayerButtons() & IN_MOVERIGHT))
-                m_nPerfectSyncTicks++;
-            if (SyncVelocity > m_flLastSyncVelocity)
-                m_nAccelTicks++;
-        }
-        else if (EyeAngles().y < m_angLastEyeAngle.y) // player turned right
-        {
-            m_nStrafeTicks++;
-            if ((currentStep->PlayerButtons() & IN_MOVERIGHT) && !(currentStep->PlayerButtons() & IN_MOVELEFT))
-                m_nPerfectSyncTicks++;
-            if (SyncVelocity > m_flLastSyncVelocity)
-                m_nAccelTicks++;
-        }
+        m_Data.m_flStrafeSync = (float(m_PlaybackState.m_nPerfectSyncTicks) / float(m_PlaybackState.m_nStrafeTicks)) *
+                                100.0f; // ticks strafing perfectly / ticks strafing
+        m_Data.m_flStrafeSync2 = (float(m_PlaybackState.m_nAccelTicks) / float(m_PlaybackState.m_nStrafeTicks)) *
+                                 100.0f; // ticks gaining speed / ticks strafing
     }
-    if (m_nStrafeTicks && m_nAccelTicks && m_nPerfectSyncTicks)
+    else
     {
-        m_Data.m_flStrafeSync =
-            (float(m_nPerfectSyncTicks) / float(m_nStrafeTicks)) * 100.0f; // ticks strafing perfectly / ticks strafing
-        m_Data.m_flStrafeSync2 =
-            (float(m_nAccelTicks) / float(m_nStrafeTicks)) * 100.0f; // ticks gaining speed / ticks strafing
+        m_Data.m_flStrafeSync = 0.0f;
+        m_Data.m_flStrafeSync2 = 0.0f;
     }
 
     // --- JUMP AND STRAFE COUNTER ---
@@ -524,10 +434,156 @@ void CMomentumReplayGhostEntity::UpdateStats(const Vector &ghostVel)
     /*if ((currentStep->PlayerButtons() & IN_MOVELEFT && !(m_nOldReplayButtons & IN_MOVELEFT)) ||
         (currentStep->PlayerButtons() & IN_MOVERIGHT && !(m_nOldReplayButtons & IN_MOVERIGHT)))
         m_SrvData.m_iTotalStrafes++;*/
+}
+
+void CMomentumReplayGhostEntity::UpdatePlaybackState()
+{
+    const int iTargetTick = m_iCurrentTick + 1;
+    const int iDistance = iTargetTick - m_PlaybackState.m_iTick;
+
+    // Stepping forward is cheaper than going back to a keyframe as long as we don't pass one
+    if (iDistance >= 0 && iDistance <= REPLAY_KEYFRAME_INTERVAL)
+    {
+        while (m_PlaybackState.m_iTick < iTargetTick)
+            StepPlaybackState(m_PlaybackState);
+    }
+    else
+    {
+        ComputePlaybackState(m_iCurrentTick, m_PlaybackState);
+    }
+
+    UpdateStats(m_vecLastVel);
+}
+
+void CMomentumReplayGhostEntity::ComputePlaybackState(int tick, ReplayPlaybackState_t &state)
+{
+    const int iTargetTick = clamp<int>(tick, 0, m_pPlaybackReplay->GetFrameCount() - 1) + 1;
+
+    // Seeking past what has been built so far builds up to there, so the frames are only stepped through once
+    if (m_KeyframeBuildState.m_iTick < iTargetTick)
+        BuildKeyframes(iTargetTick - m_KeyframeBuildState.m_iTick);
+
+    const int iKeyframe = MIN(iTargetTick / REPLAY_KEYFRAME_INTERVAL, m_vecKeyframes.Count() - 1);
+    state = m_vecKeyframes[iKeyframe];
+
+    while (state.m_iTick < iTargetTick)
+    {
+        StepPlaybackState(state);
+    }
+}
+
+void CMomentumReplayGhostEntity::StepPlaybackState(ReplayPlaybackState_t &state)
+{
+    const int iFrameCount = m_pFrames->Count();
+    const int i = state.m_iTick;
+    if (i >= iFrameCount)
+        return;
+
+    const int iStartTick = m_pPlaybackReplay->GetStartTick();
+    const int iStopTick = m_pPlaybackReplay->GetStopTick();
+
+    // --- TIMER AND ZONES ---
+    state.m_bTimerRunning = i >= iStartTick && i < iStopTick;
+    state.m_bMapFinished = i >= iStopTick;
+
+    if (i < iStartTick)
+    {
+        state.m_bIsInZone = true;
+        state.m_iCurrentZone = 1;
+    }
+    else if (i >= iStopTick)
+    {
+        state.m_bIsInZone = true;
+        state.m_iCurrentZone = 0; // End zone
+    }
+    else
+    {
+        // Stages are entered in order, at the times the run stats recorded
+        const auto pRunStats = m_pPlaybackReplay->GetRunStats();
+        const int iTotalZones = pRunStats->GetTotalZones();
+        while (state.m_iCurrentZone < iTotalZones)
+        {
+            const int iEnterTick = pRunStats->GetZoneEnterTick(state.m_iCurrentZone + 1);
+            if (!iEnterTick || iStartTick + iEnterTick > i)
+                break;
+
+            state.m_iCurrentZone++;
+        }
+
+        state.m_bIsInZone = false;
+    }
+
+    // --- STRAFE SYNC ---
+    // calculate strafe sync based on replay ghost's movement, in order to update the player's HUD
+    const CReplayFrame &frame = (*m_pFrames)[i];
 
-    m_flLastSyncVelocity = SyncVelocity;
-    m_angLastEyeAngle = EyeAngles();
-    m_nOldReplayButtons = currentStep->PlayerButtons();
+    if (i + 1 < iFrameCount)
+    {
+        const CReplayFrame &nextFrame = (*m_pFrames)[i + 1];
+        if (!nextFrame.Teleported())
+            state.m_vecLastVel = (nextFrame.PlayerOrigin() - frame.PlayerOrigin()) / m_pPlaybackReplay->GetTickInterval();
+    }
+
+    const float SyncVelocity = state.m_vecLastVel.Length2DSqr(); // we always want HVEL for checking velocity sync
+    const QAngle angEyes = frame.EyeAngles();
+    const int iButtons = frame.PlayerButtons();
+
+    if (state.m_bTimerRunning && !IsFrameOnGround(frame)) // The ghost is in the air
+    {
+        if (angEyes.y > state.m_angLastEyeAngle.y) // player turned left
+        {
+            state.m_nStrafeTicks++;
+            if ((iButtons & IN_MOVELEFT) && !(iButtons & IN_MOVERIGHT))
+                state.m_nPerfectSyncTicks++;
+            if (SyncVelocity > state.m_flLastSyncVelocity)
+                state.m_nAccelTicks++;
+        }
+        else if (angEyes.y < state.m_angLastEyeAngle.y) // player turned right
+        {
+            state.m_nStrafeTicks++;
+            if ((iButtons & IN_MOVERIGHT) && !(iButtons & IN_MOVELEFT))
+                state.m_nPerfectSyncTicks++;
+            if (SyncVelocity > state.m_flLastSyncVelocity)
+                state.m_nAccelTicks++;
+        }
+    }
+
+    state.m_flLastSyncVelocity = SyncVelocity;
+    state.m_angLastEyeAngle = angEyes;
+    state.m_nOldReplayButtons = iButtons;
+
+    state.m_iTick++;
+}
+
+void CMomentumReplayGhostEntity::BuildKeyframes(int iMaxFrames)
+{
+    const int iFrameCount = m_pFrames->Count();
+    for (int i = 0; i < iMaxFrames && m_KeyframeBuildState.m_iTick < iFrameCount; i++)
+    {
+        StepPlaybackState(m_KeyframeBuildState);
+
+        // Remember the state every so often so seeking doesn't have to go through the whole replay
+        if (m_KeyframeBuildState.m_iTick == m_vecKeyframes.Count() * REPLAY_KEYFRAME_INTERVAL)
+            m_vecKeyframes.AddToTail(m_KeyframeBuildState);
+    }
+}
+
+// The ghost is teleported around every tick so its ground entity can't be trusted, check the frame itself instead
+bool CMomentumReplayGhostEntity::IsFrameOnGround(const CReplayFrame &frame)
+{
+    if (m_bRecordedGround)
+        return frame.OnGround();
+
+    // Holding duck doesn't mean the hull is ducked yet, the lowered view the frame recorded is closer to it
+    const Vector vecOrigin = frame.PlayerOrigin();
+    const bool bDucked = frame.PlayerViewOffset() < VEC_VIEW.z;
+
+    trace_t tr;
+    UTIL_TraceHull(vecOrigin, vecOrigin - Vector(0, 0, 2), bDucked ? VEC_DUCK_HULL_MIN : VEC_HULL_MIN,
+                   bDucked ? VEC_DUCK_HULL_MAX : VEC_HULL_MAX, MASK_PLAYERSOLID_BRUSHONLY, this,
+                   COLLISION_GROUP_PLAYER_MOVEMENT, &tr);
+
+    return tr.fraction < 1.0f && !tr.startsolid && tr.plane.normal.z >= 0.7f;
 }
 
 void CMomentumReplayGhostEntity::GoToTick(int tick)
@@ -535,7 +591,14 @@ void CMomentumReplayGhostEntity::GoToTick(int tick)
     if (tick >= 0 && tick <= m_iTotalTicks)
     {
         m_iCurrentTick = tick;
-        m_Data.m_bMapFinished = false;
+        m_flPlaybackTick = tick;
+
+        ComputePlaybackState(tick, m_PlaybackState);
+        m_Data.m_bTimerRunning = m_PlaybackState.m_bTimerRunning;
+        m_Data.m_bMapFinished = m_PlaybackState.m_bMapFinished;
+        m_Data.m_bIsInZone = m_PlaybackState.m_bIsInZone;
+        m_Data.m_iCurrentZone = m_PlaybackState.m_iCurrentZone;
+        UpdateStats(m_vecLastVel);
 
         // Teleport to the new tick
         CReplayFrame *pNewStep = m_pPlaybackReplay->GetFrame(tick);
@@ -568,49 +631,9 @@ void CMomentumReplayGhostEntity::EndRun()
     Remove();
 }
 
-CReplayFrame* CMomentumReplayGhostEntity::GetCurrentStep()
-{
-    return m_pPlaybackReplay->GetFrame(max(min(m_iCurrentTick, m_pPlaybackReplay->GetFrameCount() - 1), 0));
-}
-
-CReplayFrame *CMomentumReplayGhostEntity::GetNextStep()
+const CReplayFrame &CMomentumReplayGhostEntity::GetCurrentStep() const
 {
-    int nextStep = m_iCurrentTick;
-
-    if (mom_replay_selection.GetInt() == 1 && m_bIsPaused)
-    {
-        --nextStep;
-
-        nextStep = max(nextStep, 0);
-    }
-    else
-    {
-        ++nextStep;
-
-        nextStep = min(nextStep, m_pPlaybackReplay->GetFrameCount() - 1);
-    }
-
-    return m_pPlaybackReplay->GetFrame(nextStep);
-}
-
-CReplayFrame *CMomentumReplayGhostEntity::GetPreviousStep()
-{
-    int nextStep = m_iCurrentTick;
-
-    if (mom_replay_selection.GetInt() == 1 && m_bIsPaused)
-    {
-        ++nextStep;
-
-        nextStep = min(nextStep, m_pPlaybackReplay->GetFrameCount() - 1);
-    }
-    else
-    {
-        --nextStep;
-
-        nextStep = max(nextStep, 0);
-    }
-
-    return m_pPlaybackReplay->GetFrame(nextStep);
+    return (*m_pFrames)[clamp<int>(m_iCurrentTick, 0, m_pFrames->Count() - 1)];
 }
 
 void CMomentumReplayGhostEntity::OnZoneEnter(CTriggerZone *pTrigger)
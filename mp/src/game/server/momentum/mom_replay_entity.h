@@ -6,6 +6,31 @@
 class CMomRunStats;
 class CMomReplayBase;
 class CReplayFrame;
+class CReplayFrameStore;
+
+// Ticks between the playback state keyframes, seeking never has to step through more frames than this
+#define REPLAY_KEYFRAME_INTERVAL 256
+// Frames the keyframes are built ahead by every tick, so a long replay is covered shortly after loading
+#define REPLAY_KEYFRAME_BUILD_FRAMES 2048
+
+// The run state of a replay that can't be read from a single frame, accumulated frame by frame
+struct ReplayPlaybackState_t
+{
+    ReplayPlaybackState_t();
+
+    int m_iTick; // Every frame before this one has been accounted for
+
+    bool m_bTimerRunning;
+    bool m_bMapFinished;
+    bool m_bIsInZone;
+    int m_iCurrentZone;
+
+    // for faking strafe sync calculations
+    QAngle m_angLastEyeAngle;
+    float m_flLastSyncVelocity;
+    int m_nStrafeTicks, m_nPerfectSyncTicks, m_nAccelTicks, m_nOldReplayButtons;
+    Vector m_vecLastVel;
+};
 
 class CMomentumReplayGhostEntity : public CMomentumGhostBaseEntity, public CGameEventListener
 {
@@ -17,14 +42,16 @@ class CMomentumReplayGhostEntity : public CMomentumGhostBaseEntity, public CGame
     CMomentumReplayGhostEntity();
     ~CMomentumReplayGhostEntity();
 
-    // Increments the steps intelligently.
-    void UpdateStep(int Skip);
-
-    void LoadFromReplayBase(CMomReplayBase *pReplay);
+    // Race ghosts share their replay with other ghosts and are advanced by the replay system instead of thinking
+    void LoadFromReplayBase(CMomReplayBase *pReplay, bool bRaceGhost = false);
 
     void StartRun(bool firstPerson = false);
     void EndRun();
 
+    // Advances the playback by one tick, from Think or the replay system's race pass
+    void UpdatePlayback();
+    bool IsRaceGhost() const { return m_bRaceGhost; }
+
     void SetGhostAngles(QAngle angles);
     void DetermineGhostVisibility();
 
@@ -33,11 +60,10 @@ class CMomentumReplayGhostEntity : public CMomentumGhostBaseEntity, public CGame
     void UpdateStats(const Vector &ghostVel) OVERRIDE; // for hud display..
     bool IsReplayGhost() const OVERRIDE { return true; }
 
+    // Seeks to the tick, restoring the timer, zone and strafe sync state of that tick
     void GoToTick(int tick);
 
-    CReplayFrame* GetCurrentStep();
-    CReplayFrame *GetNextStep();
-    CReplayFrame *GetPreviousStep();
+    const CReplayFrame &GetCurrentStep() const;
 
     bool IsReplayEnt() { return true; }
 
@@ -63,17 +89,40 @@ class CMomentumReplayGhostEntity : public CMomentumGhostBaseEntity, public CGame
     void CreateTrail() OVERRIDE;
 
   private:
+    // Moves the playback clock by the timescale (or the replay UI's stepping while paused), returns false if it didn't move
+    bool AdvancePlaybackClock();
+    // Interpolates the frames around the playback clock
+    void SamplePlayback(Vector &origin, QAngle &angles, float &viewOffset) const;
+
+    // Brings m_PlaybackState to the current tick, stepping forward when playing and restoring from a keyframe otherwise
+    void UpdatePlaybackState();
+    // Computes the playback state of the tick from the closest keyframe before it
+    void ComputePlaybackState(int tick, ReplayPlaybackState_t &state);
+    // Accounts for the next frame of the state
+    void StepPlaybackState(ReplayPlaybackState_t &state);
+    // Steps the keyframe builder by up to iMaxFrames frames, adding the keyframes it passes
+    void BuildKeyframes(int iMaxFrames);
+    bool IsFrameOnGround(const CReplayFrame &frame);
+
     CMomReplayBase *m_pPlaybackReplay;
+    const CReplayFrameStore *m_pFrames;
+
+    // Playback position in frames, m_iCurrentTick is its integer part
+    double m_flPlaybackTick;
+    bool m_bTeleportedThisTick; // Passed a teleport frame in the last clock step
 
     bool m_bHasJumped;
     bool m_bIsActive;
     bool m_bReplayFirstPerson;
+    bool m_bRaceGhost;
+    bool m_bRecordedGround; // The replay's frames have the ground state, see IN_REPLAY_ONGROUND
 
-    // for faking strafe sync calculations
-    QAngle m_angLastEyeAngle;
-    float m_flLastSyncVelocity;
-    int m_nStrafeTicks, m_nPerfectSyncTicks, m_nAccelTicks, m_nOldReplayButtons, m_iTickElapsed;
     Vector m_vecLastVel;
 
+    ReplayPlaybackState_t m_PlaybackState;
+    // Keyframe i is the playback state at tick i * REPLAY_KEYFRAME_INTERVAL, built REPLAY_KEYFRAME_BUILD_FRAMES at a time every tick
+    CUtlVector<ReplayPlaybackState_t> m_vecKeyframes;
+    ReplayPlaybackState_t m_KeyframeBuildState;
+
     ConVarRef m_cvarMapFinMoveEnable;
 };
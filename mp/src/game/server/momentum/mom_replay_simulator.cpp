@@ -0,0 +1,461 @@
+#include "cbase.h"
+
+#include "mom_replay_simulator.h"
+#include "in_buttons.h"
+#include "igamemovement.h"
+#include "movehelper_server.h"
+#include "mom_player.h"
+#include "mom_system_gamemode.h"
+#include "mom_timer.h"
+#include "mom_triggers.h"
+#include "run/mom_replay_base.h"
+#include "run/mom_replay_factory.h"
+#include "run/mom_replay_index.h"
+#include "util/baseautocompletefilelist.h"
+
+#include "tier0/memdbgon.h"
+
+extern ConVar cl_forwardspeed;
+extern ConVar cl_backspeed;
+extern ConVar cl_sidespeed;
+extern ConVar cl_upspeed;
+extern IGameMovement *g_pGameMovement;
+
+// Upwards speed over which the movement doesn't put the player on the ground, same as in the game movement
+#define NON_JUMP_VELOCITY ((g_pGameModeSystem->IsTF2BasedMode()) ? 250.0f : 140.0f)
+
+ReplaySimulationResult_t::ReplaySimulationResult_t()
+    : m_iFramesSimulated(0), m_iFirstDivergence(-1), m_flFirstDivergenceDist(0.0f), m_iDivergentFrames(0),
+      m_flMaxDivergenceDist(0.0f), m_iResyncs(0)
+{
+}
+
+CMomReplaySimulator::CMomReplaySimulator(CMomentumPlayer *pPlayer) : m_pPlayer(pPlayer)
+{
+    SaveState();
+}
+
+CMomReplaySimulator::~CMomReplaySimulator()
+{
+    RestoreState();
+}
+
+void CMomReplaySimulator::SaveState()
+{
+    m_vecSavedOrigin = m_pPlayer->GetAbsOrigin();
+    m_vecSavedVelocity = m_pPlayer->GetAbsVelocity();
+    m_vecSavedBaseVelocity = m_pPlayer->GetBaseVelocity();
+    m_angSavedAngles = m_pPlayer->GetAbsAngles();
+    m_angSavedViewAngles = m_pPlayer->pl.v_angle;
+    m_vecSavedViewOffset = m_pPlayer->GetViewOffset();
+    m_iSavedFlags = m_pPlayer->GetFlags();
+    m_hSavedGroundEntity = m_pPlayer->GetGroundEntity();
+    m_iSavedButtons = m_pPlayer->m_nButtons;
+    m_iSavedOldButtons = m_pPlayer->m_Local.m_nOldButtons;
+    m_bSavedDucked = m_pPlayer->m_Local.m_bDucked;
+    m_bSavedDucking = m_pPlayer->m_Local.m_bDucking;
+    m_bSavedInDuckJump = m_pPlayer->m_Local.m_bInDuckJump;
+    m_flSavedDucktime = m_pPlayer->m_Local.m_flDucktime;
+    m_flSavedDuckJumpTime = m_pPlayer->m_Local.m_flDuckJumpTime;
+    m_flSavedJumpTime = m_pPlayer->m_Local.m_flJumpTime;
+    m_flSavedFallVelocity = m_pPlayer->m_Local.m_flFallVelocity;
+    m_angSavedPunchAngle = m_pPlayer->m_Local.m_vecPunchAngle;
+    m_angSavedPunchAngleVel = m_pPlayer->m_Local.m_vecPunchAngleVel;
+    m_flSavedCurtime = gpGlobals->curtime;
+    m_flSavedFrametime = gpGlobals->frametime;
+
+    m_flSavedSurfaceFriction = m_pPlayer->m_surfaceFriction;
+    m_iSavedSurfaceProps = m_pPlayer->m_surfaceProps;
+    m_pSavedSurfaceData = m_pPlayer->m_pSurfaceData;
+    m_chSavedTextureType = m_pPlayer->m_chTextureType;
+    m_chSavedPreviousTextureType = m_pPlayer->m_chPreviousTextureType;
+
+    m_bSavedIsInZone = m_pPlayer->m_Data.m_bIsInZone;
+    m_iSavedCurrentZone = m_pPlayer->m_Data.m_iCurrentZone;
+    m_iSavedCurrentTrack = m_pPlayer->m_Data.m_iCurrentTrack;
+    m_flSavedLastJumpTime = m_pPlayer->m_Data.m_flLastJumpTime;
+    m_flSavedLastJumpVel = m_pPlayer->m_Data.m_flLastJumpVel;
+    m_flSavedLastJumpZPos = m_pPlayer->m_Data.m_flLastJumpZPos;
+
+    m_iSavedLandTick = m_pPlayer->m_iLandTick;
+    m_iSavedJumpTick = m_pPlayer->m_iJumpTick;
+    m_bSavedDidPlayerBhop = m_pPlayer->m_bDidPlayerBhop;
+    m_iSavedSuccessiveBhops = m_pPlayer->m_iSuccessiveBhops;
+    m_bSavedSurfing = m_pPlayer->m_bSurfing;
+    m_bSavedWasInAir = m_pPlayer->m_bWasInAir;
+    m_vecSavedRampBoardVel = m_pPlayer->m_vecRampBoardVel;
+    m_vecSavedRampLeaveVel = m_pPlayer->m_vecRampLeaveVel;
+    m_vecSavedEscapeVel = m_pPlayer->GetEscapeVel();
+
+    m_iSavedWallRunState = m_pPlayer->m_nWallRunState;
+    m_vecSavedWallNorm = m_pPlayer->m_vecWallNorm;
+    m_flSavedAutoViewTime = m_pPlayer->m_flAutoViewTime;
+    m_bSavedWallRunBumpAhead = m_pPlayer->m_bWallRunBumpAhead;
+    m_vecSavedLastWallRunPos = m_pPlayer->m_vecLastWallRunPos;
+    m_flSavedWallRunTime = m_pPlayer->m_Local.m_flWallRunTime;
+    m_flSavedNextWallRunTime = m_pPlayer->m_flNextWallRunTime;
+    m_flSavedCoyoteTime = m_pPlayer->m_flCoyoteTime;
+    m_iSavedAirJumpState = m_pPlayer->m_nAirJumpState;
+    m_bSavedIsPowerSliding = m_pPlayer->m_bIsPowerSliding;
+    m_flSavedSlideBoostCooldown = m_pPlayer->m_Local.m_slideBoostCooldown;
+    m_flSavedLurchTimer = m_pPlayer->m_Local.m_lurchTimer;
+    m_flSavedStamina = m_pPlayer->m_flStamina;
+    m_hSavedSlideTrigger = m_pPlayer->m_CurrentSlideTrigger;
+}
+
+void CMomReplaySimulator::RestoreState()
+{
+    m_pPlayer->SetAbsOrigin(m_vecSavedOrigin);
+    m_pPlayer->SetAbsVelocity(m_vecSavedVelocity);
+    m_pPlayer->SetBaseVelocity(m_vecSavedBaseVelocity);
+    m_pPlayer->SetAbsAngles(m_angSavedAngles);
+    m_pPlayer->pl.v_angle = m_angSavedViewAngles;
+    m_pPlayer->SetViewOffset(m_vecSavedViewOffset);
+    m_pPlayer->RemoveFlag(~0);
+    m_pPlayer->AddFlag(m_iSavedFlags);
+    m_pPlayer->SetGroundEntity(m_hSavedGroundEntity.Get());
+    m_pPlayer->m_nButtons = m_iSavedButtons;
+    m_pPlayer->m_Local.m_nOldButtons = m_iSavedOldButtons;
+    m_pPlayer->m_Local.m_bDucked = m_bSavedDucked;
+    m_pPlayer->m_Local.m_bDucking = m_bSavedDucking;
+    m_pPlayer->m_Local.m_bInDuckJump = m_bSavedInDuckJump;
+    m_pPlayer->m_Local.m_flDucktime = m_flSavedDucktime;
+    m_pPlayer->m_Local.m_flDuckJumpTime = m_flSavedDuckJumpTime;
+    m_pPlayer->m_Local.m_flJumpTime = m_flSavedJumpTime;
+    m_pPlayer->m_Local.m_flFallVelocity = m_flSavedFallVelocity;
+    m_pPlayer->m_Local.m_vecPunchAngle = m_angSavedPunchAngle;
+    m_pPlayer->m_Local.m_vecPunchAngleVel = m_angSavedPunchAngleVel;
+
+    m_pPlayer->m_surfaceFriction = m_flSavedSurfaceFriction;
+    m_pPlayer->m_surfaceProps = m_iSavedSurfaceProps;
+    m_pPlayer->m_pSurfaceData = m_pSavedSurfaceData;
+    m_pPlayer->m_chTextureType = m_chSavedTextureType;
+    m_pPlayer->m_chPreviousTextureType = m_chSavedPreviousTextureType;
+
+    m_pPlayer->m_Data.m_bIsInZone = m_bSavedIsInZone;
+    m_pPlayer->m_Data.m_iCurrentZone = m_iSavedCurrentZone;
+    m_pPlayer->m_Data.m_iCurrentTrack = m_iSavedCurrentTrack;
+    m_pPlayer->m_Data.m_flLastJumpTime = m_flSavedLastJumpTime;
+    m_pPlayer->m_Data.m_flLastJumpVel = m_flSavedLastJumpVel;
+    m_pPlayer->m_Data.m_flLastJumpZPos = m_flSavedLastJumpZPos;
+
+    m_pPlayer->m_iLandTick = m_iSavedLandTick;
+    m_pPlayer->m_iJumpTick = m_iSavedJumpTick;
+    m_pPlayer->m_bDidPlayerBhop = m_bSavedDidPlayerBhop;
+    m_pPlayer->m_iSuccessiveBhops = m_iSavedSuccessiveBhops;
+    m_pPlayer->m_bSurfing = m_bSavedSurfing;
+    m_pPlayer->m_bWasInAir = m_bSavedWasInAir;
+    m_pPlayer->m_vecRampBoardVel = m_vecSavedRampBoardVel;
+    m_pPlayer->m_vecRampLeaveVel = m_vecSavedRampLeaveVel;
+    m_pPlayer->SetEscapeVel(m_vecSavedEscapeVel);
+
+    m_pPlayer->m_nWallRunState = static_cast<WallRunState>(m_iSavedWallRunState);
+    m_pPlayer->m_vecWallNorm = m_vecSavedWallNorm;
+    m_pPlayer->m_flAutoViewTime = m_flSavedAutoViewTime;
+    m_pPlayer->m_bWallRunBumpAhead = m_bSavedWallRunBumpAhead;
+    m_pPlayer->m_vecLastWallRunPos = m_vecSavedLastWallRunPos;
+    m_pPlayer->m_Local.m_flWallRunTime = m_flSavedWallRunTime;
+    m_pPlayer->m_flNextWallRunTime = m_flSavedNextWallRunTime;
+    m_pPlayer->m_flCoyoteTime = m_flSavedCoyoteTime;
+    m_pPlayer->m_nAirJumpState = static_cast<AirJumpState>(m_iSavedAirJumpState);
+    m_pPlayer->m_bIsPowerSliding = m_bSavedIsPowerSliding;
+    m_pPlayer->m_Local.m_slideBoostCooldown = m_flSavedSlideBoostCooldown;
+    m_pPlayer->m_Local.m_lurchTimer = m_flSavedLurchTimer;
+    m_pPlayer->m_flStamina = m_flSavedStamina;
+    m_pPlayer->m_CurrentSlideTrigger = m_hSavedSlideTrigger;
+
+    if (m_iSavedFlags & FL_DUCKING)
+        m_pPlayer->SetCollisionBounds(VEC_DUCK_HULL_MIN_SCALED(m_pPlayer), VEC_DUCK_HULL_MAX_SCALED(m_pPlayer));
+    else
+        m_pPlayer->SetCollisionBounds(VEC_HULL_MIN_SCALED(m_pPlayer), VEC_HULL_MAX_SCALED(m_pPlayer));
+
+    gpGlobals->curtime = m_flSavedCurtime;
+    gpGlobals->frametime = m_flSavedFrametime;
+}
+
+void CMomReplaySimulator::SyncToFrame(CMomReplayBase *pReplay, int iFrame)
+{
+    const CReplayFrameStore &frames = pReplay->GetFrameStore();
+    const CReplayFrame &frame = frames[iFrame];
+
+    // The velocity the frame was reached with, the frames after it are what's being checked.
+    // Teleports don't tell what they did to the velocity, the player keeps what it had like most teleports do.
+    if (!iFrame)
+        m_pPlayer->SetAbsVelocity(vec3_origin);
+    else if (!frame.Teleported())
+        m_pPlayer->SetAbsVelocity((frame.PlayerOrigin() - frames[iFrame - 1].PlayerOrigin()) / pReplay->GetTickInterval());
+
+    m_pPlayer->SetAbsOrigin(frame.PlayerOrigin());
+
+    const bool bDucked = frame.PlayerViewOffset() <= VEC_DUCK_VIEW_SCALED(m_pPlayer).z + 0.1f;
+    m_pPlayer->m_Local.m_bDucked = bDucked;
+    m_pPlayer->m_Local.m_bDucking = false;
+    m_pPlayer->m_Local.m_bInDuckJump = false;
+    m_pPlayer->SetViewOffset(Vector(0, 0, frame.PlayerViewOffset()));
+    if (bDucked)
+    {
+        m_pPlayer->AddFlag(FL_DUCKING);
+        m_pPlayer->SetCollisionBounds(VEC_DUCK_HULL_MIN_SCALED(m_pPlayer), VEC_DUCK_HULL_MAX_SCALED(m_pPlayer));
+    }
+    else
+    {
+        m_pPlayer->RemoveFlag(FL_DUCKING);
+        m_pPlayer->SetCollisionBounds(VEC_HULL_MIN_SCALED(m_pPlayer), VEC_HULL_MAX_SCALED(m_pPlayer));
+    }
+
+    // Find the ground the same way the movement does, so a resync on the ground doesn't skip a tick of friction
+    trace_t tr;
+    UTIL_TraceHull(frame.PlayerOrigin(), frame.PlayerOrigin() - Vector(0, 0, 2), m_pPlayer->CollisionProp()->OBBMins(),
+                   m_pPlayer->CollisionProp()->OBBMaxs(), MASK_PLAYERSOLID, m_pPlayer, COLLISION_GROUP_PLAYER_MOVEMENT, &tr);
+
+    const bool bOnGround = tr.m_pEnt && tr.fraction < 1.0f && !tr.startsolid && tr.plane.normal.z >= 0.7f &&
+                           m_pPlayer->GetAbsVelocity().z <= NON_JUMP_VELOCITY;
+    m_pPlayer->SetGroundEntity(bOnGround ? tr.m_pEnt : nullptr);
+}
+
+void CMomReplaySimulator::SimulateFrame(CMomReplayBase *pReplay, int iFrame)
+{
+    // Frames are recorded after the command ran, so the frame holds the command that moved the player into it
+    const CReplayFrameStore &frames = pReplay->GetFrameStore();
+    const CReplayFrame &frame = frames[iFrame];
+    const int iButtons = frame.PlayerButtons() & ~(IN_REPLAY_TELEPORTED | IN_REPLAY_ONGROUND);
+    const int iOldButtons = frames[iFrame - 1].PlayerButtons() & ~(IN_REPLAY_TELEPORTED | IN_REPLAY_ONGROUND);
+
+    // The replay doesn't store the move values, rebuild them from the keys like the client does
+    float flForwardMove = 0.0f, flSideMove = 0.0f, flUpMove = 0.0f;
+    if (iButtons & IN_FORWARD)
+        flForwardMove += cl_forwardspeed.GetFloat();
+    if (iButtons & IN_BACK)
+        flForwardMove -= cl_backspeed.GetFloat();
+    if (iButtons & IN_MOVERIGHT)
+        flSideMove += cl_sidespeed.GetFloat();
+    if (iButtons & IN_MOVELEFT)
+        flSideMove -= cl_sidespeed.GetFloat();
+    if (iButtons & IN_JUMP)
+        flUpMove += cl_upspeed.GetFloat();
+
+    m_pPlayer->m_nButtons = iButtons;
+    m_pPlayer->m_Local.m_nOldButtons = iOldButtons;
+    m_pPlayer->pl.v_angle = frame.EyeAngles();
+
+    CMoveData move;
+    move.m_bFirstRunOfFunctions = false; // No sounds or effects
+    move.m_bGameCodeMovedPlayer = false;
+    move.m_nPlayerHandle = m_pPlayer;
+    move.m_nImpulseCommand = 0;
+    move.m_vecViewAngles = frame.EyeAngles();
+    move.m_vecAbsViewAngles = frame.EyeAngles();
+    move.m_vecAngles = frame.EyeAngles();
+    move.m_vecOldAngles = frames[iFrame - 1].EyeAngles();
+    move.m_nButtons = iButtons;
+    move.m_nOldButtons = iOldButtons;
+    move.m_flForwardMove = flForwardMove;
+    move.m_flSideMove = flSideMove;
+    move.m_flUpMove = flUpMove;
+    move.m_flClientMaxSpeed = m_pPlayer->MaxSpeed();
+    move.m_vecVelocity = m_pPlayer->GetAbsVelocity();
+    move.SetAbsOrigin(m_pPlayer->GetAbsOrigin());
+    move.m_flConstraintRadius = 0.0f;
+
+    g_pGameMovement->ProcessMovement(m_pPlayer, &move);
+
+    m_pPlayer->SetAbsOrigin(move.GetAbsOrigin());
+    m_pPlayer->SetAbsVelocity(move.m_vecVelocity);
+    m_pPlayer->m_Local.m_nOldButtons = iButtons;
+}
+
+void CMomReplaySimulator::Simulate(CMomReplayBase *pReplay, float flTolerance, bool bResync, ReplaySimulationResult_t &result)
+{
+    const CReplayFrameStore &frames = pReplay->GetFrameStore();
+    if (frames.Count() < 2)
+        return;
+
+    MoveHelperServer()->SetHost(m_pPlayer);
+    gpGlobals->frametime = pReplay->GetTickInterval();
+
+    // Triggers don't run, the zones the player stands in mustn't have landing and jumping reset or start the timer
+    m_pPlayer->m_Data.m_bIsInZone = false;
+    SyncToFrame(pReplay, 0);
+
+    for (int i = 1; i < frames.Count(); i++)
+    {
+        const CReplayFrame &frame = frames[i];
+        if (frame.Teleported())
+        {
+            SyncToFrame(pReplay, i);
+            result.m_iResyncs++;
+            continue;
+        }
+
+        gpGlobals->curtime = m_flSavedCurtime + i * pReplay->GetTickInterval();
+        SimulateFrame(pReplay, i);
+        result.m_iFramesSimulated++;
+
+        const float flDist = (m_pPlayer->GetAbsOrigin() - frame.PlayerOrigin()).Length();
+        if (flDist > flTolerance)
+        {
+            if (result.m_iFirstDivergence < 0)
+            {
+                result.m_iFirstDivergence = i;
+                result.m_flFirstDivergenceDist = flDist;
+            }
+
+            result.m_iDivergentFrames++;
+            result.m_flMaxDivergenceDist = MAX(result.m_flMaxDivergenceDist, flDist);
+
+            // Everything after the first divergence follows from it, unless asked to pick up from the recording again
+            if (!bResync)
+                break;
+
+            SyncToFrame(pReplay, i);
+        }
+    }
+
+    MoveHelperServer()->SetHost(nullptr);
+}
+
+CMomReplayVerifier::CMomReplayVerifier() : CAutoGameSystemPerFrame("CMomReplayVerifier"),
+    m_flTolerance(REPLAY_SIMULATION_TOLERANCE), m_bResync(false), m_iVerified(0), m_iDiverged(0), m_iFailed(0), m_flTotalTime(0.0),
+    m_iTotalFrames(0)
+{
+}
+
+void CMomReplayVerifier::QueueReplay(const char *pReplayPath)
+{
+    if (m_vecQueue.IsEmpty())
+    {
+        m_iVerified = m_iDiverged = m_iFailed = 0;
+        m_flTotalTime = 0.0;
+        m_iTotalFrames = 0;
+    }
+
+    m_vecQueue.AddToTail(pReplayPath);
+}
+
+void CMomReplayVerifier::FrameUpdatePostEntityThink()
+{
+    if (m_vecQueue.IsEmpty())
+        return;
+
+    VerifyReplay(m_vecQueue[0].Get());
+    m_vecQueue.Remove(0);
+
+    if (m_vecQueue.IsEmpty())
+        PrintSummary();
+}
+
+void CMomReplayVerifier::LevelShutdownPostEntity()
+{
+    if (!m_vecQueue.IsEmpty())
+    {
+        Warning("Map changed, %i replays were not verified.\n", m_vecQueue.Count());
+        m_vecQueue.Purge();
+        PrintSummary();
+    }
+}
+
+void CMomReplayVerifier::VerifyReplay(const char *pReplayPath)
+{
+    const auto pPlayer = CMomentumPlayer::GetLocalPlayer();
+    // Simulating moves the player around, which must not touch a run in progress
+    if (!pPlayer || g_pMomentumTimer->IsRunning() || pPlayer->GetObserverMode() != OBS_MODE_NONE)
+    {
+        Warning("Skipping %s: stop your timer and stop spectating to verify replays.\n", pReplayPath);
+        m_iFailed++;
+        return;
+    }
+
+    CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(pReplayPath);
+    if (!pReplay)
+    {
+        m_iFailed++;
+        return;
+    }
+
+    if (Q_stricmp(pReplay->GetMapName(), gpGlobals->mapname.ToCStr()) ||
+        !CloseEnough(pReplay->GetTickInterval(), gpGlobals->interval_per_tick, FLT_EPSILON))
+    {
+        Warning("Skipping %s: it is for %s at tick interval %f.\n", pReplayPath, pReplay->GetMapName(), pReplay->GetTickInterval());
+        m_iFailed++;
+        delete pReplay;
+        return;
+    }
+
+    ReplaySimulationResult_t result;
+    const double flStart = Plat_FloatTime();
+    {
+        CMomReplaySimulator simulator(pPlayer);
+        simulator.Simulate(pReplay, m_flTolerance, m_bResync, result);
+    }
+    const double flTime = Plat_FloatTime() - flStart;
+
+    m_iVerified++;
+    m_flTotalTime += flTime;
+    m_iTotalFrames += result.m_iFramesSimulated;
+
+    if (result.m_iFirstDivergence >= 0)
+    {
+        m_iDiverged++;
+        Warning("%s: diverged first at frame %i (%.3f units off, timer start at %i)\n", pReplayPath,
+                result.m_iFirstDivergence, result.m_flFirstDivergenceDist, pReplay->GetStartTick());
+        if (m_bResync)
+            Warning("    resynced, %i of %i frames diverged (max %.3f)\n", result.m_iDivergentFrames,
+                    result.m_iFramesSimulated, result.m_flMaxDivergenceDist);
+    }
+    else
+    {
+        Msg("%s: %i frames match (%i teleports) in %.1f ms\n", pReplayPath, result.m_iFramesSimulated, result.m_iResyncs,
+            flTime * 1000.0);
+    }
+
+    delete pReplay;
+}
+
+void CMomReplayVerifier::PrintSummary()
+{
+    Msg("Verified %i replays (%i diverged, %i skipped), %lld frames in %.2f s\n", m_iVerified, m_iDiverged, m_iFailed,
+        m_iTotalFrames, m_flTotalTime);
+}
+
+static CMomReplayVerifier s_ReplayVerifier;
+CMomReplayVerifier *g_pReplayVerifier = &s_ReplayVerifier;
+
+static void VerifyReplayMovement(const CCommand &args)
+{
+    if (args.ArgC() < 2)
+    {
+        Msg("Usage: mom_replay_verify_movement <replay|*> [tolerance] [resync]\n");
+        return;
+    }
+
+    g_pReplayVerifier->SetTolerance(args.ArgC() > 2 ? Q_atof(args.Arg(2)) : REPLAY_SIMULATION_TOLERANCE);
+    g_pReplayVerifier->SetResync(args.ArgC() > 3 && Q_atoi(args.Arg(3)) != 0);
+
+    // Every local replay of the current map
+    if (FStrEq(args.Arg(1), "*"))
+    {
+        const auto &replays = g_ReplayIndex.GetMapReplays(gpGlobals->mapname.ToCStr());
+        FOR_EACH_DICT_FAST(replays, i)
+        {
+            char replayPath[MAX_PATH];
+            V_ComposeFileName(RECORDING_PATH, replays.GetElementName(i), replayPath, MAX_PATH);
+            g_pReplayVerifier->QueueReplay(replayPath);
+        }
+
+        Msg("Verifying %i replays...\n", replays.Count());
+        return;
+    }
+
+    char filename[MAX_PATH], replayPath[MAX_PATH];
+    Q_strncpy(filename, args.Arg(1), MAX_PATH);
+    V_SetExtension(filename, EXT_RECORDING_FILE, MAX_PATH);
+    V_ComposeFileName(RECORDING_PATH, filename, replayPath, MAX_PATH);
+    g_pReplayVerifier->QueueReplay(replayPath);
+}
+
+CON_COMMAND_AUTOCOMPLETEFILE(mom_replay_verify_movement, VerifyReplayMovement,
+                             "Re-simulates the movement of a replay of the current map (or * for all of them) from its inputs "
+                             "and reports where it first diverges from the recording. With resync, it picks up from the recording "
+                             "after every divergence and counts them all.\n"
+                             "Usage: mom_replay_verify_movement <replay|*> [tolerance] [resync]",
+                             RECORDING_PATH, EXT_RECORDING_FILE);
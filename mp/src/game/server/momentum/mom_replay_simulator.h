@@ -0,0 +1,146 @@
+#pragma once
+
+#include "igamesystem.h"
+
+class CMomentumPlayer;
+class CMomReplayBase;
+class CTriggerSlide;
+
+// Default distance a simulated position may be off the recorded one before the frame counts as diverged
+#define REPLAY_SIMULATION_TOLERANCE 0.1f
+
+struct ReplaySimulationResult_t
+{
+    ReplaySimulationResult_t();
+
+    int m_iFramesSimulated;
+    int m_iFirstDivergence;        // Frame that the movement first ended up off the recording, -1 if it never did
+    float m_flFirstDivergenceDist;
+    int m_iDivergentFrames;
+    float m_flMaxDivergenceDist;
+    int m_iResyncs;                // Teleports in the recording, which the simulation jumps along with
+};
+
+// Re-runs the inputs (buttons and view angles) of a replay through the game movement, frame by frame, and compares
+// every simulated position to the recorded one. The simulation runs as the local player, whose movement state is
+// saved before and restored after. Triggers are not touched, so anything they do to the player shows up as divergence
+// until the next teleport in the recording.
+// This runs inside the game, one replay at a time: the movement traces against the engine's collision of the loaded
+// map, and nothing in this tree loads a map's collision without the engine.
+class CMomReplaySimulator
+{
+  public:
+    CMomReplaySimulator(CMomentumPlayer *pPlayer);
+    ~CMomReplaySimulator();
+
+    // Simulates the replay until it first diverges, or through all of it with bResync, picking up from the recorded
+    // position after every divergence
+    void Simulate(CMomReplayBase *pReplay, float flTolerance, bool bResync, ReplaySimulationResult_t &result);
+
+  private:
+    // Puts the player at the recorded frame, with the velocity it reached that frame with and on the ground below it
+    void SyncToFrame(CMomReplayBase *pReplay, int iFrame);
+    // Runs the command recorded with the frame, moving the player on from the frame before it
+    void SimulateFrame(CMomReplayBase *pReplay, int iFrame);
+
+    void SaveState();
+    void RestoreState();
+
+    CMomentumPlayer *m_pPlayer;
+
+    Vector m_vecSavedOrigin;
+    Vector m_vecSavedVelocity;
+    Vector m_vecSavedBaseVelocity;
+    QAngle m_angSavedAngles;
+    QAngle m_angSavedViewAngles;
+    Vector m_vecSavedViewOffset;
+    int m_iSavedFlags;
+    EHANDLE m_hSavedGroundEntity;
+    int m_iSavedButtons;
+    int m_iSavedOldButtons;
+    bool m_bSavedDucked;
+    bool m_bSavedDucking;
+    bool m_bSavedInDuckJump;
+    float m_flSavedDucktime;
+    float m_flSavedDuckJumpTime;
+    float m_flSavedJumpTime;
+    float m_flSavedFallVelocity;
+    QAngle m_angSavedPunchAngle;
+    QAngle m_angSavedPunchAngleVel;
+    float m_flSavedCurtime;
+    float m_flSavedFrametime;
+
+    // Surface the player stands on
+    float m_flSavedSurfaceFriction;
+    int m_iSavedSurfaceProps;
+    surfacedata_t *m_pSavedSurfaceData;
+    char m_chSavedTextureType;
+    char m_chSavedPreviousTextureType;
+
+    // Run entity data the movement writes, and the zone it reads, which is cleared while simulating so landing and
+    // jumping can't reset or start the timer
+    bool m_bSavedIsInZone;
+    int m_iSavedCurrentZone;
+    int m_iSavedCurrentTrack;
+    float m_flSavedLastJumpTime;
+    float m_flSavedLastJumpVel;
+    float m_flSavedLastJumpZPos;
+
+    // Bhop and ramp state
+    int m_iSavedLandTick;
+    int m_iSavedJumpTick;
+    bool m_bSavedDidPlayerBhop;
+    int m_iSavedSuccessiveBhops;
+    bool m_bSavedSurfing;
+    bool m_bSavedWasInAir;
+    Vector m_vecSavedRampBoardVel;
+    Vector m_vecSavedRampLeaveVel;
+    Vector m_vecSavedEscapeVel;
+
+    // Parkour state
+    int m_iSavedWallRunState;
+    Vector m_vecSavedWallNorm;
+    float m_flSavedAutoViewTime;
+    bool m_bSavedWallRunBumpAhead;
+    Vector m_vecSavedLastWallRunPos;
+    float m_flSavedWallRunTime;
+    float m_flSavedNextWallRunTime;
+    float m_flSavedCoyoteTime;
+    int m_iSavedAirJumpState;
+    bool m_bSavedIsPowerSliding;
+    float m_flSavedSlideBoostCooldown;
+    float m_flSavedLurchTimer;
+    float m_flSavedStamina;
+    CHandle<CTriggerSlide> m_hSavedSlideTrigger;
+};
+
+// Verifies queued replays of the current map by simulating them, one replay per frame so the game keeps running
+class CMomReplayVerifier : public CAutoGameSystemPerFrame
+{
+  public:
+    CMomReplayVerifier();
+
+    void FrameUpdatePostEntityThink() OVERRIDE;
+    void LevelShutdownPostEntity() OVERRIDE;
+
+    void QueueReplay(const char *pReplayPath);
+    void SetTolerance(float flTolerance) { m_flTolerance = flTolerance; }
+    void SetResync(bool bResync) { m_bResync = bResync; }
+    bool IsVerifying() const { return !m_vecQueue.IsEmpty(); }
+
+  private:
+    void VerifyReplay(const char *pReplayPath);
+    void PrintSummary();
+
+    CUtlVector<CUtlString> m_vecQueue;
+    float m_flTolerance;
+    bool m_bResync;
+
+    int m_iVerified;
+    int m_iDiverged;
+    int m_iFailed;
+    double m_flTotalTime;
+    int64 m_iTotalFrames;
+};
+
+extern CMomReplayVerifier *g_pReplayVerifier;
@@ -23,6 +23,9 @@ CMomentumReplaySystem::CMomentumReplaySystem(const char* pName) : CAutoGameSyste
     m_bPlayingBack(false),
     m_pRecordingReplay(nullptr),
     m_pPlaybackReplay(nullptr),
+    m_pSavingReplay(nullptr),
+    m_hSaveThread(nullptr),
+    m_bSaveSucceeded(false),
     m_bShouldStopRec(false),
     m_iStartRecordingTick(0),
     m_iStartTimerTick(0),
@@ -31,21 +34,39 @@ CMomentumReplaySystem::CMomentumReplaySystem(const char* pName) : CAutoGameSyste
     m_bTeleportedThisFrame(false)
 {
     m_szMapHash[0] = '\0';
+    m_szSavedReplayPath[0] = '\0';
+    m_bSaveFinished = false;
 }
 
 CMomentumReplaySystem::~CMomentumReplaySystem()
 {
+    if (m_hSaveThread)
+    {
+        ThreadJoin(m_hSaveThread);
+        ReleaseThreadHandle(m_hSaveThread);
+        delete m_pSavingReplay;
+    }
+
     if (m_pRecordingReplay)
         delete m_pRecordingReplay;
 
-    if (m_pPlaybackReplay)
-        delete m_pPlaybackReplay;
+    // The playback replay is one of the shared ones
+    FOR_EACH_VEC(m_vecSharedReplays, i)
+    {
+        delete m_vecSharedReplays[i].m_pReplay;
+    }
 }
 
 void CMomentumReplaySystem::FrameUpdatePostEntityThink()
 {
+    if (m_pSavingReplay)
+        CheckReplaySaved(false);
+
     if (m_bRecording)
         UpdateRecordingParams();
+
+    if (!m_vecRaceGhosts.IsEmpty())
+        UpdateRaceGhosts();
 }
 
 void CMomentumReplaySystem::LevelInitPostEntity()
@@ -56,12 +77,18 @@ void CMomentumReplaySystem::LevelInitPostEntity()
 
 void CMomentumReplaySystem::LevelShutdownPostEntity()
 {
+    // Don't leave the replay half-written on map change
+    if (m_pSavingReplay)
+        CheckReplaySaved(true, true);
+
     if (m_bRecording)
         CancelRecording();
 
     if (m_pPlaybackReplay)
         UnloadPlayback(true);
 
+    ClearRaceGhosts(true);
+
     m_szMapHash[0] = '\0';
 }
 
@@ -139,72 +166,126 @@ void CMomentumReplaySystem::FinishRecording()
     m_bShouldStopRec = false;
     m_bRecording = false;
 
+    // Only one replay is saved at a time
+    if (m_pSavingReplay)
+        CheckReplaySaved(true);
+
     TrimReplay();
 
     SetReplayHeaderAndStats();
 
-    char newRecordingPath[MAX_PATH];
-    bool bStoredReplay = StoreReplay(newRecordingPath, MAX_PATH);
+    // Hand the replay off to the save thread, the game thread won't touch it until it's done
+    m_pSavingReplay = m_pRecordingReplay;
+    m_pRecordingReplay = nullptr;
+    m_bSaveSucceeded = false;
+    m_szSavedReplayPath[0] = '\0';
+    m_bSaveFinished = false;
+    m_hSaveThread = CreateSimpleThread(SaveReplayThreadFn, this);
+
+    if (!m_hSaveThread)
+    {
+        // Couldn't get a thread, just do it here
+        SaveReplayThreadFn(this);
+        CheckReplaySaved(true);
+    }
+
+    const auto pPlayer = CMomentumPlayer::GetLocalPlayer();
+    if (pPlayer)
+        pPlayer->SetAllowUserTeleports(true);
+
+    m_iStartRecordingTick = 0;
+    m_iStartTimerTick = 0;
+    m_iStopTimerTick = 0;
+}
+
+unsigned CMomentumReplaySystem::SaveReplayThreadFn(void *pParam)
+{
+    const auto pSystem = static_cast<CMomentumReplaySystem *>(pParam);
+
+    pSystem->m_bSaveSucceeded = pSystem->StoreReplay(pSystem->m_pSavingReplay, pSystem->m_szSavedReplayPath, MAX_PATH);
+    pSystem->m_bSaveFinished = true;
+
+    return 0;
+}
+
+void CMomentumReplaySystem::CheckReplaySaved(bool bWait, bool bShutdown /*= false*/)
+{
+    if (!m_pSavingReplay)
+        return;
+
+    if (!bWait && !m_bSaveFinished)
+        return;
+
+    if (m_hSaveThread)
+    {
+        ThreadJoin(m_hSaveThread);
+        ReleaseThreadHandle(m_hSaveThread);
+        m_hSaveThread = nullptr;
+    }
+
+    CMomReplayBase *pSavedReplay = m_pSavingReplay;
+    m_pSavingReplay = nullptr;
 
     const auto pReplaySavedEvent = gameeventmanager->CreateEvent("replay_save");
     if (pReplaySavedEvent)
     {
-        pReplaySavedEvent->SetBool("save", bStoredReplay);
-        pReplaySavedEvent->SetString("filepath", newRecordingPath);
-        pReplaySavedEvent->SetInt("time", static_cast<int>(m_pRecordingReplay->GetRunTime() * 1000.0f));
+        pReplaySavedEvent->SetBool("save", m_bSaveSucceeded);
+        pReplaySavedEvent->SetString("filepath", m_szSavedReplayPath);
+        pReplaySavedEvent->SetInt("time", static_cast<int>(pSavedReplay->GetRunTime() * 1000.0f));
         gameeventmanager->FireEvent(pReplaySavedEvent);
     }
 
-    if (bStoredReplay)
+    if (m_bSaveSucceeded)
     {
+        // Logged here, the save thread doesn't touch the console
+        DevLog("Replay Hash: %s\n", pSavedReplay->GetRunHash());
+        Log("Stored replay of version '%d' to %s\n", pSavedReplay->GetVersion(), m_szSavedReplayPath);
+
         char szRuntime[BUFSIZETIME];
-        MomUtil::FormatTime(m_pRecordingReplay->GetRunTime(), szRuntime);
-        Log("Recording Stopped! Ticks: %i | Time: %s\n", m_pRecordingReplay->GetFrameCount(), szRuntime);
-        UnloadPlayback();
-        m_pPlaybackReplay = m_pRecordingReplay;
-        LoadReplayGhost();
+        MomUtil::FormatTime(pSavedReplay->GetRunTime(), szRuntime);
+        Log("Recording Stopped! Ticks: %i | Time: %s\n", pSavedReplay->GetFrameCount(), szRuntime);
+
+        if (bShutdown)
+        {
+            // The entities are gone already, there's nothing to play it back with
+            delete pSavedReplay;
+        }
+        else
+        {
+            UnloadPlayback();
+            AddSharedReplay(pSavedReplay, m_szSavedReplayPath);
+            m_pPlaybackReplay = pSavedReplay;
+            LoadReplayGhost();
+        }
     }
     else
     {
         Warning("Unable to store replay file!\n");
-        if (m_pRecordingReplay)
-            delete m_pRecordingReplay;
+        delete pSavedReplay;
     }
-
-    const auto pPlayer = CMomentumPlayer::GetLocalPlayer();
-    if (pPlayer)
-        pPlayer->SetAllowUserTeleports(true);
-
-    m_iStartRecordingTick = 0;
-    m_iStartTimerTick = 0;
-    m_iStopTimerTick = 0;
-    m_pRecordingReplay = nullptr;
 }
 
-bool CMomentumReplaySystem::StoreReplay(char *pOut, size_t outSize)
+bool CMomentumReplaySystem::StoreReplay(CMomReplayBase *pReplay, char *pOut, size_t outSize)
 {
-    if (!m_pRecordingReplay)
+    if (!pReplay)
         return false;
 
     // Serialize the replay
     CUtlBuffer buf;
     buf.PutUnsignedInt(REPLAY_MAGIC_LE);
-    buf.PutUnsignedChar(m_pRecordingReplay->GetVersion());
-    m_pRecordingReplay->Serialize(buf);
+    buf.PutUnsignedChar(pReplay->GetVersion());
+    pReplay->Serialize(buf);
 
     // Generate the SHA1 hash for this replay
     char hash[41];
     if (MomUtil::GetSHA1Hash(buf, hash, 41))
     {
-        DevLog("Replay Hash: %s\n", hash);
-
         // For later
-        m_pRecordingReplay->SetRunHash(hash);
+        pReplay->SetRunHash(hash);
 
         // Store the file
-        CFmtStr newRecordingName("%s-%s%s", gpGlobals->mapname.ToCStr(), hash, EXT_RECORDING_FILE);
+        CFmtStr newRecordingName("%s-%s%s", pReplay->GetMapName(), hash, EXT_RECORDING_FILE);
         V_ComposeFileName(RECORDING_PATH, newRecordingName.Get(), pOut, outSize);
-        Log("Storing replay of version '%d' to %s ...\n", m_pRecordingReplay->GetVersion(), pOut);
         return g_pFullFileSystem->WriteFile(pOut, "MOD", buf);
     }
 
@@ -243,15 +324,25 @@ void CMomentumReplaySystem::UpdateRecordingParams()
         const auto pPlayer = CMomentumPlayer::GetLocalPlayer();
         if (!pPlayer->m_bHasPracticeMode && pPlayer->GetObserverMode() == OBS_MODE_NONE)
         {
+            int iButtons = pPlayer->m_nButtons;
+            if (pPlayer->GetFlags() & FL_ONGROUND)
+                iButtons |= IN_REPLAY_ONGROUND;
+
             m_pRecordingReplay->AddFrame(CReplayFrame(pPlayer->EyeAngles(), pPlayer->GetAbsOrigin(), pPlayer->GetViewOffset().z,
-                                             pPlayer->m_nButtons, m_bTeleportedThisFrame));
+                                             iButtons, m_bTeleportedThisFrame));
             m_bTeleportedThisFrame = false;
         }
         else
         {
             // MOM_TODO just repeat the last frame created (part of the mega refactor)
             SavedState_t *pSaved = pPlayer->GetSavedRunState();
-            m_pRecordingReplay->AddFrame(CReplayFrame(pSaved->m_angLastAng, pSaved->m_vecLastPos, pSaved->m_fLastViewOffset, pSaved->m_nButtons, false));
+            // The run stands still where it was left, so it stays on the ground if it was
+            int iButtons = pSaved->m_nButtons;
+            const int iLastFrame = m_pRecordingReplay->GetFrameCount() - 1;
+            if (iLastFrame >= 0 && m_pRecordingReplay->GetFrame(iLastFrame)->OnGround())
+                iButtons |= IN_REPLAY_ONGROUND;
+
+            m_pRecordingReplay->AddFrame(CReplayFrame(pSaved->m_angLastAng, pSaved->m_vecLastPos, pSaved->m_fLastViewOffset, iButtons, false));
         }
     }
 
@@ -267,7 +358,8 @@ CMomReplayBase *CMomentumReplaySystem::LoadPlayback(const char *pFileName, bool
     if (m_pPlaybackReplay)
         UnloadPlayback();
 
-    m_pPlaybackReplay = g_ReplayFactory.LoadReplayFile(pFileName, bFullLoad, pPathID);
+    // Full replays are shared with the race ghosts, a header-only one is all the playback's own
+    m_pPlaybackReplay = bFullLoad ? AcquireSharedReplay(pFileName, pPathID) : g_ReplayFactory.LoadReplayFile(pFileName, false, pPathID);
 
     // MOM_TODO: Verify the map hash of the replay here with m_szMapHash
 
@@ -340,7 +432,9 @@ void CMomentumReplaySystem::UnloadPlayback(bool shutdown)
         if (m_pPlaybackReplay->GetRunEntity() && !shutdown)
             m_pPlaybackReplay->GetRunEntity()->EndRun();
 
-        delete m_pPlaybackReplay;
+        // Race ghosts may keep the replay loaded, it has no playback ghost anymore
+        m_pPlaybackReplay->SetRunEntity(nullptr);
+        ReleaseSharedReplay(m_pPlaybackReplay);
     }
 
     m_pPlaybackReplay = nullptr;
@@ -364,6 +458,143 @@ void CMomentumReplaySystem::StopPlayback()
     UnloadPlayback();
 }
 
+CMomReplayBase *CMomentumReplaySystem::AcquireSharedReplay(const char *pFileName, const char *pPathID)
+{
+    FOR_EACH_VEC(m_vecSharedReplays, i)
+    {
+        if (!Q_stricmp(m_vecSharedReplays[i].m_szFilePath, pFileName))
+        {
+            m_vecSharedReplays[i].m_iRefCount++;
+            return m_vecSharedReplays[i].m_pReplay;
+        }
+    }
+
+    CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(pFileName, true, pPathID);
+    if (!pReplay)
+        return nullptr;
+
+    // The same run can be saved under different names (e.g. a local and a downloaded copy), keep only one of them around
+    const char *pRunHash = pReplay->GetRunHash();
+    if (pRunHash[0])
+    {
+        FOR_EACH_VEC(m_vecSharedReplays, i)
+        {
+            if (!Q_strcmp(m_vecSharedReplays[i].m_pReplay->GetRunHash(), pRunHash))
+            {
+                delete pReplay;
+                m_vecSharedReplays[i].m_iRefCount++;
+                return m_vecSharedReplays[i].m_pReplay;
+            }
+        }
+    }
+
+    AddSharedReplay(pReplay, pFileName);
+    return pReplay;
+}
+
+void CMomentumReplaySystem::AddSharedReplay(CMomReplayBase *pReplay, const char *pFileName)
+{
+    // A copy of an overwritten file stays around for whoever still uses it, but isn't what the file holds anymore
+    FOR_EACH_VEC(m_vecSharedReplays, i)
+    {
+        if (!Q_stricmp(m_vecSharedReplays[i].m_szFilePath, pFileName))
+            m_vecSharedReplays[i].m_szFilePath[0] = '\0';
+    }
+
+    SharedReplay_t &shared = m_vecSharedReplays[m_vecSharedReplays.AddToTail()];
+    shared.m_pReplay = pReplay;
+    shared.m_iRefCount = 1;
+    Q_strncpy(shared.m_szFilePath, pFileName, sizeof(shared.m_szFilePath));
+}
+
+void CMomentumReplaySystem::ReleaseSharedReplay(CMomReplayBase *pReplay)
+{
+    FOR_EACH_VEC(m_vecSharedReplays, i)
+    {
+        if (m_vecSharedReplays[i].m_pReplay == pReplay)
+        {
+            if (--m_vecSharedReplays[i].m_iRefCount <= 0)
+            {
+                delete pReplay;
+                m_vecSharedReplays.FastRemove(i);
+            }
+            return;
+        }
+    }
+
+    delete pReplay;
+}
+
+CMomentumReplayGhostEntity *CMomentumReplaySystem::AddRaceGhost(const char *pFileName, const char *pPathID)
+{
+    if (m_vecRaceGhosts.Count() >= MAX_RACE_GHOSTS)
+    {
+        Warning("Cannot race against more than %i replays at once!\n", MAX_RACE_GHOSTS);
+        return nullptr;
+    }
+
+    CMomReplayBase *pReplay = AcquireSharedReplay(pFileName, pPathID);
+    if (!pReplay)
+        return nullptr;
+
+    if (Q_stricmp(gpGlobals->mapname.ToCStr(), pReplay->GetMapName()) || pReplay->GetFrameCount() <= 0)
+    {
+        Warning("Replay %s is not for this map or has no frames!\n", pFileName);
+        ReleaseSharedReplay(pReplay);
+        return nullptr;
+    }
+
+    auto pGhost = static_cast<CMomentumReplayGhostEntity *>(CreateEntityByName("mom_replay_ghost"));
+    pGhost->LoadFromReplayBase(pReplay, true);
+
+    RaceGhost_t &race = m_vecRaceGhosts[m_vecRaceGhosts.AddToTail()];
+    race.m_hGhost = pGhost;
+    race.m_pReplay = pReplay;
+
+    return pGhost;
+}
+
+void CMomentumReplaySystem::StartRace()
+{
+    // Every ghost starts on the same tick, so they stay in lockstep with each other
+    FOR_EACH_VEC(m_vecRaceGhosts, i)
+    {
+        if (m_vecRaceGhosts[i].m_hGhost.Get())
+            m_vecRaceGhosts[i].m_hGhost->StartRun(false);
+    }
+}
+
+void CMomentumReplaySystem::ClearRaceGhosts(bool shutdown)
+{
+    FOR_EACH_VEC(m_vecRaceGhosts, i)
+    {
+        CMomentumReplayGhostEntity *pGhost = m_vecRaceGhosts[i].m_hGhost.Get();
+        if (pGhost && !shutdown)
+            pGhost->EndRun();
+
+        ReleaseSharedReplay(m_vecRaceGhosts[i].m_pReplay);
+    }
+
+    m_vecRaceGhosts.Purge();
+}
+
+void CMomentumReplaySystem::UpdateRaceGhosts()
+{
+    FOR_EACH_VEC_BACK(m_vecRaceGhosts, i)
+    {
+        CMomentumReplayGhostEntity *pGhost = m_vecRaceGhosts[i].m_hGhost.Get();
+        if (!pGhost)
+        {
+            // Removed from elsewhere
+            ReleaseSharedReplay(m_vecRaceGhosts[i].m_pReplay);
+            m_vecRaceGhosts.Remove(i);
+            continue;
+        }
+
+        pGhost->UpdatePlayback();
+    }
+}
+
 class CMOMReplayCommands
 {
   public:
@@ -401,6 +632,25 @@ class CMOMReplayCommands
     }
     static void PlayReplayGhost(const CCommand &args) { StartReplay(args, false); }
     static void PlayReplayFirstPerson(const CCommand &args) { StartReplay(args, true); }
+    static void AddRaceGhost(const CCommand &args)
+    {
+        if (args.ArgC() < 2)
+        {
+            Msg("Usage: mom_replay_race_add <replay>\n");
+            return;
+        }
+
+        char filename[MAX_PATH];
+        Q_strncpy(filename, args.ArgS(), sizeof(filename));
+        if (!Q_strstr(filename, EXT_RECORDING_FILE))
+            Q_strncat(filename, EXT_RECORDING_FILE, sizeof(filename));
+
+        char recordingName[MAX_PATH];
+        V_ComposeFileName(RECORDING_PATH, filename, recordingName, MAX_PATH);
+
+        if (g_ReplaySystem.AddRaceGhost(recordingName))
+            Msg("Added %s to the race (%i ghosts), start it with mom_replay_race_start.\n", filename, g_ReplaySystem.GetRaceGhostCount());
+    }
 };
 
 CON_COMMAND_AUTOCOMPLETEFILE(mom_replay_play_ghost, CMOMReplayCommands::PlayReplayGhost,
@@ -472,4 +722,18 @@ CON_COMMAND(mom_replay_goto_end, "Go to the end of the replay.")
     }
 }
 
+CON_COMMAND_AUTOCOMPLETEFILE(mom_replay_race_add, CMOMReplayCommands::AddRaceGhost,
+                             "Loads a replay as a race ghost. Race ghosts play back together with mom_replay_race_start.",
+                             RECORDING_PATH, EXT_RECORDING_FILE);
+
+CON_COMMAND(mom_replay_race_start, "(Re)starts every loaded race ghost from the beginning of its replay.")
+{
+    g_ReplaySystem.StartRace();
+}
+
+CON_COMMAND(mom_replay_race_clear, "Removes every race ghost.")
+{
+    g_ReplaySystem.ClearRaceGhosts();
+}
+
 CMomentumReplaySystem g_ReplaySystem("MOMReplaySystem");
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "tier0/threadtools.h"
+
 class CMomentumReplayGhostEntity;
 class CMomentumPlayer;
 class CMomReplayBase;
 
+// The most race ghosts that can be loaded at once
+#define MAX_RACE_GHOSTS 32
+
 class CMomentumReplaySystem : public CAutoGameSystemPerFrame
 {
 public:
@@ -29,6 +34,7 @@ public:
     void StopRecording();  // Called when the timer stops, calls FinishRecording after delay
     bool IsRecording() const { return m_bRecording; }
     bool IsPlayingBack() const { return m_bPlayingBack; }
+    bool IsSavingReplay() const { return m_pSavingReplay != nullptr; }
     void TrimReplay(); // Trims a replay's start down to only include a defined amount of time in the start trigger
 
     CMomReplayBase *LoadPlayback(const char *pFileName, bool bFullLoad = true, const char *pPathID = "MOD");
@@ -37,6 +43,13 @@ public:
     void StartPlayback(bool firstperson);
     void StopPlayback();
 
+    // Race ghosts play alongside the player and the playback replay, all advanced in one pass per tick.
+    // Replays loaded more than once (by path or by content) share a single copy of their frames.
+    CMomentumReplayGhostEntity *AddRaceGhost(const char *pFileName, const char *pPathID = "MOD");
+    void StartRace();
+    void ClearRaceGhosts(bool shutdown = false);
+    int GetRaceGhostCount() const { return m_vecRaceGhosts.Count(); }
+
     void SetTeleportedThisFrame(); // Call me when player teleports.
     const CMomReplayBase *GetRecordingReplay() const { return m_pRecordingReplay; }
     CMomReplayBase *GetRecordingReplay() { return m_pRecordingReplay; }
@@ -46,15 +59,49 @@ public:
     //CMomRunStats *SavedRunStats() { return &m_SavedRunStats; }
 
   private:
-    void FinishRecording();       // Called when the end recording delay is over, writes replay file
+    void FinishRecording();       // Called when the end recording delay is over, hands the replay off to the save thread
     void UpdateRecordingParams(); // called every game frame after entities think and update
     void SetReplayHeaderAndStats();
-    bool StoreReplay(char *pPathOut, size_t outSize);
+
+    // Serializing, hashing and writing the replay happens off the game thread
+    static unsigned SaveReplayThreadFn(void *pParam);
+    bool StoreReplay(CMomReplayBase *pReplay, char *pPathOut, size_t outSize); // Called from the save thread
+    // Fires replay_save once the save thread is done. On level shutdown the saved replay isn't loaded for playback.
+    void CheckReplaySaved(bool bWait, bool bShutdown = false);
+
+    // Loads the replay or adds a reference to the already loaded copy of it
+    CMomReplayBase *AcquireSharedReplay(const char *pFileName, const char *pPathID);
+    // Hands a replay that is already loaded to the cache with one reference, so later loads of its file share it
+    void AddSharedReplay(CMomReplayBase *pReplay, const char *pFileName);
+    // Drops a reference, replays that never went through the cache (header-only loads) are deleted right away
+    void ReleaseSharedReplay(CMomReplayBase *pReplay);
+    void UpdateRaceGhosts();
 
     bool m_bRecording;
     bool m_bPlayingBack;
     CMomReplayBase *m_pRecordingReplay;
-    CMomReplayBase *m_pPlaybackReplay;
+    CMomReplayBase *m_pPlaybackReplay; // A reference to the shared replays, like the race ghosts hold
+
+    CMomReplayBase *m_pSavingReplay; // Owned by the save thread until m_bSaveFinished is set
+    ThreadHandle_t m_hSaveThread;
+    CInterlockedInt m_bSaveFinished;
+    bool m_bSaveSucceeded;
+    char m_szSavedReplayPath[MAX_PATH];
+
+    struct SharedReplay_t
+    {
+        CMomReplayBase *m_pReplay;
+        int m_iRefCount;
+        char m_szFilePath[MAX_PATH];
+    };
+    CUtlVector<SharedReplay_t> m_vecSharedReplays;
+
+    struct RaceGhost_t
+    {
+        CHandle<CMomentumReplayGhostEntity> m_hGhost;
+        CMomReplayBase *m_pReplay;
+    };
+    CUtlVector<RaceGhost_t> m_vecRaceGhosts;
 
     bool m_bShouldStopRec;
     int m_iStartRecordingTick; // The tick that the replay started, used for trimming.
@@ -13,7 +13,13 @@
 
 #include "tier0/memdbgon.h"
 
-#define SAVELOC_FILE_NAME "savedlocs.txt"
+// Every map has its own saveloc file, so only the current map's savelocs are ever read or written
+#define SAVELOC_DIR "savelocs"
+#define SAVELOC_FILE_MAGIC 0x4C534D4D // "MMSL"
+#define SAVELOC_FILE_VERSION 1
+// The single text file every map used to be saved in, migrated to the per-map files once
+#define SAVELOC_LEGACY_FILE_NAME "savedlocs.txt"
+#define SAVELOC_LEGACY_MIGRATED_FILE_NAME "savedlocs.txt.migrated"
 
 MAKE_TOGGLE_CONVAR(mom_saveloc_save_between_sessions, "1", FCVAR_ARCHIVE, "Defines if savelocs should be saved between sessions of the same map.\n");
 
@@ -216,45 +222,170 @@ void CSaveLocSystem::PostInit()
     g_pModuleComms->ListenForEvent("req_savelocs", UtlMakeDelegate(this, &CSaveLocSystem::OnSavelocRequestEvent));
 }
 
+static void GetSavelocFileName(const char *pMapName, char *pOut, int outSize)
+{
+    Q_snprintf(pOut, outSize, SAVELOC_DIR "/%s.bin", pMapName);
+}
+
+// Binary KeyValues can't hold keys without a value or subkeys, they come back with a bogus empty subkey
+static void RemoveEmptySubKey(KeyValues *pKv, const char *pName)
+{
+    KeyValues *pSub = pKv->FindKey(pName);
+    if (pSub && !pSub->GetFirstSubKey())
+    {
+        pKv->RemoveSubKey(pSub);
+        pSub->deleteThis();
+    }
+}
+
+#ifdef _DEBUG
+static int CountSubKeys(KeyValues *pKv)
+{
+    int count = 0;
+    if (pKv)
+    {
+        FOR_EACH_SUBKEY(pKv, pSub)
+            count++;
+    }
+    return count;
+}
+#endif
+
+// The map's KeyValues must have no peers, binary KeyValues write those too!
+static bool WriteSavelocFile(KeyValues *pKvMapSavelocs, const char *pMapName)
+{
+    Assert(!pKvMapSavelocs->GetNextKey());
+
+    RemoveEmptySubKey(pKvMapSavelocs, "cps");
+    RemoveEmptySubKey(pKvMapSavelocs, "startmarks");
+
+    CUtlBuffer buf;
+    buf.PutUnsignedInt(SAVELOC_FILE_MAGIC);
+    buf.PutUnsignedChar(SAVELOC_FILE_VERSION);
+    if (!pKvMapSavelocs->WriteAsBinary(buf))
+        return false;
+
+#ifdef _DEBUG
+    // Make sure exactly the savelocs and startmarks that were written come back
+    {
+        CUtlBuffer check(buf.Base(), buf.TellPut(), CUtlBuffer::READ_ONLY);
+        check.SeekGet(CUtlBuffer::SEEK_HEAD, sizeof(uint32) + sizeof(uint8));
+        KeyValuesAD pKvCheck("check");
+        const bool bRead = pKvCheck->ReadAsBinary(check);
+        Assert(bRead && !pKvCheck->GetNextKey());
+        Assert(CountSubKeys(pKvCheck->FindKey("cps")) == CountSubKeys(pKvMapSavelocs->FindKey("cps")));
+        Assert(CountSubKeys(pKvCheck->FindKey("startmarks")) == CountSubKeys(pKvMapSavelocs->FindKey("startmarks")));
+    }
+#endif
+
+    char szFileName[MAX_PATH];
+    GetSavelocFileName(pMapName, szFileName, sizeof(szFileName));
+    filesystem->CreateDirHierarchy(SAVELOC_DIR, "MOD");
+    return filesystem->WriteFile(szFileName, "MOD", buf);
+}
+
+static bool ReadSavelocFile(KeyValues *pKvMapSavelocs, const char *pMapName)
+{
+    char szFileName[MAX_PATH];
+    GetSavelocFileName(pMapName, szFileName, sizeof(szFileName));
+
+    CUtlBuffer buf;
+    if (!filesystem->ReadFile(szFileName, "MOD", buf))
+        return false;
+
+    if (buf.GetUnsignedInt() != SAVELOC_FILE_MAGIC || buf.GetUnsignedChar() != SAVELOC_FILE_VERSION || !buf.IsValid())
+    {
+        Warning("Saveloc file %s is not a valid saveloc file!\n", szFileName);
+        return false;
+    }
+
+    return pKvMapSavelocs->ReadAsBinary(buf);
+}
+
+void CSaveLocSystem::MigrateLegacySavelocFile()
+{
+    if (!filesystem->FileExists(SAVELOC_LEGACY_FILE_NAME, "MOD"))
+        return;
+
+    KeyValuesAD pKvLegacy("Savelocs");
+    if (!pKvLegacy->LoadFromFile(filesystem, SAVELOC_LEGACY_FILE_NAME, "MOD"))
+    {
+        Warning("Failed to load %s to migrate its savelocs!\n", SAVELOC_LEGACY_FILE_NAME);
+        return;
+    }
+
+    DevLog("Migrating the savelocs of %s to " SAVELOC_DIR "/ ...\n", SAVELOC_LEGACY_FILE_NAME);
+
+    int iMigrated = 0;
+    FOR_EACH_TRUE_SUBKEY(pKvLegacy, pKvMapSavelocs)
+    {
+        // Files that already exist were saved since, they're newer than the old file
+        char szFileName[MAX_PATH];
+        GetSavelocFileName(pKvMapSavelocs->GetName(), szFileName, sizeof(szFileName));
+        if (filesystem->FileExists(szFileName, "MOD"))
+        {
+            Warning("Not migrating the savelocs of %s, %s already exists.\n", pKvMapSavelocs->GetName(), szFileName);
+            continue;
+        }
+
+        // A copy, the map is still linked to the other maps of the old file
+        KeyValuesAD pKvMapCopy(pKvMapSavelocs->MakeCopy());
+        if (!WriteSavelocFile(pKvMapCopy, pKvMapSavelocs->GetName()))
+        {
+            // Keep the old file around so nothing gets lost, the next map load tries again
+            Warning("Failed to write %s, not migrating %s!\n", szFileName, SAVELOC_LEGACY_FILE_NAME);
+            return;
+        }
+
+        iMigrated++;
+    }
+
+    // Kept instead of deleted, in case anybody wants their old file back
+    filesystem->RemoveFile(SAVELOC_LEGACY_MIGRATED_FILE_NAME, "MOD");
+    if (!filesystem->RenameFile(SAVELOC_LEGACY_FILE_NAME, SAVELOC_LEGACY_MIGRATED_FILE_NAME, "MOD"))
+        Warning("Failed to rename %s after migrating it!\n", SAVELOC_LEGACY_FILE_NAME);
+
+    DevLog("Migrated the savelocs of %i maps from %s!\n", iMigrated, SAVELOC_LEGACY_FILE_NAME);
+}
+
 void CSaveLocSystem::LevelInitPreEntity()
 {
-    // We don't check mom_savelocs_save_between_sessions because we want to be able to load savelocs from friends
-    DevLog("Loading savelocs from %s ...\n", SAVELOC_FILE_NAME);
+    // Note: We are not in PostInit because if players drop in an old savelocs file (add savelocs from a friend
+    // or something), then we want to pick it up on map load again, and not force the player to restart the mod.
+    MigrateLegacySavelocFile();
 
+    // We don't check mom_savelocs_save_between_sessions because we want to be able to load savelocs from friends
     if (m_pSavedLocsKV)
     {
         //Remove the past loaded stuff
         m_pSavedLocsKV->Clear();
 
-        // Note: This loading is going to contain all of the other maps' savelocs as well!
-        // Note: We are not in PostInit because if players edit their savelocs file (add
-        // savelocs from a friend or something), then we want to reload on map load again,
-        // and not force the player to restart the mod every time.
-        if (m_pSavedLocsKV->LoadFromFile(filesystem, SAVELOC_FILE_NAME, "MOD"))
+        const char *pMapName = gpGlobals->mapname.ToCStr();
+        if (ReadSavelocFile(m_pSavedLocsKV, pMapName))
         {
-            DevLog("Loaded savelocs from %s!\n", SAVELOC_FILE_NAME);
+            DevLog("Loaded savelocs of %s!\n", pMapName);
 
             if (!m_pSavedLocsKV->IsEmpty())
             {
-                KeyValues *kvMapSavelocs = m_pSavedLocsKV->FindKey(gpGlobals->mapname.ToCStr());
-                if (kvMapSavelocs && !kvMapSavelocs->IsEmpty())
-                {
-                    m_iCurrentSavelocIndx = kvMapSavelocs->GetInt("cur");
+                m_iCurrentSavelocIndx = m_pSavedLocsKV->GetInt("cur");
 
-                    KeyValues *kvCPs = kvMapSavelocs->FindKey("cps");
-                    if (!kvCPs)
-                        return;
+                KeyValues *kvCPs = m_pSavedLocsKV->FindKey("cps");
+                if (!kvCPs)
+                    return;
 
-                    FOR_EACH_SUBKEY(kvCPs, kvCheckpoint)
-                    {
-                        auto c = new SavedLocation_t;
-                        c->Load(kvCheckpoint);
-                        m_rcSavelocs.AddToTail(c);
-                    }
+                FOR_EACH_SUBKEY(kvCPs, kvCheckpoint)
+                {
+                    // Skip the bogus empty saveloc an empty "cps" key used to be read back as
+                    if (!kvCheckpoint->GetFirstSubKey())
+                        continue;
 
-                    // Fire the initial event
-                    FireUpdateEvent();
+                    auto c = new SavedLocation_t;
+                    c->Load(kvCheckpoint);
+                    m_rcSavelocs.AddToTail(c);
                 }
+
+                // Fire the initial event
+                FireUpdateEvent();
             }
         }
     }
@@ -265,11 +396,7 @@ bool CSaveLocSystem::LoadStartMarks()
     if (!m_pSavedLocsKV || m_pSavedLocsKV->IsEmpty())
         return false;
 
-    KeyValues *kvMapSavelocs = m_pSavedLocsKV->FindKey(gpGlobals->mapname.ToCStr());
-    if (!kvMapSavelocs || kvMapSavelocs->IsEmpty())
-        return false;
-
-    KeyValues *kvStartMarks = kvMapSavelocs->FindKey("startmarks");
+    KeyValues *kvStartMarks = m_pSavedLocsKV->FindKey("startmarks");
     if (!kvStartMarks)
         return false;
 
@@ -279,6 +406,9 @@ bool CSaveLocSystem::LoadStartMarks()
 
     FOR_EACH_SUBKEY(kvStartMarks, kvStartMark)
     {
+        if (!kvStartMark->GetFirstSubKey())
+            continue;
+
         int track = Q_atoi(kvStartMark->GetName());
 
         SavedLocation_t * pStartmark = new SavedLocation_t;
@@ -299,9 +429,10 @@ void CSaveLocSystem::LevelShutdownPreEntity()
     CMomentumPlayer *pPlayer = CMomentumPlayer::GetLocalPlayer();
     if (pPlayer && m_pSavedLocsKV && mom_saveloc_save_between_sessions.GetBool())
     {
-        DevLog("Saving map %s savelocs and startmarks to %s ...\n", gpGlobals->mapname.ToCStr(), SAVELOC_FILE_NAME);
+        const char *pMapName = gpGlobals->mapname.ToCStr();
+        DevLog("Saving map %s savelocs and startmarks ...\n", pMapName);
         // Make the KV to save into and save into it
-        KeyValues *pKvMapSavelocs = new KeyValues(gpGlobals->mapname.ToCStr());
+        KeyValuesAD pKvMapSavelocs(pMapName);
         // Set the current index
         pKvMapSavelocs->SetInt("cur", m_iCurrentSavelocIndx);
 
@@ -332,24 +463,35 @@ void CSaveLocSystem::LevelShutdownPreEntity()
             kvStartMarks->AddSubKey(kvStartMark);
         }
 
-        // Save them into the keyvalues
-        pKvMapSavelocs->AddSubKey(kvCPs);
-        pKvMapSavelocs->AddSubKey(kvStartMarks);
-       
-        // Remove the map if it already exists in there
-        KeyValues *pExisting = m_pSavedLocsKV->FindKey(gpGlobals->mapname.ToCStr());
-        if (pExisting)
-        {
-            m_pSavedLocsKV->RemoveSubKey(pExisting);
-            pExisting->deleteThis();
-        }
+        const bool bEmpty = !kvCPs->GetFirstSubKey() && !kvStartMarks->GetFirstSubKey();
+
+        // Save them into the keyvalues, empty ones can't be written as binary
+        if (kvCPs->GetFirstSubKey())
+            pKvMapSavelocs->AddSubKey(kvCPs);
+        else
+            kvCPs->deleteThis();
 
-        // Add the new one
-        m_pSavedLocsKV->AddSubKey(pKvMapSavelocs);
+        if (kvStartMarks->GetFirstSubKey())
+            pKvMapSavelocs->AddSubKey(kvStartMarks);
+        else
+            kvStartMarks->deleteThis();
 
-        // Save everything to file
-        if (m_pSavedLocsKV->SaveToFile(filesystem, SAVELOC_FILE_NAME, "MOD", true))
-            DevLog("Saved map %s savelocs and startmarks to %s!\n", gpGlobals->mapname.ToCStr(), SAVELOC_FILE_NAME);
+        if (bEmpty)
+        {
+            // Nothing to keep, don't leave a file behind for every map ever played
+            char szFileName[MAX_PATH];
+            GetSavelocFileName(pMapName, szFileName, sizeof(szFileName));
+            if (filesystem->FileExists(szFileName, "MOD"))
+                filesystem->RemoveFile(szFileName, "MOD");
+        }
+        else if (WriteSavelocFile(pKvMapSavelocs, pMapName))
+        {
+            DevLog("Saved map %s savelocs and startmarks!\n", pMapName);
+        }
+        else
+        {
+            Warning("Failed to save the savelocs of %s!\n", pMapName);
+        }
     }
 
     // Remove all requesters if we had any
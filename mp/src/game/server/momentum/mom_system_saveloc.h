@@ -127,8 +127,9 @@ private:
     void CheckTimer(); // Check the timer to see if we should stop it
     void FireUpdateEvent() const; // Fire tan event to the UI when we change our saveloc vector in any way, or stop using the saveloc menu
     void UpdateRequesters(); // Update any requesters with the updated saveloc count
+    void MigrateLegacySavelocFile(); // Splits the old savelocs file of every map into the per-map files
 
-    KeyValues *m_pSavedLocsKV;
+    KeyValues *m_pSavedLocsKV; // The savelocs and startmarks of the current map, as loaded from its file
     CUtlVector<uint64> m_vecRequesters;
     uint64 m_iRequesting; // The Steam ID of the person we are requesting savelocs from, if any
 
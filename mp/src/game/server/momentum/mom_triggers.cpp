@@ -484,6 +484,13 @@ void CTriggerTrickZone::Spawn()
     g_pTrickSystem->AddZone(this);
 }
 
+void CTriggerTrickZone::UpdateOnRemove()
+{
+    g_pTrickSystem->RemoveZone(this);
+
+    BaseClass::UpdateOnRemove();
+}
+
 int CTriggerTrickZone::GetZoneType()
 {
     return ZONE_TYPE_TRICK;
@@ -275,6 +275,7 @@ public:
     CTriggerTrickZone();
 
     void Spawn() override;
+    void UpdateOnRemove() override;
 
     int UpdateTransmitState() override { return SetTransmitState(FL_EDICT_ALWAYS); }
 
@@ -10,8 +10,13 @@
 
 #ifdef CLIENT_DLL
 #include "c_mom_triggers.h"
+
+// The movement profiler only runs on the server
+#define MOVEMENT_PROFILE_PHASE(phase)
+#define MOVEMENT_PROFILE_TRACE()
 #else
 #include "env_player_surface_trigger.h"
+#include "momentum/mom_movement_profiler.h"
 #include "momentum/mom_triggers.h"
 #include "momentum/mom_system_saveloc.h"
 #include "momentum/mom_timer.h"
@@ -63,8 +68,32 @@ void CMomentumGameMovement::ProcessMovement(CBasePlayer *pPlayer, CMoveData *dat
     m_pPlayer = ToCMOMPlayer(pPlayer);
     Assert(m_pPlayer);
 
+#ifdef GAME_DLL
+    g_pMovementProfiler->BeginTick(pPlayer);
+#endif
+
     BaseClass::ProcessMovement(pPlayer, data);
+
+#ifdef GAME_DLL
+    g_pMovementProfiler->EndTick();
+#endif
+}
+
+#ifdef GAME_DLL
+void CMomentumGameMovement::TracePlayerBBox(const Vector &start, const Vector &end, unsigned int fMask,
+                                            int collisionGroup, trace_t &pm)
+{
+    MOVEMENT_PROFILE_TRACE();
+    BaseClass::TracePlayerBBox(start, end, fMask, collisionGroup, pm);
+}
+
+void CMomentumGameMovement::TryTouchGround(const Vector &start, const Vector &end, const Vector &mins,
+                                           const Vector &maxs, unsigned int fMask, int collisionGroup, trace_t &pm)
+{
+    MOVEMENT_PROFILE_TRACE();
+    BaseClass::TryTouchGround(start, end, mins, maxs, fMask, collisionGroup, pm);
 }
+#endif
 
 float CMomentumGameMovement::LadderDistance() const
 {
@@ -148,6 +177,8 @@ float CMomentumGameMovement::ClimbSpeed() const
 
 void CMomentumGameMovement::WalkMove()
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_GROUND);
+
     int i;
 
     Vector wishvel;
@@ -493,6 +524,8 @@ void CMomentumGameMovement::StepMove(Vector &vecDestination, trace_t &trace)
 
 bool CMomentumGameMovement::LadderMove()
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_LADDER);
+
     trace_t pm;
     bool onFloor;
     Vector floor;
@@ -733,6 +766,7 @@ bool CMomentumGameMovement::CanUnduck()
         newOrigin += -g_pGameModeSystem->GetGameMode()->GetViewScale() * (hullSizeNormal - hullSizeCrouch);
     }
 
+    MOVEMENT_PROFILE_TRACE();
     UTIL_TraceHull(mv->GetAbsOrigin(), newOrigin, VEC_HULL_MIN, VEC_HULL_MAX, PlayerSolidMask(), player,
                    COLLISION_GROUP_PLAYER_MOVEMENT, &trace);
 
@@ -1176,6 +1210,7 @@ void CMomentumGameMovement::PlayerMove()
         trace_t trace;
         Ray_t ray;
         ray.Init(start, end, vHullMin, vHullMax);
+        MOVEMENT_PROFILE_TRACE();
         UTIL_TraceRay(ray, PlayerSolidMask(), mv->m_nPlayerHandle.Get(), COLLISION_GROUP_PLAYER_MOVEMENT, &trace);
 
         // Clip player view height to ceiling (unless we're in noclip)
@@ -2274,6 +2309,7 @@ void CMomentumGameMovement::StuckGround()
 
     {
         CTraceFilterSimple tracefilter(player, COLLISION_GROUP_NONE);
+        MOVEMENT_PROFILE_TRACE();
         enginetrace->TraceRay(ray, MASK_PLAYERSOLID, &tracefilter, &tr_Point_C);
     }
 
@@ -2285,6 +2321,7 @@ void CMomentumGameMovement::StuckGround()
 
         // Get B point.
         trace_t tr_Point_B;
+        MOVEMENT_PROFILE_TRACE();
         enginetrace->ClipRayToEntity(ray, MASK_ALL, m_pPlayer->m_CurrentSlideTrigger, &tr_Point_B);
 
         // Did we hit our trigger?
@@ -2375,6 +2412,8 @@ void CMomentumGameMovement::PerformLurchChecks()
 
 void CMomentumGameMovement::AirMove()
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_AIR);
+
     if (g_pGameModeSystem->GameModeIs(GAMEMODE_PARKOUR))
     {
         PerformLurchChecks();
@@ -2404,6 +2443,71 @@ void CMomentumGameMovement::AirMove()
     }
 }
 
+//-----------------------------------------------------------------------------
+// When stuck on a ramp we have no usable plane info, so inflate the player's hull in all 27 directions
+// and average the normals of every plane that gets hit.
+//-----------------------------------------------------------------------------
+bool CMomentumGameMovement::FindRampFixPlane(const Vector &origin, const Vector &end, const Vector &mins,
+                                             const Vector &maxs, unsigned int mask, IHandleEntity *pIgnore,
+                                             int bumpcount, Vector &plane, trace_t &pm)
+{
+    // this way we know fixed_origin isn't going to be stuck
+    float offsets[] = {(bumpcount * 2) * -sv_ramp_initial_retrace_length.GetFloat(), 0.0f,
+                       (bumpcount * 2) * sv_ramp_initial_retrace_length.GetFloat()};
+    int valid_planes = 0;
+    plane.Init(0.0f, 0.0f, 0.0f);
+
+    // we have 0 plane info, so lets increase our bbox and search in all 27 directions to get a valid plane!
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            for (int h = 0; h < 3; h++)
+            {
+                Vector offset = {offsets[i], offsets[j], offsets[h]};
+
+                Vector offset_mins = offset / 2.0f;
+                Vector offset_maxs = offset / 2.0f;
+
+                if (offset.x > 0.0f)
+                    offset_mins.x /= 2.0f;
+                if (offset.y > 0.0f)
+                    offset_mins.y /= 2.0f;
+                if (offset.z > 0.0f)
+                    offset_mins.z /= 2.0f;
+
+                if (offset.x < 0.0f)
+                    offset_maxs.x /= 2.0f;
+                if (offset.y < 0.0f)
+                    offset_maxs.y /= 2.0f;
+                if (offset.z < 0.0f)
+                    offset_maxs.z /= 2.0f;
+
+                Ray_t ray;
+                ray.Init(origin + offset, end - offset, mins - offset_mins, maxs + offset_maxs);
+                MOVEMENT_PROFILE_TRACE();
+                UTIL_TraceRay(ray, mask, pIgnore, COLLISION_GROUP_PLAYER_MOVEMENT, &pm);
+
+                // Only use non deformed planes and planes with values where the start point is not from a solid
+                if (fabs(pm.plane.normal.x) <= 1.0f && fabs(pm.plane.normal.y) <= 1.0f &&
+                    fabs(pm.plane.normal.z) <= 1.0f && pm.fraction > 0.0f && pm.fraction < 1.0f && !pm.startsolid)
+                {
+                    valid_planes++;
+                    plane += pm.plane.normal;
+                }
+            }
+        }
+    }
+
+    if (valid_planes && !CloseEnough(plane, Vector(0.0f, 0.0f, 0.0f), FLT_EPSILON))
+    {
+        plane.NormalizeInPlace();
+        return true;
+    }
+
+    return false;
+}
+
 int CMomentumGameMovement::TryPlayerMove(Vector *pFirstDest, trace_t *pFirstTrace)
 {
     int bumpcount, numbumps;
@@ -2415,7 +2519,7 @@ int CMomentumGameMovement::TryPlayerMove(Vector *pFirstDest, trace_t *pFirstTrac
     Vector new_velocity;
     Vector fixed_origin;
     Vector valid_plane;
-    int i, j, h;
+    int i, j;
     trace_t pm;
     Vector end;
     float time_left, allFraction;
@@ -2450,6 +2554,8 @@ int CMomentumGameMovement::TryPlayerMove(Vector *pFirstDest, trace_t *pFirstTrac
 
         if (stuck_on_ramp && sv_ramp_fix.GetBool())
         {
+            MOVEMENT_PROFILE_PHASE(MOVEPHASE_RAMPFIX);
+
             if (!has_valid_plane)
             {
                 if (!CloseEnough(pm.plane.normal, Vector(0.0f, 0.0f, 0.0f), FLT_EPSILON) &&
@@ -2490,61 +2596,10 @@ int CMomentumGameMovement::TryPlayerMove(Vector *pFirstDest, trace_t *pFirstTrac
             }
             else // We were actually going to be stuck, lets try and find a valid plane..
             {
-                // this way we know fixed_origin isn't going to be stuck
-                float offsets[] = {(bumpcount * 2) * -sv_ramp_initial_retrace_length.GetFloat(), 0.0f,
-                                   (bumpcount * 2) * sv_ramp_initial_retrace_length.GetFloat()};
-                int valid_planes = 0;
-                valid_plane.Init(0.0f, 0.0f, 0.0f);
-
-                // we have 0 plane info, so lets increase our bbox and search in all 27 directions to get a valid plane!
-                for (i = 0; i < 3; i++)
-                {
-                    for (j = 0; j < 3; j++)
-                    {
-                        for (h = 0; h < 3; h++)
-                        {
-                            Vector offset = {offsets[i], offsets[j], offsets[h]};
-
-                            Vector offset_mins = offset / 2.0f;
-                            Vector offset_maxs = offset / 2.0f;
-
-                            if (offset.x > 0.0f)
-                                offset_mins.x /= 2.0f;
-                            if (offset.y > 0.0f)
-                                offset_mins.y /= 2.0f;
-                            if (offset.z > 0.0f)
-                                offset_mins.z /= 2.0f;
-
-                            if (offset.x < 0.0f)
-                                offset_maxs.x /= 2.0f;
-                            if (offset.y < 0.0f)
-                                offset_maxs.y /= 2.0f;
-                            if (offset.z < 0.0f)
-                                offset_maxs.z /= 2.0f;
-
-                            Ray_t ray;
-                            ray.Init(fixed_origin + offset, end - offset, GetPlayerMins() - offset_mins,
-                                     GetPlayerMaxs() + offset_maxs);
-                            UTIL_TraceRay(ray, PlayerSolidMask(), mv->m_nPlayerHandle.Get(),
-                                          COLLISION_GROUP_PLAYER_MOVEMENT, &pm);
-
-                            // Only use non deformed planes and planes with values where the start point is not from a
-                            // solid
-                            if (fabs(pm.plane.normal.x) <= 1.0f && fabs(pm.plane.normal.y) <= 1.0f &&
-                                fabs(pm.plane.normal.z) <= 1.0f && pm.fraction > 0.0f && pm.fraction < 1.0f &&
-                                !pm.startsolid)
-                            {
-                                valid_planes++;
-                                valid_plane += pm.plane.normal;
-                            }
-                        }
-                    }
-                }
-
-                if (valid_planes && !CloseEnough(valid_plane, Vector(0.0f, 0.0f, 0.0f), FLT_EPSILON))
+                if (FindRampFixPlane(fixed_origin, end, GetPlayerMins(), GetPlayerMaxs(), PlayerSolidMask(),
+                                     mv->m_nPlayerHandle.Get(), bumpcount, valid_plane, pm))
                 {
                     has_valid_plane = true;
-                    valid_plane.NormalizeInPlace();
                     continue;
                 }
             }
@@ -3337,6 +3392,8 @@ float CMomentumGameMovement::GetWallRunRollAngle()
 //-----------------------------------------------------------------------------
 void CMomentumGameMovement::AnticipateWallRun()
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_WALLRUN);
+
     // No idea how this can be called when wallrunning, but it is
     if (m_pPlayer->m_nWallRunState >= WALLRUN_RUNNING)
         return;
@@ -3381,6 +3438,8 @@ void CMomentumGameMovement::AnticipateWallRun()
 //-----------------------------------------------------------------------------
 void CMomentumGameMovement::CheckWallRun(Vector &vecWallNormal, trace_t &pm)
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_WALLRUN);
+
     // Can't wallrun without the suit
     /*if (!player->IsSuitEquipped())
         return;*/
@@ -3493,6 +3552,8 @@ void CMomentumGameMovement::CheckWallRun(Vector &vecWallNormal, trace_t &pm)
 // Handle wallrun movement
 void CMomentumGameMovement::WallRunMove()
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_WALLRUN);
+
     if (player->m_Local.m_flWallRunTime <= 0.0f)
     {
         // time's up
@@ -3846,6 +3907,8 @@ void CMomentumGameMovement::WaterJumpParkour()
 //-----------------------------------------------------------------------------
 void CMomentumGameMovement::WallRunAnticipateBump()
 {
+    MOVEMENT_PROFILE_PHASE(MOVEPHASE_WALLRUN);
+
     Vector start, move, dest, temp, newheading, newnormal;
     trace_t pm;
     QAngle angles, bumpangles;
@@ -41,12 +41,23 @@ public:
     void DecayPunchAngle() override;
 
     int TryPlayerMove(Vector *pFirstDest = nullptr, trace_t *pFirstTrace = nullptr) override;
+
+    // Looks for a plane to clip against when stuck on a ramp
+    static bool FindRampFixPlane(const Vector &origin, const Vector &end, const Vector &mins, const Vector &maxs,
+                                 unsigned int mask, IHandleEntity *pIgnore, int bumpcount, Vector &plane, trace_t &pm);
     void FullWalkMove() override;
     void StepMove(Vector &vecDestination, trace_t &trace) override;
     void CategorizePosition() override;
 
     void ProcessMovement(CBasePlayer *pBasePlayer, CMoveData *pMove) override;
 
+#ifdef GAME_DLL
+    // Overridden to count traces for the movement profiler
+    void TracePlayerBBox(const Vector &start, const Vector &end, unsigned int fMask, int collisionGroup, trace_t &pm) override;
+    void TryTouchGround(const Vector &start, const Vector &end, const Vector &mins, const Vector &maxs, unsigned int fMask,
+                        int collisionGroup, trace_t &pm) override;
+#endif
+
     void Friction() override;
 
     float GetWaterWaistOffset() override;
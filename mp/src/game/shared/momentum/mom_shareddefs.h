@@ -339,7 +339,11 @@ enum WallRunState
 #define RECORDING_PATH "replays"
 #define RECORDING_ONLINE_PATH "online"
 #define EXT_ZONE_FILE ".zon"
+#define EXT_ZONE_CACHE_FILE ".zonc"
+#define EXT_TRICK_CACHE_FILE ".trkc"
 #define EXT_RECORDING_FILE ".mrf"
+#define EXT_RECORDING_INDEX_FILE ".mri"
+#define EXT_RECORDING_ANALYSIS_FILE ".mra"
 
 // MOM_TODO: Replace this with the custom player model
 #define ENTITY_MODEL "models/player/player_shape_base.mdl"
@@ -5,9 +5,12 @@
 #include "mom_player_shared.h"
 #include "mom_system_gamemode.h"
 #include "util/mom_util.h"
+#include "util/mom_file_hash_cache.h"
 
 #include "filesystem.h"
 #include "fmtstr.h"
+#include "utlbuffer.h"
+#include "vstdlib/random.h"
 
 #ifdef CLIENT_DLL
 #include "mom_map_cache.h"
@@ -20,6 +23,17 @@
 
 #include "tier0/memdbgon.h"
 
+#define TRICK_CACHE_MAGIC 0x43544D4D // "MMTC"
+#define TRICK_CACHE_VERSION 1
+
+// The trick cache is a header followed by records. Changes get appended as records after the last full write.
+enum TrickCacheRecordType_t
+{
+    TRICK_CACHE_RECORD_ZONES = 0,
+    TRICK_CACHE_RECORD_TRICK,
+    TRICK_CACHE_RECORD_MAP_TELE,
+};
+
 #ifdef GAME_DLL
 CON_COMMAND_F(mom_tricks_record, "Start recording zones to make a trick.\n", FCVAR_MAPPING)
 {
@@ -96,6 +110,16 @@ void TrickStepConstraint_MaxSpeed::SaveToKeyValues(KeyValues* pKvOut)
     pKvOut->SetFloat("speed", m_flMaxSpeed);
 }
 
+void TrickStepConstraint_MaxSpeed::SaveToBuffer(CUtlBuffer &buf)
+{
+    buf.PutFloat(m_flMaxSpeed);
+}
+
+void TrickStepConstraint_MaxSpeed::LoadFromBuffer(CUtlBuffer &buf)
+{
+    m_flMaxSpeed = buf.GetFloat();
+}
+
 CTrickStep::CTrickStep()
 {
     m_bOptional = false;
@@ -194,6 +218,65 @@ void CTrickStep::LoadFromKV(KeyValues* pKvIn)
     }
 }
 
+void CTrickStep::SaveToBuffer(CUtlBuffer &buf)
+{
+    buf.PutUnsignedChar(m_bOptional);
+    buf.PutInt(m_iTrickZoneID);
+
+    buf.PutInt(m_vecConstraints.Count());
+    FOR_EACH_VEC(m_vecConstraints, i)
+    {
+        buf.PutInt(m_vecConstraints[i]->GetType());
+
+        // Sized so that constraints we don't know about can be skipped
+        const auto iSizePos = buf.TellPut();
+        buf.PutInt(0);
+        m_vecConstraints[i]->SaveToBuffer(buf);
+
+        const auto iEndPos = buf.TellPut();
+        buf.SeekPut(CUtlBuffer::SEEK_HEAD, iSizePos);
+        buf.PutInt(iEndPos - iSizePos - sizeof(int));
+        buf.SeekPut(CUtlBuffer::SEEK_HEAD, iEndPos);
+    }
+}
+
+bool CTrickStep::LoadFromBuffer(CUtlBuffer &buf)
+{
+    m_bOptional = buf.GetUnsignedChar() != 0;
+    m_iTrickZoneID = buf.GetInt();
+
+    const auto iConstraintCount = buf.GetInt();
+    for (int i = 0; i < iConstraintCount && buf.IsValid(); i++)
+    {
+        const auto iType = buf.GetInt();
+        const auto iSize = buf.GetInt();
+        const auto iEndPos = buf.TellGet() + iSize;
+
+        ITrickStepConstraint *pConstraint = nullptr;
+        switch (iType)
+        {
+        case CONSTRAINT_SPEED_MAX:
+            pConstraint = new TrickStepConstraint_MaxSpeed;
+        default:
+            break;
+        }
+
+        if (pConstraint)
+        {
+            pConstraint->LoadFromBuffer(buf);
+            m_vecConstraints.AddToTail(pConstraint);
+        }
+        else
+        {
+            Warning("!!! Unknown trick constraint type %i !!!\n", iType);
+        }
+
+        buf.SeekGet(CUtlBuffer::SEEK_HEAD, iEndPos);
+    }
+
+    return buf.IsValid() && m_iTrickZoneID >= 0;
+}
+
 CTrickInfo::CTrickInfo()
 {
     m_szCreationDate[0] = '\0';
@@ -251,9 +334,48 @@ void CTrickInfo::LoadFromKV(KeyValues* pKvIn)
     }
 }
 
+void CTrickInfo::SaveToBuffer(CUtlBuffer &buf)
+{
+    buf.PutInt(m_iDifficulty);
+    buf.PutString(m_szName);
+    buf.PutString(m_szCreatorName);
+    buf.PutString(m_szCreationDate);
+
+    buf.PutInt(m_vecTags.Count());
+    FOR_EACH_VEC(m_vecTags, i)
+    {
+        buf.PutInt(m_vecTags[i]->m_iID);
+        buf.PutString(m_vecTags[i]->m_szTagName);
+    }
+}
+
+void CTrickInfo::LoadFromBuffer(CUtlBuffer &buf)
+{
+    m_iDifficulty = buf.GetInt();
+    buf.GetString(m_szName);
+    buf.GetString(m_szCreatorName);
+    buf.GetString(m_szCreationDate);
+
+    const auto iTagCount = buf.GetInt();
+    for (int i = 0; i < iTagCount && buf.IsValid(); i++)
+    {
+        CTrickTag *pTag = new CTrickTag;
+        pTag->m_iID = buf.GetInt();
+        buf.GetString(pTag->m_szTagName);
+
+        m_vecTags.AddToTail(pTag);
+    }
+}
+
 CTrick::CTrick()
 {
     m_iID = -1;
+    m_pAttempt = nullptr;
+}
+
+CTrick::~CTrick()
+{
+    m_vecSteps.PurgeAndDeleteElements();
 }
 
 void CTrick::SetName(const char* pName)
@@ -308,68 +430,155 @@ bool CTrick::LoadFromKV(KeyValues* pKvIn)
     return true;
 }
 
-CTrickAttempt::CTrickAttempt(CTrick *pTrick) : m_pTrick(pTrick)
+void CTrick::SaveToBuffer(CUtlBuffer &buf)
 {
-    m_iStartTick = gpGlobals->tickcount;
-    m_iCurrentStep = 0;
+    buf.PutInt(m_iID);
+
+    m_Info.SaveToBuffer(buf);
+
+    buf.PutInt(m_vecSteps.Count());
+    FOR_EACH_VEC(m_vecSteps, i)
+    {
+        m_vecSteps[i]->SaveToBuffer(buf);
+    }
 }
 
-#ifdef GAME_DLL
-bool CTrickAttempt::ShouldContinue(CTriggerTrickZone *pZone, CMomentumPlayer *pPlayer)
+bool CTrick::LoadFromBuffer(CUtlBuffer &buf)
 {
-    int iTotalSteps = m_pTrick->StepCount();
-    int iNextStep = m_iCurrentStep + 1;
+    m_iID = buf.GetInt();
+
+    m_Info.LoadFromBuffer(buf);
 
-    // Go through the trick stepping over optional zones to find our next step
-    for (auto pNextStep = m_pTrick->Step(iNextStep);
-         iNextStep < iTotalSteps && pNextStep;
-         pNextStep = m_pTrick->Step(++iNextStep))
+    const auto iStepCount = buf.GetInt();
+    for (int i = 0; i < iStepCount && buf.IsValid(); i++)
     {
-        // Early out if this trick's sequence is properly broken
-        if (pNextStep->GetTrigger() != pZone && !pNextStep->IsOptional())
+        const auto pStep = new CTrickStep;
+        m_vecSteps.AddToTail(pStep);
+
+        if (!pStep->LoadFromBuffer(buf))
             return false;
+    }
 
-        // Here: the trigger is our zone, AND/OR we're optional
+    return buf.IsValid() && !m_vecSteps.IsEmpty();
+}
 
-        if (pNextStep->GetTrigger() == pZone)
-        {
-            if (pNextStep->IsOptional())
-            {
-                // Increase our step and continue
-                m_iCurrentStep = iNextStep;
-                return true;
-            }
+void CTrick::BuildStepEdges()
+{
+    m_vecStepEdges.RemoveAll();
+    m_vecStepEdgesStart.RemoveAll();
 
-            // Otherwise we're necessary
+    const auto iStepCount = m_vecSteps.Count();
+    for (int iStep = 0; iStep < iStepCount; iStep++)
+    {
+        m_vecStepEdgesStart.AddToTail(m_vecStepEdges.Count());
 
-            // Do we pass the constraints?
-            if (!pNextStep->PlayerPassesConstraints(pPlayer))
-                return false;
+        // Every optional step up to and including the next required one can be entered from here
+        for (int iNextStep = iStep + 1; iNextStep < iStepCount; iNextStep++)
+        {
+            const auto pNextStep = m_vecSteps[iNextStep];
 
-            // Trigger was our guy, wasn't optional, and we passed the constraints. Get outta here.
-            break;
-        }
+            TrickStepEdge_t edge;
+            edge.m_iZoneID = pNextStep->GetTriggerID();
+            edge.m_iStep = iNextStep;
+            m_vecStepEdges.AddToTail(edge);
 
-        // Otherwise the trigger isn't our guy, but we're still optional, so we continue the loop.
-        // We either find the next optional zone in the sequence, the next required zone,
-        // or you hit a no-no zone and your trick will crash and burn
+            if (!pNextStep->IsOptional())
+                break;
+        }
     }
 
-    // Is the trick done?
-    if (iNextStep == iTotalSteps - 1)
+    m_vecStepEdgesStart.AddToTail(m_vecStepEdges.Count());
+}
+
+int CTrick::FindNextStep(int iCurrentStep, int iZoneID) const
+{
+    if (iCurrentStep < 0 || iCurrentStep + 1 >= m_vecStepEdgesStart.Count())
+        return -1;
+
+    // The first edge into the zone wins, so an optional step is taken over a later step in the same zone
+    const auto iEnd = m_vecStepEdgesStart[iCurrentStep + 1];
+    for (int i = m_vecStepEdgesStart[iCurrentStep]; i < iEnd; i++)
     {
-        Complete(pPlayer);
-        g_pTrickSystem->CompleteTrick(this);
-        return false; // This removes the attempt automatically
+        if (m_vecStepEdges[i].m_iZoneID == iZoneID)
+            return m_vecStepEdges[i].m_iStep;
     }
 
-    if (iNextStep >= iTotalSteps)
+    return -1;
+}
+
+void CTrickStartIndex::AddTrick(CTrick *pTrick)
+{
+    pTrick->BuildStepEdges();
+
+    const auto pFirstStep = pTrick->Step(0);
+    if (!pFirstStep || pFirstStep->GetTriggerID() < 0)
+        return;
+
+    const auto iZoneID = pFirstStep->GetTriggerID();
+    if (iZoneID >= m_vecTricksByZone.Count())
+        m_vecTricksByZone.AddMultipleToTail(iZoneID + 1 - m_vecTricksByZone.Count());
+
+    m_vecTricksByZone[iZoneID].AddToTail(pTrick);
+}
+
+const CUtlVector<CTrick*> *CTrickStartIndex::GetTricksStartingIn(int iZoneID) const
+{
+    if (iZoneID < 0 || iZoneID >= m_vecTricksByZone.Count() || m_vecTricksByZone[iZoneID].IsEmpty())
+        return nullptr;
+
+    return &m_vecTricksByZone[iZoneID];
+}
+
+CTrickAttempt::CTrickAttempt(CTrick *pTrick) : m_pTrick(pTrick)
+{
+    m_iStartTick = gpGlobals->tickcount;
+    m_iCurrentStep = 0;
+
+    m_pTrick->SetAttempt(this);
+}
+
+CTrickAttempt::~CTrickAttempt()
+{
+    if (m_pTrick->GetAttempt() == this)
+        m_pTrick->SetAttempt(nullptr);
+}
+
+#ifdef GAME_DLL
+TrickAdvanceResult_t CTrickAttempt::Advance(int iZoneID, CMomentumPlayer *pPlayer)
+{
+    // Early out if this trick's sequence is properly broken
+    const auto iNextStep = m_pTrick->FindNextStep(m_iCurrentStep, iZoneID);
+    if (iNextStep < 0)
+        return TRICK_ADVANCE_FAIL;
+
+    const auto pNextStep = m_pTrick->Step(iNextStep);
+    if (!pNextStep->IsOptional())
     {
-        return false;
+        // Do we pass the constraints?
+        if (pPlayer && !pNextStep->PlayerPassesConstraints(pPlayer))
+            return TRICK_ADVANCE_FAIL;
+
+        // Is the trick done?
+        if (iNextStep == m_pTrick->StepCount() - 1)
+            return TRICK_ADVANCE_COMPLETE;
     }
 
     m_iCurrentStep = iNextStep;
-    return true;
+    return TRICK_ADVANCE_CONTINUE;
+}
+
+bool CTrickAttempt::ShouldContinue(CTriggerTrickZone *pZone, CMomentumPlayer *pPlayer)
+{
+    const auto result = Advance(pZone->m_iID, pPlayer);
+
+    if (result == TRICK_ADVANCE_COMPLETE)
+    {
+        Complete(pPlayer);
+        g_pTrickSystem->CompleteTrick(this);
+        return false; // This removes the attempt automatically
+    }
+
+    return result == TRICK_ADVANCE_CONTINUE;
 }
 
 void CTrickAttempt::Complete(CMomentumPlayer* pPlayer)
@@ -410,6 +619,30 @@ void CMapTeleport::LoadFromKV(KeyValues* pKvIn)
 #endif
 }
 
+void CMapTeleport::SaveToBuffer(CUtlBuffer &buf)
+{
+    buf.PutString(m_szName);
+#ifdef GAME_DLL
+    buf.PutUnsignedChar(m_pLoc != nullptr);
+    if (m_pLoc)
+        m_pLoc->Write(buf);
+#endif
+}
+
+// The client only cares about the name, the rest of the record is skipped by the cache reader
+void CMapTeleport::LoadFromBuffer(CUtlBuffer &buf)
+{
+    buf.GetString(m_szName);
+
+#ifdef GAME_DLL
+    if (buf.GetUnsignedChar())
+    {
+        m_pLoc = new SavedLocation_t;
+        m_pLoc->Read(buf);
+    }
+#endif
+}
+
 CTrickSystem::CTrickSystem() : CAutoGameSystem("CTrickSystem"
 #ifdef CLIENT_DLL
 "_CLIENT"
@@ -419,10 +652,13 @@ CTrickSystem::CTrickSystem() : CAutoGameSystem("CTrickSystem"
 #ifdef GAME_DLL
     m_iTrackedTrick = -1;
     m_bRecording = false;
+    m_bTrickDataDirty = false;
+    m_bTrickCacheStale = false;
 #endif
 }
 
 #define GetTricksFileName() CFmtStr("%s/%s.tricks", ZONE_FOLDER, MapName()).Get()
+#define GetTrickCacheFileName() CFmtStr("%s/%s" EXT_TRICK_CACHE_FILE, ZONE_FOLDER, MapName()).Get()
 
 #ifdef CLIENT_DLL
 void CTrickSystem::LevelInitPreEntity()
@@ -437,13 +673,29 @@ void CTrickSystem::LevelInitPreEntity()
     }
     else
     {
+        char szHash[41];
+        const bool bHashed = g_pFileHashCache->GetFileHash(szHash, sizeof(szHash), GetTricksFileName(), "MOD");
+        if (bHashed && LoadTrickDataFromCache(szHash))
+        {
+            // The server reads the same cache, no need to send it the whole trick data
+            const auto pCacheKV = new KeyValues(TRICK_DATA_KEY);
+            pCacheKV->SetString("cache", szHash);
+            SendTrickDataToServer(pCacheKV);
+            return;
+        }
+
         const auto trickData = new KeyValues(TRICK_DATA_KEY);
         if (!trickData->LoadFromFile(g_pFullFileSystem, GetTricksFileName(), "MOD"))
         {
+            trickData->deleteThis();
             Warning("No trick data file found for the map %s !\n", MapName());
             return;
         }
 
+        // Lets the server build the trick cache for next time
+        if (bHashed)
+            trickData->SetString("source_hash", szHash);
+
         InitializeTrickData(trickData);
     }
 }
@@ -468,6 +720,11 @@ void CTrickSystem::InitializeTrickData(KeyValues *pTrickData)
 {
     LoadTrickDataFromFile(pTrickData);
 
+    SendTrickDataToServer(pTrickData);
+}
+
+void CTrickSystem::SendTrickDataToServer(KeyValues *pTrickData)
+{
     engine->ServerCmdKeyValues(pTrickData);
 
     const auto pEvent = gameeventmanager->CreateEvent("trick_data_loaded");
@@ -484,12 +741,18 @@ void CTrickSystem::LevelShutdownPreEntity()
         return;
 
 #ifdef GAME_DLL
-    SaveTrickDataToFile();
+    if (m_bTrickDataDirty)
+        SaveTrickDataToFile();
+
     ClearTrickAttempts();
     SetTrackedTrick(-1);
+
+    m_bTrickDataDirty = false;
+    m_bTrickCacheStale = false;
 #endif
 
     m_vecRecordedZones.RemoveAll();
+    m_TrickStartIndex.Purge();
     m_llTrickList.PurgeAndDeleteElements();
     m_vecTrickZones.RemoveAll();
     m_vecMapTeleports.PurgeAndDeleteElements();
@@ -545,35 +808,24 @@ void CTrickSystem::OnTrickZoneExit(CTriggerTrickZone *pZone, CMomentumPlayer *pP
     }
     else
     {
-        FOR_EACH_LL(m_llTrickList, i)
+        const auto pStartingTricks = m_TrickStartIndex.GetTricksStartingIn(pZone->m_iID);
+        if (pStartingTricks)
         {
-            const auto pTrick = m_llTrickList[i];
-            const auto pTrickFirstStep = pTrick->Step(0);
-            if (pTrickFirstStep->GetTrigger() == pZone && pTrickFirstStep->PlayerPassesConstraints(pPlayer))
+            FOR_EACH_VEC(*pStartingTricks, i)
             {
-                bool bFound = false;
-                FOR_EACH_VEC(m_vecCurrentTrickAttempts, trickItr)
-                {
-                    const auto pTrickAttempt = m_vecCurrentTrickAttempts[trickItr];
-                    if (pTrickAttempt->GetTrick() == pTrick)
-                    {
-                        bFound = true;
-                        break;
-                    }
-                }
+                const auto pTrick = pStartingTricks->Element(i);
+                if (pTrick->GetAttempt() || !pTrick->Step(0)->PlayerPassesConstraints(pPlayer))
+                    continue;
 
-                if (!bFound)
-                {
-                    const auto pTrickAttempt = new CTrickAttempt(pTrick);
-                    m_vecCurrentTrickAttempts.AddToTail(pTrickAttempt);
-                    DevMsg("Added trick attempt for trick %s !\n", pTrick->GetName());
+                const auto pTrickAttempt = new CTrickAttempt(pTrick);
+                m_vecCurrentTrickAttempts.AddToTail(pTrickAttempt);
+                DevMsg("Added trick attempt for trick %s !\n", pTrick->GetName());
 
-                    if (m_iTrackedTrick == pTrick->GetID())
-                    {
-                        pPlayer->m_Data.m_iCurrentZone = 0;
+                if (m_iTrackedTrick == pTrick->GetID())
+                {
+                    pPlayer->m_Data.m_iCurrentZone = 0;
 
-                        SendTrickTrackEvent(TRICK_TRACK_UPDATE_STEP, 0);
-                    }
+                    SendTrickTrackEvent(TRICK_TRACK_UPDATE_STEP, 0);
                 }
             }
         }
@@ -659,9 +911,11 @@ void CTrickSystem::SaveTrickDataToFile()
 
         FOR_EACH_VEC(m_vecTrickZones, i)
         {
-            const auto pZoneKV = pZonesKV->CreateNewKey();
-
             const auto pZoneTrigger = m_vecTrickZones[i];
+            if (!pZoneTrigger)
+                continue;
+
+            const auto pZoneKV = pZonesKV->CreateNewKey();
 
             bool bSuccess = false;
             if (pZoneTrigger->ToKeyValues(pZoneKV))
@@ -712,7 +966,113 @@ void CTrickSystem::SaveTrickDataToFile()
         trickDataKV->AddSubKey(pMapTeleKV);
     }
 
-    trickDataKV->SaveToFile(g_pFullFileSystem, GetTricksFileName(), "MOD");
+    if (!trickDataKV->SaveToFile(g_pFullFileSystem, GetTricksFileName(), "MOD"))
+    {
+        Warning("Failed to save the trick data to %s!\n", GetTricksFileName());
+        return;
+    }
+
+    char szHash[41];
+    if (g_pFileHashCache->GetFileHash(szHash, sizeof(szHash), GetTricksFileName(), "MOD"))
+        WriteTrickDataCache(szHash, trickDataKV->FindKey("zones"));
+
+    m_bTrickDataDirty = false;
+    m_bTrickCacheStale = false;
+}
+
+static int BeginTrickCacheRecord(CUtlBuffer &buf, TrickCacheRecordType_t type)
+{
+    buf.PutUnsignedChar(type);
+    const auto iSizePos = buf.TellPut();
+    buf.PutInt(0);
+    return iSizePos;
+}
+
+static void EndTrickCacheRecord(CUtlBuffer &buf, int iSizePos)
+{
+    const auto iEndPos = buf.TellPut();
+    buf.SeekPut(CUtlBuffer::SEEK_HEAD, iSizePos);
+    buf.PutInt(iEndPos - iSizePos - sizeof(int));
+    buf.SeekPut(CUtlBuffer::SEEK_HEAD, iEndPos);
+}
+
+void CTrickSystem::WriteTrickDataCache(const char *pSourceHash, KeyValues *pZonesKV)
+{
+    CUtlBuffer writer;
+    writer.PutUnsignedInt(TRICK_CACHE_MAGIC);
+    writer.PutUnsignedChar(TRICK_CACHE_VERSION);
+    writer.PutString(pSourceHash);
+    const auto iCountPos = writer.TellPut();
+    writer.PutInt(0);
+
+    int iRecords = 0;
+    if (pZonesKV)
+    {
+        // WriteAsBinary writes the peers too, detach the zones from the rest of the trick data while writing them
+        const auto pPeer = pZonesKV->GetNextKey();
+        pZonesKV->SetNextKey(nullptr);
+
+        const auto iSizePos = BeginTrickCacheRecord(writer, TRICK_CACHE_RECORD_ZONES);
+        pZonesKV->WriteAsBinary(writer);
+        EndTrickCacheRecord(writer, iSizePos);
+        iRecords++;
+
+        pZonesKV->SetNextKey(pPeer);
+    }
+
+    FOR_EACH_VEC(m_vecMapTeleports, i)
+    {
+        const auto iSizePos = BeginTrickCacheRecord(writer, TRICK_CACHE_RECORD_MAP_TELE);
+        m_vecMapTeleports[i]->SaveToBuffer(writer);
+        EndTrickCacheRecord(writer, iSizePos);
+        iRecords++;
+    }
+
+    FOR_EACH_LL(m_llTrickList, i)
+    {
+        const auto iSizePos = BeginTrickCacheRecord(writer, TRICK_CACHE_RECORD_TRICK);
+        m_llTrickList[i]->SaveToBuffer(writer);
+        EndTrickCacheRecord(writer, iSizePos);
+        iRecords++;
+    }
+
+    const auto iEndPos = writer.TellPut();
+    writer.SeekPut(CUtlBuffer::SEEK_HEAD, iCountPos);
+    writer.PutInt(iRecords);
+    writer.SeekPut(CUtlBuffer::SEEK_HEAD, iEndPos);
+
+    if (!g_pFullFileSystem->WriteFile(GetTrickCacheFileName(), "MOD", writer))
+        Warning("Failed to write the trick cache %s!\n", GetTrickCacheFileName());
+}
+
+bool CTrickSystem::AppendToTrickDataCache(CTrick *pTrick, CMapTeleport *pMapTele)
+{
+    if (m_bTrickCacheStale || !g_pFullFileSystem->FileExists(GetTrickCacheFileName(), "MOD"))
+        return false;
+
+    CUtlBuffer writer;
+    if (pTrick)
+    {
+        const auto iSizePos = BeginTrickCacheRecord(writer, TRICK_CACHE_RECORD_TRICK);
+        pTrick->SaveToBuffer(writer);
+        EndTrickCacheRecord(writer, iSizePos);
+    }
+
+    if (pMapTele)
+    {
+        const auto iSizePos = BeginTrickCacheRecord(writer, TRICK_CACHE_RECORD_MAP_TELE);
+        pMapTele->SaveToBuffer(writer);
+        EndTrickCacheRecord(writer, iSizePos);
+    }
+
+    const auto hFile = g_pFullFileSystem->Open(GetTrickCacheFileName(), "ab", "MOD");
+    if (hFile == FILESYSTEM_INVALID_HANDLE)
+        return false;
+
+    const auto iWritten = g_pFullFileSystem->Write(writer.Base(), writer.TellPut(), hFile);
+    g_pFullFileSystem->Close(hFile);
+
+    return iWritten == writer.TellPut();
 }
 
 void CTrickSystem::StartRecording()
@@ -768,11 +1128,16 @@ void CTrickSystem::StopRecording(const char *pTrickName)
         pTrick->AddStep(pTrickStep);
     }
 
+    m_TrickStartIndex.AddTrick(pTrick);
+
     m_bRecording = false;
 
     Warning("================= MOM_TODO: Needs to network to the client!\n");
 
-    SaveTrickDataToFile();
+    // The trick file itself gets rewritten at level shutdown
+    m_bTrickDataDirty = true;
+    if (!AppendToTrickDataCache(pTrick, nullptr))
+        SaveTrickDataToFile();
 }
 #endif
 
@@ -804,6 +1169,11 @@ void CTrickSystem::AddZone(CTriggerTrickZone* pZone)
     if (pZone->m_iID == -1) // Created by zone creator, assign an ID
     {
         pZone->m_iID = m_vecTrickZones.AddToTail();
+
+#ifdef GAME_DLL
+        m_bTrickDataDirty = true;
+        m_bTrickCacheStale = true;
+#endif
     }
     else
     {
@@ -813,6 +1183,21 @@ void CTrickSystem::AddZone(CTriggerTrickZone* pZone)
     m_vecTrickZones[pZone->m_iID] = pZone;
 }
 
+void CTrickSystem::RemoveZone(CTriggerTrickZone *pZone)
+{
+    // Zones are also removed after the trick data was cleared on level shutdown
+    const int iID = pZone->m_iID;
+    if (iID < 0 || iID >= m_vecTrickZones.Count() || m_vecTrickZones[iID] != pZone)
+        return;
+
+    m_vecTrickZones[iID] = nullptr;
+
+#ifdef GAME_DLL
+    m_bTrickDataDirty = true;
+    m_bTrickCacheStale = true;
+#endif
+}
+
 #ifdef GAME_DLL
 CTrickAttempt* CTrickSystem::GetTrickAttemptForTrick(int iTrickID)
 {
@@ -982,7 +1367,9 @@ void CTrickSystem::CreateMapTeleport(const char* pName)
 
     m_vecMapTeleports.AddToTail(pMapTeleport);
 
-    SaveTrickDataToFile();
+    m_bTrickDataDirty = true;
+    if (!AppendToTrickDataCache(nullptr, pMapTeleport))
+        SaveTrickDataToFile();
 }
 
 void CTrickSystem::GoToMapTeleport(int iTeleportNum)
@@ -1004,6 +1391,27 @@ void CTrickSystem::LoadTrickDataFromFile(KeyValues *pKvTrickData)
     const auto pMapName = MapName();
     Assert(pMapName && *pMapName);
 
+#ifdef GAME_DLL
+    const auto pCacheHash = pKvTrickData->GetString("cache", nullptr);
+    if (pCacheHash)
+    {
+        if (LoadTrickDataFromCache(pCacheHash))
+            return;
+
+        // The client could read the cache but we can't, load the trick file ourselves
+        KeyValuesAD fileKV(TRICK_DATA_KEY);
+        if (!fileKV->LoadFromFile(g_pFullFileSystem, GetTricksFileName(), "MOD"))
+        {
+            Warning("No trick data file found for the map %s !\n", pMapName);
+            return;
+        }
+
+        fileKV->SetString("source_hash", pCacheHash);
+        LoadTrickDataFromFile(fileKV);
+        return;
+    }
+#endif
+
     const auto pMapTelesKV = pKvTrickData->FindKey("map_teles");
     if (pMapTelesKV && !pMapTelesKV->IsEmpty())
     {
@@ -1026,29 +1434,8 @@ void CTrickSystem::LoadTrickDataFromFile(KeyValues *pKvTrickData)
 
     FOR_EACH_SUBKEY(pZones, pZoneKV)
     {
-        const auto pEntity = dynamic_cast<CTriggerTrickZone *>(CreateEntityByName("trigger_momentum_trick"));
-
-        AssertMsg(pEntity, "Trick zone entity failed to create!!");
-
-        if (pEntity)
-        {
-            if (!pEntity->LoadFromKeyValues(pZoneKV))
-            {
-                Warning("Failed to load trick zone!\n");
-                Assert(false);
-                return;
-            }
-
-            CMomBaseZoneBuilder *pBaseBuilder = CreateZoneBuilderFromKeyValues(pZoneKV);
-
-            pBaseBuilder->BuildZone();
-            pEntity->Spawn();
-            pBaseBuilder->FinishZone(pEntity);
-
-            pEntity->Activate();
-
-            delete pBaseBuilder;
-        }
+        if (!SpawnTrickZone(pZoneKV))
+            return;
     }
 #endif
 
@@ -1067,8 +1454,178 @@ void CTrickSystem::LoadTrickDataFromFile(KeyValues *pKvTrickData)
         if (pNewTrick->LoadFromKV(pTrickKV))
         {
             m_llTrickList.AddToTail(pNewTrick);
+            m_TrickStartIndex.AddTrick(pNewTrick);
+        }
+    }
+
+#ifdef GAME_DLL
+    const auto pSourceHash = pKvTrickData->GetString("source_hash", nullptr);
+    if (pSourceHash)
+    {
+        WriteTrickDataCache(pSourceHash, pZones);
+    }
+#endif
+}
+
+#ifdef GAME_DLL
+bool CTrickSystem::SpawnTrickZone(KeyValues *pZoneKV)
+{
+    const auto pEntity = dynamic_cast<CTriggerTrickZone *>(CreateEntityByName("trigger_momentum_trick"));
+
+    AssertMsg(pEntity, "Trick zone entity failed to create!!");
+
+    if (pEntity)
+    {
+        if (!pEntity->LoadFromKeyValues(pZoneKV))
+        {
+            Warning("Failed to load trick zone!\n");
+            Assert(false);
+            return false;
+        }
+
+        CMomBaseZoneBuilder *pBaseBuilder = CreateZoneBuilderFromKeyValues(pZoneKV);
+
+        pBaseBuilder->BuildZone();
+        pEntity->Spawn();
+        pBaseBuilder->FinishZone(pEntity);
+
+        pEntity->Activate();
+
+        delete pBaseBuilder;
+    }
+
+    return true;
+}
+#endif
+
+bool CTrickSystem::LoadTrickDataFromCache(const char *pSourceHash)
+{
+    CUtlBuffer reader;
+    if (!g_pFullFileSystem->ReadFile(GetTrickCacheFileName(), "MOD", reader))
+        return false;
+
+    if (reader.GetUnsignedInt() != TRICK_CACHE_MAGIC || reader.GetUnsignedChar() != TRICK_CACHE_VERSION)
+        return false;
+
+    char szCachedHash[41];
+    reader.GetString(szCachedHash);
+    if (!FStrEq(szCachedHash, pSourceHash))
+        return false;
+
+    // Records past these were appended since the cache was last written in full
+    const auto iWrittenRecords = reader.GetInt();
+
+    // Read everything before adding anything, a corrupt cache falls back to the trick file
+    CUtlVector<CTrick*> vecTricks;
+    CUtlVector<CMapTeleport*> vecMapTeles;
+    KeyValues *pZonesKV = nullptr;
+    int iRecords = 0;
+    bool bValid = reader.IsValid();
+    while (bValid && reader.GetBytesRemaining() > 0)
+    {
+        const auto type = reader.GetUnsignedChar();
+        const auto iSize = reader.GetInt();
+        if (!reader.IsValid() || iSize < 0 || iSize > reader.GetBytesRemaining())
+        {
+            bValid = false;
+            break;
+        }
+
+        const auto iEndPos = reader.TellGet() + iSize;
+
+        switch (type)
+        {
+        case TRICK_CACHE_RECORD_ZONES:
+#ifdef GAME_DLL
+            if (pZonesKV)
+                pZonesKV->deleteThis();
+            pZonesKV = new KeyValues("zones");
+            bValid = pZonesKV->ReadAsBinary(reader);
+#endif
+            break;
+        case TRICK_CACHE_RECORD_TRICK:
+            {
+                const auto pTrick = new CTrick;
+                if (!pTrick->LoadFromBuffer(reader))
+                {
+                    delete pTrick;
+                    bValid = false;
+                    break;
+                }
+
+                // Appended tricks replace the ones with the same ID
+                bool bReplaced = false;
+                if (iRecords >= iWrittenRecords)
+                {
+                    FOR_EACH_VEC(vecTricks, i)
+                    {
+                        if (vecTricks[i]->GetID() == pTrick->GetID())
+                        {
+                            delete vecTricks[i];
+                            vecTricks[i] = pTrick;
+                            bReplaced = true;
+                            break;
+                        }
+                    }
+                }
+
+                if (!bReplaced)
+                    vecTricks.AddToTail(pTrick);
+            }
+            break;
+        case TRICK_CACHE_RECORD_MAP_TELE:
+            {
+                const auto pMapTele = new CMapTeleport;
+                pMapTele->LoadFromBuffer(reader);
+                vecMapTeles.AddToTail(pMapTele);
+            }
+            break;
+        default:
+            break;
+        }
+
+        bValid = bValid && reader.IsValid() && reader.TellGet() <= iEndPos;
+        if (!bValid)
+            break;
+
+        reader.SeekGet(CUtlBuffer::SEEK_HEAD, iEndPos);
+        iRecords++;
+    }
+
+    if (!bValid || iRecords < iWrittenRecords)
+    {
+        Warning("Trick cache %s is corrupt, rebuilding it...\n", GetTrickCacheFileName());
+        vecTricks.PurgeAndDeleteElements();
+        vecMapTeles.PurgeAndDeleteElements();
+        if (pZonesKV)
+            pZonesKV->deleteThis();
+        return false;
+    }
+
+#ifdef GAME_DLL
+    if (pZonesKV)
+    {
+        FOR_EACH_SUBKEY(pZonesKV, pZoneKV)
+        {
+            SpawnTrickZone(pZoneKV);
         }
+
+        pZonesKV->deleteThis();
+    }
+
+    // Get the appended changes into the trick file at level shutdown
+    m_bTrickDataDirty = iRecords > iWrittenRecords;
+#endif
+
+    m_vecMapTeleports.AddVectorToTail(vecMapTeles);
+
+    FOR_EACH_VEC(vecTricks, i)
+    {
+        m_llTrickList.AddToTail(vecTricks[i]);
+        m_TrickStartIndex.AddTrick(vecTricks[i]);
     }
+
+    return true;
 }
 
 void CTrickSystem::LoadTrickDataFromSite(KeyValues* pKvTrickData)
@@ -1076,5 +1633,199 @@ void CTrickSystem::LoadTrickDataFromSite(KeyValues* pKvTrickData)
     AssertMsg(false, "Implement me!!");
 }
 
+#ifdef GAME_DLL
+struct TrickBenchAttempt_t
+{
+    CTrick *m_pTrick;
+    int m_iStep;
+};
+
+// The pre-index matching: every trick is checked on zone exit, and attempts walk their steps on zone enter
+static int TrickBenchLinear(CUtlVector<CTrick*> &tricks, const CUtlVector<int> &vecZoneWalk)
+{
+    CUtlVector<TrickBenchAttempt_t> attempts;
+    int iCompleted = 0;
+
+    FOR_EACH_VEC(vecZoneWalk, walkItr)
+    {
+        const auto iZoneID = vecZoneWalk[walkItr];
+
+        FOR_EACH_VEC_BACK(attempts, i)
+        {
+            auto &attempt = attempts[i];
+            const auto iTotalSteps = attempt.m_pTrick->StepCount();
+
+            int iNextStep = attempt.m_iStep + 1;
+            bool bContinue = false;
+            for (; iNextStep < iTotalSteps; iNextStep++)
+            {
+                const auto pNextStep = attempt.m_pTrick->Step(iNextStep);
+                if (pNextStep->GetTriggerID() == iZoneID)
+                {
+                    bContinue = pNextStep->IsOptional() || iNextStep != iTotalSteps - 1;
+                    iCompleted += !bContinue;
+                    break;
+                }
+
+                if (!pNextStep->IsOptional())
+                    break;
+            }
+
+            if (bContinue && iNextStep < iTotalSteps)
+                attempt.m_iStep = iNextStep;
+            else
+                attempts.Remove(i);
+        }
+
+        FOR_EACH_VEC(tricks, i)
+        {
+            const auto pTrick = tricks[i];
+            if (pTrick->Step(0)->GetTriggerID() != iZoneID)
+                continue;
+
+            bool bFound = false;
+            FOR_EACH_VEC(attempts, attemptItr)
+            {
+                if (attempts[attemptItr].m_pTrick == pTrick)
+                {
+                    bFound = true;
+                    break;
+                }
+            }
+
+            if (!bFound)
+            {
+                TrickBenchAttempt_t attempt = {pTrick, 0};
+                attempts.AddToTail(attempt);
+            }
+        }
+    }
+
+    return iCompleted;
+}
+
+// The indexed matching that CTrickSystem uses
+static int TrickBenchIndexed(const CTrickStartIndex &index, const CUtlVector<int> &vecZoneWalk)
+{
+    CUtlVector<CTrickAttempt*> attempts;
+    int iCompleted = 0;
+
+    FOR_EACH_VEC(vecZoneWalk, walkItr)
+    {
+        const auto iZoneID = vecZoneWalk[walkItr];
+
+        FOR_EACH_VEC_BACK(attempts, i)
+        {
+            const auto result = attempts[i]->Advance(iZoneID, nullptr);
+            if (result != TRICK_ADVANCE_CONTINUE)
+            {
+                iCompleted += result == TRICK_ADVANCE_COMPLETE;
+                delete attempts[i];
+                attempts.Remove(i);
+            }
+        }
+
+        const auto pStartingTricks = index.GetTricksStartingIn(iZoneID);
+        if (pStartingTricks)
+        {
+            FOR_EACH_VEC(*pStartingTricks, i)
+            {
+                const auto pTrick = pStartingTricks->Element(i);
+                if (!pTrick->GetAttempt())
+                    attempts.AddToTail(new CTrickAttempt(pTrick));
+            }
+        }
+    }
+
+    attempts.PurgeAndDeleteElements();
+    return iCompleted;
+}
+
+CON_COMMAND(mom_tricks_benchmark, "Benchmarks trick matching on a synthetic trick map, comparing the zone index against checking every trick.\n"
+                                  "Usage: mom_tricks_benchmark [tricks = 10000] [zones = 500] [zone touches = 100000] [seed = 1]")
+{
+    const auto iTrickCount = args.ArgC() > 1 ? Q_atoi(args.Arg(1)) : 10000;
+    const auto iZoneCount = args.ArgC() > 2 ? Q_atoi(args.Arg(2)) : 500;
+    const auto iTouchCount = args.ArgC() > 3 ? Q_atoi(args.Arg(3)) : 100000;
+    const auto iSeed = args.ArgC() > 4 ? Q_atoi(args.Arg(4)) : 1;
+
+    if (iTrickCount <= 0 || iZoneCount <= 1 || iTouchCount <= 0)
+    {
+        Warning("Usage: \"mom_tricks_benchmark [tricks] [zones] [zone touches] [seed]\"\n");
+        return;
+    }
+
+    CUniformRandomStream random;
+    random.SetSeed(iSeed);
+
+    // Tricks of 2 to 8 steps through random zones, about a third of the middle steps being optional
+    CUtlVector<CTrick*> tricks;
+    CTrickStartIndex index;
+    for (int i = 0; i < iTrickCount; i++)
+    {
+        const auto pTrick = new CTrick;
+        pTrick->SetID(i);
+
+        const auto iStepCount = random.RandomInt(2, 8);
+        int iLastZone = -1;
+        for (int step = 0; step < iStepCount; step++)
+        {
+            int iZone;
+            do
+            {
+                iZone = random.RandomInt(0, iZoneCount - 1);
+            } while (iZone == iLastZone);
+            iLastZone = iZone;
+
+            const auto pStep = new CTrickStep;
+            pStep->SetTriggerID(iZone);
+            pStep->SetOptional(step > 0 && step < iStepCount - 1 && random.RandomInt(0, 2) == 0);
+            pTrick->AddStep(pStep);
+        }
+
+        tricks.AddToTail(pTrick);
+        index.AddTrick(pTrick);
+    }
+
+    // Mostly run through tricks, sometimes skipping their optional steps, with stray zone touches in between
+    CUtlVector<int> vecZoneWalk;
+    vecZoneWalk.EnsureCapacity(iTouchCount);
+    while (vecZoneWalk.Count() < iTouchCount)
+    {
+        if (random.RandomInt(0, 3) == 0)
+        {
+            vecZoneWalk.AddToTail(random.RandomInt(0, iZoneCount - 1));
+            continue;
+        }
+
+        const auto pTrick = tricks[random.RandomInt(0, iTrickCount - 1)];
+        for (int step = 0; step < pTrick->StepCount() && vecZoneWalk.Count() < iTouchCount; step++)
+        {
+            const auto pStep = pTrick->Step(step);
+            if (!pStep->IsOptional() || random.RandomInt(0, 1))
+                vecZoneWalk.AddToTail(pStep->GetTriggerID());
+        }
+    }
+
+    Msg("Matching %i zone touches against %i tricks over %i zones...\n", iTouchCount, iTrickCount, iZoneCount);
+
+    auto flStart = Plat_FloatTime();
+    const auto iIndexedCompleted = TrickBenchIndexed(index, vecZoneWalk);
+    const auto flIndexedTime = Plat_FloatTime() - flStart;
+
+    flStart = Plat_FloatTime();
+    const auto iLinearCompleted = TrickBenchLinear(tricks, vecZoneWalk);
+    const auto flLinearTime = Plat_FloatTime() - flStart;
+
+    Msg("Indexed: %.2f ms (%.3f us per touch), %i tricks completed\n", flIndexedTime * 1000.0, flIndexedTime * 1000000.0 / iTouchCount, iIndexedCompleted);
+    Msg("Linear:  %.2f ms (%.3f us per touch), %i tricks completed\n", flLinearTime * 1000.0, flLinearTime * 1000000.0 / iTouchCount, iLinearCompleted);
+
+    if (iIndexedCompleted != iLinearCompleted)
+        Warning("Trick matching mismatch between the zone index and the linear search!\n");
+
+    tricks.PurgeAndDeleteElements();
+}
+#endif
+
 static CTrickSystem s_TricksurfSystem;
 CTrickSystem *g_pTrickSystem = &s_TricksurfSystem;
\ No newline at end of file
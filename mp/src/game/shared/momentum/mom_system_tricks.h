@@ -11,6 +11,8 @@
 
 class CMomentumPlayer;
 class CTriggerTrickZone;
+class CTrickAttempt;
+class CUtlBuffer;
 struct SavedLocation_t;
 
 enum TrickTrackingDrawState_t
@@ -49,6 +51,8 @@ public:
     virtual bool PlayerPassesConstraint(CMomentumPlayer *pPlayer) = 0;
     virtual void SaveToKeyValues(KeyValues *pKvOut) = 0;
     virtual void LoadFromKeyValues(KeyValues *pKvIn) = 0;
+    virtual void SaveToBuffer(CUtlBuffer &buf) = 0;
+    virtual void LoadFromBuffer(CUtlBuffer &buf) = 0;
     virtual TrickConstraintType_t GetType() = 0;
     virtual ~ITrickStepConstraint() {}
 };
@@ -63,6 +67,8 @@ public:
 
     void LoadFromKeyValues(KeyValues* pKvIn) override;
     void SaveToKeyValues(KeyValues* pKvOut) override;
+    void SaveToBuffer(CUtlBuffer &buf) override;
+    void LoadFromBuffer(CUtlBuffer &buf) override;
 
 private:
     float m_flMaxSpeed;
@@ -78,6 +84,7 @@ public:
     void AddConstraint(ITrickStepConstraint *pConstraint) { m_vecConstraints.AddToTail(pConstraint); }
 
     void SetTriggerID(int iTriggerID) { m_iTrickZoneID = iTriggerID; }
+    int GetTriggerID() const { return m_iTrickZoneID; }
     CTriggerTrickZone *GetTrigger();
 
     void SetOptional(bool bOptional) { m_bOptional = bOptional; }
@@ -86,6 +93,9 @@ public:
     void SaveToKV(KeyValues *pKvOut);
     void LoadFromKV(KeyValues *pKvIn);
 
+    void SaveToBuffer(CUtlBuffer &buf);
+    bool LoadFromBuffer(CUtlBuffer &buf);
+
 private:
     bool m_bOptional;
     int m_iTrickZoneID;
@@ -111,12 +121,23 @@ struct CTrickInfo
 
     void SaveToKV(KeyValues *pKvOut);
     void LoadFromKV(KeyValues *pKvIn);
+
+    void SaveToBuffer(CUtlBuffer &buf);
+    void LoadFromBuffer(CUtlBuffer &buf);
+};
+
+// Entering the zone advances a trick attempt to the step
+struct TrickStepEdge_t
+{
+    int m_iZoneID;
+    int m_iStep;
 };
 
 class CTrick
 {
 public:
     CTrick();
+    ~CTrick();
 
     void SetID(int iID) { m_iID = iID; }
     int GetID() const { return m_iID; }
@@ -135,19 +156,62 @@ public:
     void SaveToKV(KeyValues *pKvOut);
     bool LoadFromKV(KeyValues *pKvIn);
 
+    void SaveToBuffer(CUtlBuffer &buf);
+    bool LoadFromBuffer(CUtlBuffer &buf);
+
+    // Compiles the steps into per-step zone transitions, skipping over optional steps. Must be redone if the steps change.
+    void BuildStepEdges();
+    // Returns the step that entering the zone advances to from the current step, or -1 if the trick would be broken
+    int FindNextStep(int iCurrentStep, int iZoneID) const;
+
+    // The attempt currently running for this trick, if any
+    CTrickAttempt *GetAttempt() const { return m_pAttempt; }
+    void SetAttempt(CTrickAttempt *pAttempt) { m_pAttempt = pAttempt; }
+
 private:
     int m_iID; // Website
     CTrickInfo m_Info;
 
     CUtlVector<CTrickStep*> m_vecSteps;
+
+    // The edges out of step i are m_vecStepEdges[m_vecStepEdgesStart[i]] up to m_vecStepEdges[m_vecStepEdgesStart[i + 1]]
+    CUtlVector<TrickStepEdge_t> m_vecStepEdges;
+    CUtlVector<int> m_vecStepEdgesStart;
+
+    CTrickAttempt *m_pAttempt;
+};
+
+// Looks up tricks by the zone ID of their first step, so starting attempts doesn't have to go through every trick
+class CTrickStartIndex
+{
+public:
+    // Also builds the trick's step edges
+    void AddTrick(CTrick *pTrick);
+    void Purge() { m_vecTricksByZone.Purge(); }
+
+    // Tricks starting in the zone, or nullptr if there are none
+    const CUtlVector<CTrick*> *GetTricksStartingIn(int iZoneID) const;
+
+private:
+    CUtlVector<CUtlVector<CTrick*>> m_vecTricksByZone;
+};
+
+enum TrickAdvanceResult_t
+{
+    TRICK_ADVANCE_FAIL = 0,
+    TRICK_ADVANCE_CONTINUE,
+    TRICK_ADVANCE_COMPLETE,
 };
 
 class CTrickAttempt
 {
 public:
     CTrickAttempt(CTrick *pTrick);
+    ~CTrickAttempt();
 
 #ifdef GAME_DLL
+    // Advances the attempt by entering the zone. A null player passes every constraint.
+    TrickAdvanceResult_t Advance(int iZoneID, CMomentumPlayer *pPlayer);
     bool ShouldContinue(CTriggerTrickZone *pZone, CMomentumPlayer *pPlayer);
     void Complete(CMomentumPlayer *pPlayer);
 #endif
@@ -175,6 +239,9 @@ struct CMapTeleport
     CMapTeleport();
     void SaveToKV(KeyValues *pKvOut);
     void LoadFromKV(KeyValues *pKvIn);
+
+    void SaveToBuffer(CUtlBuffer &buf);
+    void LoadFromBuffer(CUtlBuffer &buf);
 };
 
 class CTrickSystem : public CAutoGameSystem
@@ -186,9 +253,12 @@ public:
 
     void LoadTrickDataFromFile(KeyValues *pKvTrickData);
     void LoadTrickDataFromSite(KeyValues *pKvTrickData);
+    // Loads the binary trick cache if it was built from the trick file with the given hash
+    bool LoadTrickDataFromCache(const char *pSourceHash);
 
     CTriggerTrickZone *GetTrickZone(int id);
     void AddZone(CTriggerTrickZone *pZone);
+    void RemoveZone(CTriggerTrickZone *pZone);
 
     int GetTrickCount() const { return m_llTrickList.Count(); }
     CTrick *GetTrick(int index) { return m_llTrickList[index]; }
@@ -225,6 +295,7 @@ public:
     void PostPlayerManualTeleport(CMomentumPlayer *pPlayer);
 
     void SaveTrickDataToFile();
+    bool IsTrickDataDirty() const { return m_bTrickDataDirty; }
 
     void CreateMapTeleport(const char *pName);
     void GoToMapTeleport(int iTeleportNum);
@@ -237,15 +308,24 @@ private:
     CUtlVector<CTriggerTrickZone *> m_vecRecordedZones;
 
 #ifdef GAME_DLL
+    void WriteTrickDataCache(const char *pSourceHash, KeyValues *pZonesKV);
+    // Patches the trick or map teleport into the trick cache without rewriting it, returns false if there is no cache yet
+    bool AppendToTrickDataCache(CTrick *pTrick, CMapTeleport *pMapTele);
+    bool SpawnTrickZone(KeyValues *pZoneKV);
+
     int m_iTrackedTrick;
     bool m_bRecording;
+    bool m_bTrickDataDirty; // Changed since the trick file was last written
+    bool m_bTrickCacheStale; // Changed in a way that can't be appended to the trick cache
     CUtlVector<CTrickAttempt*> m_vecCurrentTrickAttempts;
 #else
     void InitializeTrickData(KeyValues *pKvTrickData);
+    void SendTrickDataToServer(KeyValues *pKvTrickData);
 #endif
 
     // Every trick loaded for the map
     CUtlLinkedList<CTrick*> m_llTrickList;
+    CTrickStartIndex m_TrickStartIndex;
     // Keeping track. ID is their index into the array.
     CUtlVector<CTriggerTrickZone*> m_vecTrickZones;
     CUtlVector<CMapTeleport*> m_vecMapTeleports;
@@ -0,0 +1,389 @@
+#include "cbase.h"
+#include "mom_replay_analysis.h"
+#include "filesystem.h"
+#include "fmtstr.h"
+#include "in_buttons.h"
+#include "mom_replay_base.h"
+#include "mom_replay_factory.h"
+#include "mom_shareddefs.h"
+#include "run_stats.h"
+
+#include "tier0/memdbgon.h"
+
+// For replays without the recorded ground state: vertical speed under which a frame counts as being on the ground
+#define ANALYSIS_GROUND_SPEED_Z 0.01f
+// For replays without the recorded ground state: vertical speed a jump has to leave the player with, and add
+// in that one tick (jumping at normal gravity gives ~290, bunnyhops land from a fall on the tick before)
+#define ANALYSIS_JUMP_SPEED_Z 100.0f
+
+enum ReplayAnalysisFrameFlags_t
+{
+    ANALYSIS_FRAME_AIR = 1 << 0,
+    ANALYSIS_FRAME_STRAFE_TICK = 1 << 1,   // Turning in the air
+    ANALYSIS_FRAME_PERFECT_SYNC = 1 << 2,  // Turning while only holding the key of that direction
+    ANALYSIS_FRAME_ACCEL = 1 << 3,         // Turning and gaining speed
+    ANALYSIS_FRAME_JUMP = 1 << 4,
+    ANALYSIS_FRAME_STRAFE = 1 << 5,        // Started pressing a strafe key
+};
+
+ReplayAnalysisStats_t::ReplayAnalysisStats_t()
+    : m_iStartFrame(0), m_iFrames(0), m_iJumps(0), m_iStrafes(0), m_iStrafeTicks(0), m_iPerfectSyncTicks(0),
+      m_iAccelTicks(0), m_flVelocityMax2D(0.0f), m_flVelocityAvg2D(0.0f), m_flVelocityMax3D(0.0f), m_flVelocityAvg3D(0.0f)
+{
+}
+
+void ReplayAnalysisStats_t::Serialize(CUtlBuffer &writer) const
+{
+    writer.PutInt(m_iStartFrame);
+    writer.PutInt(m_iFrames);
+    writer.PutInt(m_iJumps);
+    writer.PutInt(m_iStrafes);
+    writer.PutInt(m_iStrafeTicks);
+    writer.PutInt(m_iPerfectSyncTicks);
+    writer.PutInt(m_iAccelTicks);
+    writer.PutFloat(m_flVelocityMax2D);
+    writer.PutFloat(m_flVelocityAvg2D);
+    writer.PutFloat(m_flVelocityMax3D);
+    writer.PutFloat(m_flVelocityAvg3D);
+}
+
+void ReplayAnalysisStats_t::Deserialize(CUtlBuffer &reader)
+{
+    m_iStartFrame = reader.GetInt();
+    m_iFrames = reader.GetInt();
+    m_iJumps = reader.GetInt();
+    m_iStrafes = reader.GetInt();
+    m_iStrafeTicks = reader.GetInt();
+    m_iPerfectSyncTicks = reader.GetInt();
+    m_iAccelTicks = reader.GetInt();
+    m_flVelocityMax2D = reader.GetFloat();
+    m_flVelocityAvg2D = reader.GetFloat();
+    m_flVelocityMax3D = reader.GetFloat();
+    m_flVelocityAvg3D = reader.GetFloat();
+}
+
+// The per frame data every range of the run is summed up from
+struct ReplayAnalysisFrames_t
+{
+    int Count() const { return m_vecFlags.Count(); }
+
+    CUtlVector<float> m_vecSpeed2D;
+    CUtlVector<float> m_vecSpeed3D;
+    CUtlVector<uint8> m_vecFlags;
+};
+
+static void AccumulateRange(const ReplayAnalysisFrames_t &frames, ReplayAnalysisStats_t &stats, int iStart, int iEnd)
+{
+    iStart = clamp(iStart, 0, frames.Count());
+    iEnd = clamp(iEnd, iStart, frames.Count());
+
+    stats.m_iStartFrame = iStart;
+    stats.m_iFrames = iEnd - iStart;
+    if (!stats.m_iFrames)
+        return;
+
+    const uint8 *pFlags = frames.m_vecFlags.Base();
+    int iJumps = 0, iStrafes = 0, iStrafeTicks = 0, iPerfectSyncTicks = 0, iAccelTicks = 0;
+    for (int i = iStart; i < iEnd; i++)
+    {
+        const uint8 flags = pFlags[i];
+        iJumps += (flags & ANALYSIS_FRAME_JUMP) != 0;
+        iStrafes += (flags & ANALYSIS_FRAME_STRAFE) != 0;
+        iStrafeTicks += (flags & ANALYSIS_FRAME_STRAFE_TICK) != 0;
+        iPerfectSyncTicks += (flags & ANALYSIS_FRAME_PERFECT_SYNC) != 0;
+        iAccelTicks += (flags & ANALYSIS_FRAME_ACCEL) != 0;
+    }
+
+    const float *pSpeed2D = frames.m_vecSpeed2D.Base();
+    const float *pSpeed3D = frames.m_vecSpeed3D.Base();
+    float flMax2D = 0.0f, flMax3D = 0.0f, flSum2D = 0.0f, flSum3D = 0.0f;
+    for (int i = iStart; i < iEnd; i++)
+    {
+        flMax2D = MAX(flMax2D, pSpeed2D[i]);
+        flMax3D = MAX(flMax3D, pSpeed3D[i]);
+        flSum2D += pSpeed2D[i];
+        flSum3D += pSpeed3D[i];
+    }
+
+    stats.m_iJumps = iJumps;
+    stats.m_iStrafes = iStrafes;
+    stats.m_iStrafeTicks = iStrafeTicks;
+    stats.m_iPerfectSyncTicks = iPerfectSyncTicks;
+    stats.m_iAccelTicks = iAccelTicks;
+    stats.m_flVelocityMax2D = flMax2D;
+    stats.m_flVelocityMax3D = flMax3D;
+    stats.m_flVelocityAvg2D = flSum2D / stats.m_iFrames;
+    stats.m_flVelocityAvg3D = flSum3D / stats.m_iFrames;
+}
+
+CMomReplayAnalysis::CMomReplayAnalysis()
+{
+}
+
+bool CMomReplayAnalysis::Analyze(CMomReplayBase *pReplay)
+{
+    m_vecZones.Purge();
+    m_vecSegments.Purge();
+    m_vecVelocityCurve.Purge();
+    m_Overall = ReplayAnalysisStats_t();
+
+    const CReplayFrameStore &store = pReplay->GetFrameStore();
+    const int iStartTick = pReplay->GetStartTick();
+    const int iStopTick = MIN(static_cast<int>(pReplay->GetStopTick()), store.Count() - 1);
+    const float flTickInterval = pReplay->GetTickInterval();
+    if (iStopTick <= iStartTick || flTickInterval <= 0.0f)
+        return false;
+
+    // One frame before the timer starts for the first turn and key press, one after it stops for the last velocity
+    const int iFirstFrame = MAX(iStartTick - 1, 0);
+    CReplayFrameColumns columns;
+    columns.Load(store, iFirstFrame, iStopTick + 1 - iFirstFrame);
+    const Vector *pOrigins = columns.Origins();
+    const QAngle *pAngles = columns.EyeAngles();
+    const int *pButtons = columns.Buttons();
+    const int iOffset = iStartTick - iFirstFrame; // Column index of the first timed frame
+
+    const int iFrames = iStopTick - iStartTick;
+    ReplayAnalysisFrames_t frames;
+    frames.m_vecSpeed2D.SetCount(iFrames);
+    frames.m_vecSpeed3D.SetCount(iFrames);
+    frames.m_vecFlags.SetCount(iFrames);
+
+    // Velocity leaving every frame, the frame before a teleport keeps the one of the frame before it
+    CUtlVector<Vector> vecVelocity;
+    vecVelocity.SetCount(iFrames + iOffset);
+    const float flInvInterval = 1.0f / flTickInterval;
+    for (int i = 0; i < iFrames + iOffset; i++)
+    {
+        if (pButtons[i + 1] & IN_REPLAY_TELEPORTED)
+            vecVelocity[i] = i ? vecVelocity[i - 1] : vec3_origin;
+        else
+            vecVelocity[i] = (pOrigins[i + 1] - pOrigins[i]) * flInvInterval;
+    }
+
+    for (int i = 0; i < iFrames; i++)
+    {
+        const Vector &velocity = vecVelocity[i + iOffset];
+        frames.m_vecSpeed2D[i] = velocity.Length2D();
+        frames.m_vecSpeed3D[i] = velocity.Length();
+    }
+
+    // Newer replays record whether every frame ended on the ground, only a run that never touches it has none set
+    bool bRecordedGround = false;
+    for (int i = 0; i < iFrames + iOffset && !bRecordedGround; i++)
+        bRecordedGround = (pButtons[i] & IN_REPLAY_ONGROUND) != 0;
+
+    for (int i = 0; i < iFrames; i++)
+    {
+        const int c = i + iOffset;
+        const int iButtons = pButtons[c];
+        const int iPrevButtons = c ? pButtons[c - 1] : 0;
+
+        uint8 flags = 0;
+        bool bAir, bJumped;
+        if (bRecordedGround)
+        {
+            // Jumping takes off from where the tick before landed, bunnyhops included
+            bAir = !(iButtons & IN_REPLAY_ONGROUND);
+            bJumped = bAir && (iPrevButtons & IN_REPLAY_ONGROUND);
+        }
+        else
+        {
+            // Older replays only have the movement to go by, which takes ramps and slopes for air
+            const float flVelZ = vecVelocity[c].z;
+            const float flPrevVelZ = c ? vecVelocity[c - 1].z : 0.0f;
+            bAir = fabsf(flVelZ) > ANALYSIS_GROUND_SPEED_Z;
+            bJumped = flVelZ >= ANALYSIS_JUMP_SPEED_Z && flVelZ - flPrevVelZ >= ANALYSIS_JUMP_SPEED_Z;
+        }
+
+        if (bAir)
+            flags |= ANALYSIS_FRAME_AIR;
+
+        if ((iButtons & IN_JUMP) && bJumped)
+            flags |= ANALYSIS_FRAME_JUMP;
+
+        if (((iButtons & IN_MOVELEFT) && !(iPrevButtons & IN_MOVELEFT)) ||
+            ((iButtons & IN_MOVERIGHT) && !(iPrevButtons & IN_MOVERIGHT)))
+            flags |= ANALYSIS_FRAME_STRAFE;
+
+        // Same as the player's strafe sync, with gaining speed standing in for the side move direction
+        const float flTurn = c ? AngleDiff(pAngles[c].y, pAngles[c - 1].y) : 0.0f;
+        if (bAir && flTurn != 0.0f)
+        {
+            flags |= ANALYSIS_FRAME_STRAFE_TICK;
+
+            const int iTurnKey = flTurn > 0.0f ? IN_MOVELEFT : IN_MOVERIGHT;
+            if ((iButtons & (IN_MOVELEFT | IN_MOVERIGHT)) == iTurnKey)
+                flags |= ANALYSIS_FRAME_PERFECT_SYNC;
+
+            if (c && vecVelocity[c].Length2DSqr() > vecVelocity[c - 1].Length2DSqr())
+                flags |= ANALYSIS_FRAME_ACCEL;
+        }
+
+        frames.m_vecFlags[i] = flags;
+    }
+
+    AccumulateRange(frames, m_Overall, 0, iFrames);
+
+    // Zones are entered in order, at the ticks the run stats recorded
+    const auto pRunStats = pReplay->GetRunStats();
+    const int iZones = pRunStats ? pRunStats->GetTotalZones() : 0;
+    for (int zone = 1; zone <= iZones; zone++)
+    {
+        const int iZoneStart = zone == 1 ? 0 : static_cast<int>(pRunStats->GetZoneEnterTick(zone));
+        const int iZoneEnd = zone == iZones ? iFrames : static_cast<int>(pRunStats->GetZoneEnterTick(zone + 1));
+        AccumulateRange(frames, m_vecZones[m_vecZones.AddToTail()], iZoneStart, iZoneEnd);
+    }
+
+    const int iSegmentFrames = MAX(1, RoundFloatToInt(REPLAY_ANALYSIS_SEGMENT_SECONDS / flTickInterval));
+    for (int i = 0; i < iFrames; i += iSegmentFrames)
+        AccumulateRange(frames, m_vecSegments[m_vecSegments.AddToTail()], i, i + iSegmentFrames);
+
+    const float flCurveStep = 1.0f / (REPLAY_ANALYSIS_CURVE_RATE * flTickInterval);
+    for (float f = 0.0f; f < iFrames; f += flCurveStep)
+        m_vecVelocityCurve.AddToTail(frames.m_vecSpeed2D[static_cast<int>(f)]);
+
+    return true;
+}
+
+void CMomReplayAnalysis::Serialize(CUtlBuffer &writer) const
+{
+    m_Overall.Serialize(writer);
+
+    writer.PutInt(m_vecZones.Count());
+    FOR_EACH_VEC(m_vecZones, i)
+        m_vecZones[i].Serialize(writer);
+
+    writer.PutInt(m_vecSegments.Count());
+    FOR_EACH_VEC(m_vecSegments, i)
+        m_vecSegments[i].Serialize(writer);
+
+    writer.PutInt(m_vecVelocityCurve.Count());
+    FOR_EACH_VEC(m_vecVelocityCurve, i)
+        writer.PutFloat(m_vecVelocityCurve[i]);
+}
+
+bool CMomReplayAnalysis::Deserialize(CUtlBuffer &reader)
+{
+    m_Overall.Deserialize(reader);
+
+    const int iZones = reader.GetInt();
+    if (!reader.IsValid() || iZones < 0 || iZones > MAX_ZONES)
+        return false;
+    m_vecZones.SetCount(iZones);
+    FOR_EACH_VEC(m_vecZones, i)
+        m_vecZones[i].Deserialize(reader);
+
+    const int iSegments = reader.GetInt();
+    if (!reader.IsValid() || iSegments < 0 || iSegments > reader.GetBytesRemaining() / int(sizeof(ReplayAnalysisStats_t)))
+        return false;
+    m_vecSegments.SetCount(iSegments);
+    FOR_EACH_VEC(m_vecSegments, i)
+        m_vecSegments[i].Deserialize(reader);
+
+    const int iSamples = reader.GetInt();
+    if (!reader.IsValid() || iSamples < 0 || iSamples > reader.GetBytesRemaining() / int(sizeof(float)))
+        return false;
+    m_vecVelocityCurve.SetCount(iSamples);
+    FOR_EACH_VEC(m_vecVelocityCurve, i)
+        m_vecVelocityCurve[i] = reader.GetFloat();
+
+    return reader.IsValid();
+}
+
+CMomReplayAnalysis *CMomReplayAnalysis::LoadOrAnalyze(const char *pReplayPath, const char *pPathID)
+{
+    if (!filesystem->FileExists(pReplayPath, pPathID))
+        return nullptr;
+
+    char analysisPath[MAX_PATH];
+    Q_strncpy(analysisPath, pReplayPath, MAX_PATH);
+    V_SetExtension(analysisPath, EXT_RECORDING_ANALYSIS_FILE, MAX_PATH);
+
+    // Like the replay index, the analysis is tied to the replay file's size and modification time
+    const uint32 uFileSize = filesystem->Size(pReplayPath, pPathID);
+    const long lFileTime = filesystem->GetFileTime(pReplayPath, pPathID);
+
+    CUtlBuffer reader;
+    if (filesystem->ReadFile(analysisPath, pPathID, reader))
+    {
+        if (reader.GetUnsignedInt() == REPLAY_ANALYSIS_MAGIC && reader.GetUnsignedChar() == REPLAY_ANALYSIS_VERSION &&
+            reader.GetUnsignedInt() == uFileSize && static_cast<long>(reader.GetInt64()) == lFileTime)
+        {
+            const auto pAnalysis = new CMomReplayAnalysis;
+            if (pAnalysis->Deserialize(reader))
+                return pAnalysis;
+
+            delete pAnalysis;
+            Warning("Replay analysis %s is corrupt, analyzing the replay again...\n", analysisPath);
+        }
+    }
+
+    CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(pReplayPath, true, pPathID);
+    if (!pReplay)
+        return nullptr;
+
+    const auto pAnalysis = new CMomReplayAnalysis;
+    const bool bAnalyzed = pAnalysis->Analyze(pReplay);
+    delete pReplay;
+
+    if (!bAnalyzed)
+    {
+        Warning("Replay %s has no timed frames to analyze!\n", pReplayPath);
+        delete pAnalysis;
+        return nullptr;
+    }
+
+    CUtlBuffer writer;
+    writer.PutUnsignedInt(REPLAY_ANALYSIS_MAGIC);
+    writer.PutUnsignedChar(REPLAY_ANALYSIS_VERSION);
+    writer.PutUnsignedInt(uFileSize);
+    writer.PutInt64(lFileTime);
+    pAnalysis->Serialize(writer);
+
+    if (!filesystem->WriteFile(analysisPath, pPathID, writer))
+        Warning("Failed to write replay analysis %s!\n", analysisPath);
+
+    return pAnalysis;
+}
+
+#ifdef CLIENT_DLL
+CON_COMMAND(mom_replay_analyze, "Prints the per zone and per segment stats of a replay, analyzing it if needed.\n"
+                                "Usage: mom_replay_analyze <replay>")
+{
+    if (args.ArgC() < 2)
+    {
+        Msg("Usage: mom_replay_analyze <replay>\n");
+        return;
+    }
+
+    char filename[MAX_PATH], replayPath[MAX_PATH];
+    Q_strncpy(filename, args.Arg(1), MAX_PATH);
+    V_SetExtension(filename, EXT_RECORDING_FILE, MAX_PATH);
+    V_ComposeFileName(RECORDING_PATH, filename, replayPath, MAX_PATH);
+
+    const double flStart = Plat_FloatTime();
+    CMomReplayAnalysis *pAnalysis = CMomReplayAnalysis::LoadOrAnalyze(replayPath);
+    if (!pAnalysis)
+    {
+        Warning("Could not analyze replay %s!\n", replayPath);
+        return;
+    }
+
+    const auto PrintStats = [](const char *pName, const ReplayAnalysisStats_t &stats)
+    {
+        Msg("%-12s %8i %6i %7i %7.2f %7.2f %9.2f %9.2f\n", pName, stats.m_iFrames, stats.m_iJumps, stats.m_iStrafes,
+            stats.GetStrafeSync(), stats.GetStrafeSync2(), stats.m_flVelocityAvg2D, stats.m_flVelocityMax2D);
+    };
+
+    Msg("Analysis of %s (%.2f ms):\n", replayPath, (Plat_FloatTime() - flStart) * 1000.0);
+    Msg("%-12s %8s %6s %7s %7s %7s %9s %9s\n", "range", "frames", "jumps", "strafes", "sync", "sync2", "avg vel", "max vel");
+    PrintStats("overall", pAnalysis->GetOverallStats());
+    for (int i = 0; i < pAnalysis->GetZoneCount(); i++)
+        PrintStats(CFmtStr("zone %i", i + 1), pAnalysis->GetZoneStats(i));
+    for (int i = 0; i < pAnalysis->GetSegmentCount(); i++)
+        PrintStats(CFmtStr("%.0fs-%.0fs", i * REPLAY_ANALYSIS_SEGMENT_SECONDS, (i + 1) * REPLAY_ANALYSIS_SEGMENT_SECONDS), pAnalysis->GetSegmentStats(i));
+
+    delete pAnalysis;
+}
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+class CMomReplayBase;
+
+#define REPLAY_ANALYSIS_MAGIC 0x41524D4D // "MMRA"
+#define REPLAY_ANALYSIS_VERSION 2
+
+// Length of the fixed time slices the run is split into, next to the zones
+#define REPLAY_ANALYSIS_SEGMENT_SECONDS 5.0f
+// Samples per second of the velocity curve
+#define REPLAY_ANALYSIS_CURVE_RATE 10
+
+// Stats of a range of frames of a run
+struct ReplayAnalysisStats_t
+{
+    ReplayAnalysisStats_t();
+
+    float GetStrafeSync() const { return m_iStrafeTicks ? 100.0f * float(m_iPerfectSyncTicks) / float(m_iStrafeTicks) : 0.0f; }
+    float GetStrafeSync2() const { return m_iStrafeTicks ? 100.0f * float(m_iAccelTicks) / float(m_iStrafeTicks) : 0.0f; }
+
+    void Serialize(CUtlBuffer &writer) const;
+    void Deserialize(CUtlBuffer &reader);
+
+    int m_iStartFrame; // Relative to the start of the timer
+    int m_iFrames;
+
+    int m_iJumps;
+    int m_iStrafes;
+    int m_iStrafeTicks;
+    int m_iPerfectSyncTicks;
+    int m_iAccelTicks;
+
+    float m_flVelocityMax2D;
+    float m_flVelocityAvg2D;
+    float m_flVelocityMax3D;
+    float m_flVelocityAvg3D;
+};
+
+// Deep stats of a whole run, computed from the replay frames in one go instead of during playback.
+// Air time is told apart from ground time by the ground state recorded in the frames, so no map is needed for it.
+// Replays recorded before that fall back to the vertical movement of the frames.
+class CMomReplayAnalysis
+{
+  public:
+    CMomReplayAnalysis();
+
+    // Analyzes the timed part of a fully loaded replay
+    bool Analyze(CMomReplayBase *pReplay);
+
+    const ReplayAnalysisStats_t &GetOverallStats() const { return m_Overall; }
+    // Zone stats are indexed from 0 for zone 1
+    int GetZoneCount() const { return m_vecZones.Count(); }
+    const ReplayAnalysisStats_t &GetZoneStats(int i) const { return m_vecZones[i]; }
+    int GetSegmentCount() const { return m_vecSegments.Count(); }
+    const ReplayAnalysisStats_t &GetSegmentStats(int i) const { return m_vecSegments[i]; }
+    // Horizontal speed, REPLAY_ANALYSIS_CURVE_RATE samples per second
+    const CUtlVector<float> &GetVelocityCurve() const { return m_vecVelocityCurve; }
+
+    void Serialize(CUtlBuffer &writer) const;
+    bool Deserialize(CUtlBuffer &reader);
+
+    // Gets the analysis of a replay file from the analysis file next to it (<replay>.mra),
+    // analyzing the replay and writing that file if it is missing or out of date.
+    //!!! NOTE: The value returned here MUST BE DELETED, otherwise you get a memory leak!
+    static CMomReplayAnalysis *LoadOrAnalyze(const char *pReplayPath, const char *pPathID = "MOD");
+
+  private:
+    ReplayAnalysisStats_t m_Overall;
+    CUtlVector<ReplayAnalysisStats_t> m_vecZones;
+    CUtlVector<ReplayAnalysisStats_t> m_vecSegments;
+    CUtlVector<float> m_vecVelocityCurve;
+};
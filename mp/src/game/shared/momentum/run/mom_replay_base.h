@@ -2,6 +2,7 @@
 
 #include <momentum/util/serialization.h>
 #include "mom_replay_data.h"
+#include "mom_replay_frame_store.h"
 #include "run/run_stats.h"
 
 class CMomentumReplayGhostEntity;
@@ -12,6 +13,8 @@ class CMomReplayBase : public ISerializable
     CMomReplayBase(CReplayHeader header, bool bFull) : m_rhHeader(header), m_pEntity(nullptr)
     {
         m_pszRunHash[0] = '\0';
+        m_szHashFilePath[0] = '\0';
+        m_szHashPathID[0] = '\0';
     }
 
   public:
@@ -32,7 +35,9 @@ class CMomReplayBase : public ISerializable
     virtual uint8 GetTrackNumber() { return m_rhHeader.m_iTrackNumber; }
     virtual uint8 GetZoneNumber() { return m_rhHeader.m_iZoneNumber; }
     virtual CMomentumReplayGhostEntity *GetRunEntity() { return m_pEntity; }
-    virtual const char *GetRunHash() { return m_pszRunHash; }
+    // Computes the hash from the replay file the first time it's asked for, if the replay was only partially loaded
+    virtual const char *GetRunHash();
+    virtual const CReplayHeader &GetHeader() { return m_rhHeader; }
 
   public:
     virtual void SetMapName(const char *name) { Q_strncpy(m_rhHeader.m_szMapName, name, sizeof(m_rhHeader.m_szMapName)); }
@@ -48,12 +53,21 @@ class CMomReplayBase : public ISerializable
     virtual void SetZoneNumber(uint8 zone) { m_rhHeader.m_iZoneNumber = zone; }
     virtual void SetRunEntity(CMomentumReplayGhostEntity *pEnt) { m_pEntity = pEnt; }
     virtual void SetRunHash(const char *pHash) { Q_strncpy(m_pszRunHash, pHash, sizeof(m_pszRunHash)); }
+    // Sets the file GetRunHash() hashes lazily, for replays that weren't fully read
+    virtual void SetRunHashSource(const char *pFilePath, const char *pPathID)
+    {
+        Q_strncpy(m_szHashFilePath, pFilePath, sizeof(m_szHashFilePath));
+        Q_strncpy(m_szHashPathID, pPathID, sizeof(m_szHashPathID));
+    }
+    virtual void SetHeader(const CReplayHeader &header) { m_rhHeader = header; }
 
   public:
     virtual uint8 GetVersion() = 0;
     virtual CMomRunStats *GetRunStats() = 0;
     virtual int32 GetFrameCount() = 0;
     virtual CReplayFrame *GetFrame(int32 index) = 0;
+    // Direct access to the frames, for playback loops that shouldn't go through GetFrame for every frame
+    virtual const CReplayFrameStore &GetFrameStore() = 0;
     virtual void AddFrame(const CReplayFrame &frame) = 0;
     virtual bool SetFrame(int32 index, const CReplayFrame &frame) = 0;
     virtual CMomRunStats *CreateRunStats(uint8 zones) = 0;
@@ -63,4 +77,6 @@ class CMomReplayBase : public ISerializable
     CReplayHeader m_rhHeader;
     CMomentumReplayGhostEntity *m_pEntity;
     char m_pszRunHash[41];
+    char m_szHashFilePath[MAX_PATH];
+    char m_szHashPathID[32];
 };
@@ -7,9 +7,11 @@
 // HACK: To keep compatibility, store teleport flag in the buttons
 // Remember to update me if more button flags are added!!!
 #define IN_REPLAY_TELEPORTED            (1 << 27)
+// Set when the player ended the tick on the ground. Replays recorded before this was added never have it.
+#define IN_REPLAY_ONGROUND              (1 << 28)
 
-// A single frame of the replay.
-class CReplayFrame : public ISerializable
+// A single frame of the replay. Plain data without a vtable, so frames pack into 32 bytes and can be scanned in bulk.
+class CReplayFrame
 {
   public:
     CReplayFrame()
@@ -40,7 +42,7 @@ class CReplayFrame : public ISerializable
     }
 
   public:
-    virtual void Serialize(CUtlBuffer &writer) OVERRIDE
+    void Serialize(CUtlBuffer &writer) const
     {
         writer.PutFloat(m_angEyeAngles.x);
         writer.PutFloat(m_angEyeAngles.y);
@@ -61,6 +63,7 @@ class CReplayFrame : public ISerializable
     inline float PlayerViewOffset() const { return m_fPlayerViewOffset; }
     inline int PlayerButtons() const { return m_iPlayerButtons; }
     inline bool Teleported() const { return (m_iPlayerButtons & IN_REPLAY_TELEPORTED) ? true : false; }
+    inline bool OnGround() const { return (m_iPlayerButtons & IN_REPLAY_ONGROUND) ? true : false; }
 
   private:
     QAngle m_angEyeAngles;
@@ -69,6 +72,8 @@ class CReplayFrame : public ISerializable
     int m_iPlayerButtons;
 };
 
+COMPILE_TIME_ASSERT(sizeof(CReplayFrame) == 32);
+
 class CReplayHeader : public ISerializable
 {
   public:
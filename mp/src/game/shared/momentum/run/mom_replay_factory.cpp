@@ -24,9 +24,11 @@ CMomReplayBase *CMomReplayFactory::CreateEmptyReplay(uint8 version)
     //Is there a more compact way to do this without introducing more intermediate objects?
     switch(version)
     {
-        case 0: //Place 0 before the newest version's case, without a `break;`
         case 1:
             return new CMomReplayV1();
+        case 0: //Place 0 before the newest version's case, without a `break;`
+        case 2:
+            return new CMomReplayV2();
             
         default:
             Log("Invalid replay version: %d\n", version);
@@ -38,9 +40,11 @@ CMomReplayBase *CMomReplayFactory::CreateReplay(uint8 version, CUtlBuffer &reade
 {
     switch(version)
     {
-        case 0:
         case 1:
             return new CMomReplayV1(reader, bFullLoad);
+        case 0:
+        case 2:
+            return new CMomReplayV2(reader, bFullLoad);
         
         default:
             Log("Invalid replay version: %d\n", version);
@@ -61,6 +65,31 @@ CMomReplayBase* CMomReplayFactory::LoadReplayFile(const char* pFileName, bool bF
     if (bLogReplay)
         Log("Loading a replay from '%s'...\n", pFileName);
 
+    if (!bFullLoad)
+    {
+        CUtlBuffer reader;
+        if (!ReadReplayHeader(pFileName, pPathID, reader))
+        {
+            Log("Replay file not found: %s\n", pFileName);
+            return nullptr;
+        }
+
+        CMomReplayBase *toReturn = ParseReplay(pFileName, reader, false, bLogReplay);
+        if (!toReturn)
+            return nullptr;
+
+        if (reader.IsValid())
+        {
+            toReturn->SetRunHashSource(pFileName, pPathID);
+            return toReturn;
+        }
+
+        // The header didn't fit into what we read, fall back to reading the whole file
+        delete toReturn;
+        if (bLogReplay)
+            Log("Replay header of '%s' is larger than expected, reading the entire file...\n", pFileName);
+    }
+
     CUtlBuffer reader;
     bool bFile = filesystem->ReadFile(pFileName, pPathID, reader);
 
@@ -70,6 +99,38 @@ CMomReplayBase* CMomReplayFactory::LoadReplayFile(const char* pFileName, bool bF
         return nullptr;
     }
 
+    CMomReplayBase *toReturn = ParseReplay(pFileName, reader, bFullLoad, bLogReplay);
+    if (!toReturn)
+        return nullptr;
+
+    // We have the whole file already, might as well hash it now
+    char hash[41];
+    if (MomUtil::GetSHA1Hash(reader, hash, sizeof(hash)))
+        toReturn->SetRunHash(hash);
+
+    return toReturn;
+}
+
+bool CMomReplayFactory::ReadReplayHeader(const char *pFileName, const char *pPathID, CUtlBuffer &into)
+{
+    FileHandle_t file = filesystem->Open(pFileName, "rb", pPathID);
+    if (!file)
+        return false;
+
+    const int size = min(filesystem->Size(file), static_cast<unsigned int>(REPLAY_HEADER_READ_SIZE));
+    into.EnsureCapacity(size);
+    const int read = filesystem->Read(into.PeekPut(), size, file);
+    filesystem->Close(file);
+
+    if (read <= 0)
+        return false;
+
+    into.SeekPut(CUtlBuffer::SEEK_HEAD, read);
+    return true;
+}
+
+CMomReplayBase *CMomReplayFactory::ParseReplay(const char *pFileName, CUtlBuffer &reader, bool bFullLoad, bool bLogReplay)
+{
     uint32 magic = reader.GetUnsignedInt();
 
     if (magic != REPLAY_MAGIC_LE && magic != REPLAY_MAGIC_BE)
@@ -88,11 +149,8 @@ CMomReplayBase* CMomReplayFactory::LoadReplayFile(const char* pFileName, bool bF
 
     // MOM_TODO: Verify that replay parsing was successful.
     CMomReplayBase *toReturn = CreateReplay(version, reader, bFullLoad);
-    char hash[41];
-    if (MomUtil::GetSHA1Hash(reader, hash, sizeof(hash)))
-        toReturn->SetRunHash(hash);
 
-    if (bLogReplay)
+    if (toReturn && bLogReplay)
         Log("Successfully loaded replay.\n");
 
     return toReturn;
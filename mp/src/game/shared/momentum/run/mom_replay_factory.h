@@ -3,6 +3,9 @@
 #define REPLAY_MAGIC_LE 0x524D4F4D
 #define REPLAY_MAGIC_BE 0x4D4F4D52
 
+// Enough to hold the magic, version, header and the run stats of a replay with MAX_ZONES zones
+#define REPLAY_HEADER_READ_SIZE 4096
+
 class CMomReplayBase;
 
 class CMomReplayFactory
@@ -16,8 +19,15 @@ class CMomReplayFactory
     CMomReplayBase *CreateReplay(uint8 version, CUtlBuffer &reader, bool bFullLoad);
 
     // Returns a replay file and constructs a versioned replay object.
+    // If bFullLoad is false, only the header and run stats are read from the file, and the run hash
+    // is computed once GetRunHash() is called.
     CMomReplayBase *LoadReplayFile(const char *pFileName, bool bFullLoad = true, const char *pPathID = "MOD");
 
+  private:
+    // Reads only the start of a replay file, up to REPLAY_HEADER_READ_SIZE bytes
+    bool ReadReplayHeader(const char *pFileName, const char *pPathID, CUtlBuffer &into);
+    CMomReplayBase *ParseReplay(const char *pFileName, CUtlBuffer &reader, bool bFullLoad, bool bLogReplay);
+
     uint8 m_ucCurrentVersion;
 };
 
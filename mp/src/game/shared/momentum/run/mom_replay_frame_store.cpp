@@ -0,0 +1,109 @@
+#include "cbase.h"
+#include "mom_replay_frame_store.h"
+#include "mempool.h"
+
+#include "tier0/memdbgon.h"
+
+// Blocks are recycled between replays, so repeated runs don't keep hitting the heap.
+// Stores live in statics like the replay system that get destroyed in any order, so the pool is never destroyed.
+static CMemoryPoolMT &GetReplayFrameBlockPool()
+{
+    static CMemoryPoolMT *s_pPool = new CMemoryPoolMT(sizeof(CReplayFrame) * REPLAY_FRAMES_PER_STORE_BLOCK, 2,
+                                                      CUtlMemoryPool::GROW_SLOW, "CReplayFrameStore");
+    return *s_pPool;
+}
+
+CReplayFrameStore::CReplayFrameStore() : m_iHeadOffset(0), m_iCount(0) {}
+
+CReplayFrameStore::~CReplayFrameStore()
+{
+    Purge();
+}
+
+void CReplayFrameStore::AddBlock()
+{
+    m_vecBlocks.AddToTail(static_cast<CReplayFrame *>(GetReplayFrameBlockPool().Alloc()));
+}
+
+void CReplayFrameStore::AddToTail(const CReplayFrame &frame)
+{
+    const int abs = m_iHeadOffset + m_iCount;
+    if ((abs >> REPLAY_FRAME_BLOCK_SHIFT) >= m_vecBlocks.Count())
+        AddBlock();
+
+    CopyConstruct(&m_vecBlocks[abs >> REPLAY_FRAME_BLOCK_SHIFT][abs & REPLAY_FRAME_BLOCK_MASK], frame);
+    ++m_iCount;
+}
+
+void CReplayFrameStore::EnsureCapacity(int num)
+{
+    const int blocksNeeded = (m_iHeadOffset + num + REPLAY_FRAME_BLOCK_MASK) >> REPLAY_FRAME_BLOCK_SHIFT;
+    while (m_vecBlocks.Count() < blocksNeeded)
+        AddBlock();
+}
+
+void CReplayFrameStore::RemoveMultipleFromHead(int num)
+{
+    num = clamp(num, 0, m_iCount);
+
+    m_iHeadOffset += num;
+    m_iCount -= num;
+
+    // CReplayFrame is plain data, so whole blocks can go straight back to the pool
+    const int freeBlocks = m_iHeadOffset >> REPLAY_FRAME_BLOCK_SHIFT;
+    if (freeBlocks > 0)
+    {
+        for (int i = 0; i < freeBlocks; ++i)
+            GetReplayFrameBlockPool().Free(m_vecBlocks[i]);
+
+        m_vecBlocks.RemoveMultipleFromHead(freeBlocks);
+        m_iHeadOffset &= REPLAY_FRAME_BLOCK_MASK;
+    }
+}
+
+void CReplayFrameStore::Purge()
+{
+    FOR_EACH_VEC(m_vecBlocks, i)
+    {
+        GetReplayFrameBlockPool().Free(m_vecBlocks[i]);
+    }
+
+    m_vecBlocks.Purge();
+    m_iHeadOffset = 0;
+    m_iCount = 0;
+}
+
+void CReplayFrameColumns::Load(const CReplayFrameStore &frames, int iStart, int count)
+{
+    iStart = clamp(iStart, 0, frames.Count());
+    if (count < 0 || iStart + count > frames.Count())
+        count = frames.Count() - iStart;
+
+    m_vecOrigins.SetCount(count);
+    m_vecEyeAngles.SetCount(count);
+    m_vecViewOffsets.SetCount(count);
+    m_vecButtons.SetCount(count);
+
+    CReplayFrameSpan span;
+    for (int i = 0; i < count; i += span.Count())
+    {
+        span = frames.GetSpan(iStart + i);
+        const int spanCount = MIN(span.Count(), count - i);
+        for (int j = 0; j < spanCount; ++j)
+        {
+            const CReplayFrame &frame = span[j];
+            m_vecOrigins[i + j] = frame.PlayerOrigin();
+            m_vecEyeAngles[i + j] = frame.EyeAngles();
+            m_vecViewOffsets[i + j] = frame.PlayerViewOffset();
+            m_vecButtons[i + j] = frame.PlayerButtons();
+        }
+    }
+}
+
+void CReplayFrameColumns::Purge()
+{
+    m_vecOrigins.Purge();
+    m_vecEyeAngles.Purge();
+    m_vecViewOffsets.Purge();
+    m_vecButtons.Purge();
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "mom_replay_data.h"
+
+// Number of frames per block, must be a power of two. 4096 frames is about a minute at 66 tick.
+#define REPLAY_FRAME_BLOCK_SHIFT 12
+#define REPLAY_FRAMES_PER_STORE_BLOCK (1 << REPLAY_FRAME_BLOCK_SHIFT)
+#define REPLAY_FRAME_BLOCK_MASK (REPLAY_FRAMES_PER_STORE_BLOCK - 1)
+
+// A read-only view of consecutive frames that lie next to each other in memory
+class CReplayFrameSpan
+{
+  public:
+    CReplayFrameSpan() : m_pFrames(nullptr), m_iCount(0) {}
+    CReplayFrameSpan(const CReplayFrame *pFrames, int count) : m_pFrames(pFrames), m_iCount(count) {}
+
+    int Count() const { return m_iCount; }
+    bool IsEmpty() const { return m_iCount == 0; }
+
+    const CReplayFrame &operator[](int i) const
+    {
+        Assert(i >= 0 && i < m_iCount);
+        return m_pFrames[i];
+    }
+
+    const CReplayFrame *Base() const { return m_pFrames; }
+    const CReplayFrame *begin() const { return m_pFrames; }
+    const CReplayFrame *end() const { return m_pFrames + m_iCount; }
+
+  private:
+    const CReplayFrame *m_pFrames;
+    int m_iCount;
+};
+
+// Segmented storage for replay frames. Frames live in fixed-size blocks taken from a shared pool,
+// so recording never reallocates and copies the whole run, and trimming frames off the head
+// just moves an offset and returns whole blocks to the pool.
+class CReplayFrameStore
+{
+  public:
+    CReplayFrameStore();
+    ~CReplayFrameStore();
+
+    int Count() const { return m_iCount; }
+    bool IsEmpty() const { return m_iCount == 0; }
+
+    CReplayFrame &operator[](int i) { return Element(i); }
+    const CReplayFrame &operator[](int i) const { return Element(i); }
+
+    CReplayFrame &Element(int i)
+    {
+        Assert(i >= 0 && i < m_iCount);
+        const int abs = i + m_iHeadOffset;
+        return m_vecBlocks[abs >> REPLAY_FRAME_BLOCK_SHIFT][abs & REPLAY_FRAME_BLOCK_MASK];
+    }
+    const CReplayFrame &Element(int i) const
+    {
+        Assert(i >= 0 && i < m_iCount);
+        const int abs = i + m_iHeadOffset;
+        return m_vecBlocks[abs >> REPLAY_FRAME_BLOCK_SHIFT][abs & REPLAY_FRAME_BLOCK_MASK];
+    }
+
+    // The frames from the given one up to the end of its block (or of the replay), walk the whole replay with
+    // for (int i = 0; i < Count(); i += span.Count()) { span = GetSpan(i); ... }
+    CReplayFrameSpan GetSpan(int i) const
+    {
+        if (i < 0 || i >= m_iCount)
+            return CReplayFrameSpan();
+
+        const int abs = i + m_iHeadOffset;
+        const int blockLeft = REPLAY_FRAMES_PER_STORE_BLOCK - (abs & REPLAY_FRAME_BLOCK_MASK);
+        return CReplayFrameSpan(&m_vecBlocks[abs >> REPLAY_FRAME_BLOCK_SHIFT][abs & REPLAY_FRAME_BLOCK_MASK],
+                                MIN(blockLeft, m_iCount - i));
+    }
+
+    void AddToTail(const CReplayFrame &frame);
+
+    // Makes sure there are blocks for this many frames in total, so adding them won't allocate
+    void EnsureCapacity(int num);
+
+    // O(1) per removed block, no frames are moved
+    void RemoveMultipleFromHead(int num);
+
+    // Returns every block to the pool
+    void Purge();
+
+  private:
+    // The blocks belong to one store, copying it would free them twice
+    CReplayFrameStore(const CReplayFrameStore &);
+    CReplayFrameStore &operator=(const CReplayFrameStore &);
+
+    void AddBlock();
+
+    CUtlVector<CReplayFrame *> m_vecBlocks;
+    int m_iHeadOffset; // Frames trimmed off the first block
+    int m_iCount;
+};
+
+// Structure-of-arrays copy of (part of) a replay's frames, for analysis that only looks at a few of the components
+// and wants to run over them in tight, vectorizable loops
+class CReplayFrameColumns
+{
+  public:
+    // Copies count frames starting at iStart, or the rest of the replay if count is negative
+    void Load(const CReplayFrameStore &frames, int iStart = 0, int count = -1);
+    void Purge();
+
+    int Count() const { return m_vecOrigins.Count(); }
+
+    const Vector *Origins() const { return m_vecOrigins.Base(); }
+    const QAngle *EyeAngles() const { return m_vecEyeAngles.Base(); }
+    const float *ViewOffsets() const { return m_vecViewOffsets.Base(); }
+    const int *Buttons() const { return m_vecButtons.Base(); }
+
+  private:
+    CUtlVector<Vector> m_vecOrigins;
+    CUtlVector<QAngle> m_vecEyeAngles;
+    CUtlVector<float> m_vecViewOffsets;
+    CUtlVector<int> m_vecButtons;
+};
@@ -0,0 +1,243 @@
+#include "cbase.h"
+#include "mom_replay_index.h"
+#include "filesystem.h"
+#include "mom_replay_base.h"
+#include "mom_replay_factory.h"
+#include "mom_shareddefs.h"
+#include "run_stats.h"
+
+#include "tier0/memdbgon.h"
+
+ReplayIndexEntry_t::ReplayIndexEntry_t() : m_uFileSize(0), m_lFileTime(0), m_iVersion(0), m_pRunStats(nullptr)
+{
+    m_szRunHash[0] = '\0';
+}
+
+ReplayIndexEntry_t::~ReplayIndexEntry_t()
+{
+    if (m_pRunStats)
+        delete m_pRunStats;
+}
+
+CMomReplayBase *ReplayIndexEntry_t::CreateReplay() const
+{
+    CMomReplayBase *pReplay = g_ReplayFactory.CreateEmptyReplay(m_iVersion);
+    if (!pReplay)
+        return nullptr;
+
+    pReplay->SetHeader(m_Header);
+    pReplay->SetRunHash(m_szRunHash);
+
+    if (m_pRunStats)
+        pReplay->CreateRunStats(m_pRunStats->GetTotalZones())->FullyCopyFrom(*m_pRunStats);
+
+    return pReplay;
+}
+
+CMomReplayIndex::CMomReplayIndex()
+{
+    m_szMapName[0] = '\0';
+}
+
+CMomReplayIndex::~CMomReplayIndex()
+{
+    m_dictEntries.PurgeAndDeleteElements();
+}
+
+void CMomReplayIndex::Reset()
+{
+    m_dictEntries.PurgeAndDeleteElements();
+    m_szMapName[0] = '\0';
+}
+
+const CUtlDict<ReplayIndexEntry_t *> &CMomReplayIndex::GetMapReplays(const char *pMapName)
+{
+    if (!FStrEq(m_szMapName, pMapName))
+        LoadIndexFile(pMapName);
+
+    bool bChanged = false;
+    CUtlDict<ReplayIndexEntry_t *> dictCurrent;
+
+    char path[MAX_PATH];
+    Q_snprintf(path, MAX_PATH, "%s/%s-*%s", RECORDING_PATH, pMapName, EXT_RECORDING_FILE);
+    V_FixSlashes(path);
+
+    FileFindHandle_t found;
+    const char *pFoundFile = filesystem->FindFirstEx(path, "MOD", &found);
+    while (pFoundFile)
+    {
+        char pReplayPath[MAX_PATH];
+        V_ComposeFileName(RECORDING_PATH, pFoundFile, pReplayPath, MAX_PATH);
+
+        const uint32 uFileSize = filesystem->Size(pReplayPath, "MOD");
+        const long lFileTime = filesystem->GetFileTime(pReplayPath, "MOD");
+
+        ReplayIndexEntry_t *pEntry = nullptr;
+        const auto indx = m_dictEntries.Find(pFoundFile);
+        if (m_dictEntries.IsValidIndex(indx))
+        {
+            pEntry = m_dictEntries[indx];
+            m_dictEntries.RemoveAt(indx);
+
+            if (pEntry->m_uFileSize != uFileSize || pEntry->m_lFileTime != lFileTime)
+            {
+                delete pEntry;
+                pEntry = nullptr;
+            }
+        }
+
+        if (!pEntry)
+        {
+            pEntry = CreateEntry(pReplayPath, uFileSize, lFileTime);
+            bChanged = true;
+        }
+
+        if (pEntry)
+            dictCurrent.Insert(pFoundFile, pEntry);
+
+        pFoundFile = filesystem->FindNext(found);
+    }
+
+    filesystem->FindClose(found);
+
+    // Whatever is left over was deleted from disk
+    if (m_dictEntries.Count())
+    {
+        bChanged = true;
+        m_dictEntries.PurgeAndDeleteElements();
+    }
+
+    FOR_EACH_DICT_FAST(dictCurrent, i)
+    {
+        m_dictEntries.Insert(dictCurrent.GetElementName(i), dictCurrent[i]);
+    }
+
+    if (bChanged)
+        SaveIndexFile();
+
+    return m_dictEntries;
+}
+
+ReplayIndexEntry_t *CMomReplayIndex::CreateEntry(const char *pReplayPath, uint32 uFileSize, long lFileTime)
+{
+    CMomReplayBase *pReplay = g_ReplayFactory.LoadReplayFile(pReplayPath, false);
+    if (!pReplay)
+        return nullptr;
+
+    const auto pEntry = new ReplayIndexEntry_t;
+    pEntry->m_uFileSize = uFileSize;
+    pEntry->m_lFileTime = lFileTime;
+    pEntry->m_iVersion = pReplay->GetVersion();
+    pEntry->m_Header = pReplay->GetHeader();
+    // Local replays are stored as <map>-<hash>.mrf, so there's no need to hash the file again
+    char fileBase[MAX_PATH];
+    V_FileBase(pReplayPath, fileBase, MAX_PATH);
+    const char *pHashStart = Q_strrchr(fileBase, '-');
+    if (pHashStart && Q_strlen(pHashStart + 1) == sizeof(pEntry->m_szRunHash) - 1)
+        Q_strncpy(pEntry->m_szRunHash, pHashStart + 1, sizeof(pEntry->m_szRunHash));
+    else
+        Q_strncpy(pEntry->m_szRunHash, pReplay->GetRunHash(), sizeof(pEntry->m_szRunHash));
+
+    if (pReplay->GetRunStats())
+    {
+        pEntry->m_pRunStats = new CMomRunStats(pReplay->GetRunStats()->GetTotalZones());
+        pEntry->m_pRunStats->FullyCopyFrom(*pReplay->GetRunStats());
+    }
+
+    delete pReplay;
+    return pEntry;
+}
+
+// The client and the server each keep their own index file, so they never write the same file at once
+#ifdef CLIENT_DLL
+#define REPLAY_INDEX_FILE_SUFFIX "_client"
+#else
+#define REPLAY_INDEX_FILE_SUFFIX "_server"
+#endif
+
+void CMomReplayIndex::GetIndexFilePath(char *pOut, int outSize)
+{
+    Q_snprintf(pOut, outSize, "%s/%s%s%s", RECORDING_PATH, m_szMapName, REPLAY_INDEX_FILE_SUFFIX, EXT_RECORDING_INDEX_FILE);
+    V_FixSlashes(pOut);
+}
+
+void CMomReplayIndex::LoadIndexFile(const char *pMapName)
+{
+    m_dictEntries.PurgeAndDeleteElements();
+    Q_strncpy(m_szMapName, pMapName, sizeof(m_szMapName));
+
+    char path[MAX_PATH];
+    GetIndexFilePath(path, MAX_PATH);
+
+    CUtlBuffer reader;
+    if (!filesystem->ReadFile(path, "MOD", reader))
+        return;
+
+    if (reader.GetUnsignedInt() != REPLAY_INDEX_MAGIC || reader.GetUnsignedChar() != REPLAY_INDEX_VERSION)
+    {
+        DevWarning("Replay index %s is outdated, rebuilding it...\n", path);
+        return;
+    }
+
+    const int count = reader.GetInt();
+    for (int i = 0; i < count && reader.IsValid(); ++i)
+    {
+        char fileName[MAX_PATH];
+        reader.GetString(fileName);
+
+        const auto pEntry = new ReplayIndexEntry_t;
+        pEntry->m_uFileSize = reader.GetUnsignedInt();
+        pEntry->m_lFileTime = static_cast<long>(reader.GetInt64());
+        pEntry->m_iVersion = reader.GetUnsignedChar();
+        pEntry->m_Header = CReplayHeader(reader);
+        if (reader.GetUnsignedChar())
+            pEntry->m_pRunStats = new CMomRunStats(reader);
+        reader.GetString(pEntry->m_szRunHash);
+
+        m_dictEntries.Insert(fileName, pEntry);
+    }
+
+    if (!reader.IsValid())
+    {
+        Warning("Replay index %s is corrupt, rebuilding it...\n", path);
+        m_dictEntries.PurgeAndDeleteElements();
+    }
+}
+
+void CMomReplayIndex::SaveIndexFile()
+{
+    char path[MAX_PATH];
+    GetIndexFilePath(path, MAX_PATH);
+
+    if (m_dictEntries.Count() == 0)
+    {
+        if (filesystem->FileExists(path, "MOD"))
+            filesystem->RemoveFile(path, "MOD");
+        return;
+    }
+
+    CUtlBuffer writer;
+    writer.PutUnsignedInt(REPLAY_INDEX_MAGIC);
+    writer.PutUnsignedChar(REPLAY_INDEX_VERSION);
+    writer.PutInt(m_dictEntries.Count());
+
+    FOR_EACH_DICT_FAST(m_dictEntries, i)
+    {
+        const auto pEntry = m_dictEntries[i];
+
+        writer.PutString(m_dictEntries.GetElementName(i));
+        writer.PutUnsignedInt(pEntry->m_uFileSize);
+        writer.PutInt64(pEntry->m_lFileTime);
+        writer.PutUnsignedChar(pEntry->m_iVersion);
+        pEntry->m_Header.Serialize(writer);
+        writer.PutUnsignedChar(pEntry->m_pRunStats != nullptr);
+        if (pEntry->m_pRunStats)
+            pEntry->m_pRunStats->Serialize(writer);
+        writer.PutString(pEntry->m_szRunHash);
+    }
+
+    if (!filesystem->WriteFile(path, "MOD", writer))
+        Warning("Failed to write replay index %s!\n", path);
+}
+
+CMomReplayIndex g_ReplayIndex;
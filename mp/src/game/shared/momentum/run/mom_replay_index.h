@@ -0,0 +1,57 @@
+#pragma once
+
+#include "mom_replay_data.h"
+#include "run_stats.h"
+#include "utldict.h"
+
+class CMomReplayBase;
+
+#define REPLAY_INDEX_MAGIC 0x58524D4D // "MMRX"
+#define REPLAY_INDEX_VERSION 1
+
+// The cached header, stats and hash of a single replay file on disk
+struct ReplayIndexEntry_t
+{
+    ReplayIndexEntry_t();
+    ~ReplayIndexEntry_t();
+
+    // Creates a header-only replay from this entry, without touching the replay file.
+    //!!! NOTE: The value returned here MUST BE DELETED, otherwise you get a memory leak!
+    CMomReplayBase *CreateReplay() const;
+
+    float GetRunTime() const { return m_Header.m_fTickInterval * float(m_Header.m_iStopTick - m_Header.m_iStartTick); }
+
+    uint32 m_uFileSize;      // Size of the replay file when it was indexed
+    long m_lFileTime;        // Modification time of the replay file when it was indexed
+    uint8 m_iVersion;        // The replay version of the file
+    CReplayHeader m_Header;
+    CMomRunStats *m_pRunStats;
+    char m_szRunHash[41];
+};
+
+// Keeps a per-map index of the local replays (replays/<map>_client.mri, or _server.mri for the server's own)
+// so that leaderboards and PB lookups don't have to read every replay file. Entries are invalidated by the replay's file size and modification time.
+class CMomReplayIndex
+{
+  public:
+    CMomReplayIndex();
+    ~CMomReplayIndex();
+
+    // Brings the index of the given map up to date with the replays on disk, only reading the replays
+    // which are new or changed since they were indexed. Entries are keyed by their file name (relative to RECORDING_PATH).
+    const CUtlDict<ReplayIndexEntry_t *> &GetMapReplays(const char *pMapName);
+
+    // Drops the in-memory index, the next lookup will go through the index file again
+    void Reset();
+
+  private:
+    void LoadIndexFile(const char *pMapName);
+    void SaveIndexFile();
+    ReplayIndexEntry_t *CreateEntry(const char *pReplayPath, uint32 uFileSize, long lFileTime);
+    void GetIndexFilePath(char *pOut, int outSize);
+
+    char m_szMapName[MAX_MAP_NAME];
+    CUtlDict<ReplayIndexEntry_t *> m_dictEntries;
+};
+
+extern CMomReplayIndex g_ReplayIndex;
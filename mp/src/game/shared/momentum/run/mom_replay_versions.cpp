@@ -1,13 +1,33 @@
 #include "cbase.h"
 #include "mom_replay_versions.h"
+#include "util/mom_util.h"
 
 #ifdef GAME_DLL
 #include "momentum/mom_replay_entity.h"
 #include "momentum/mom_timer.h"
 #endif
 
+#include "tier0/valve_minmax_off.h"
+// snappy undefines min and max, so it needs to be wrapped
+#include "tier1/snappy.h"
+#include "tier0/valve_minmax_on.h"
+
 #include "tier0/memdbgon.h"
 
+const char *CMomReplayBase::GetRunHash()
+{
+    if (!m_pszRunHash[0] && m_szHashFilePath[0])
+    {
+        if (!MomUtil::GetFileHash(m_pszRunHash, sizeof(m_pszRunHash), m_szHashFilePath, m_szHashPathID))
+            m_pszRunHash[0] = '\0';
+
+        // Only ever try once
+        m_szHashFilePath[0] = '\0';
+    }
+
+    return m_pszRunHash;
+}
+
 CMomReplayV1::CMomReplayV1(CUtlBuffer &reader, bool bFull)
     : CMomReplayBase(CReplayHeader(reader), bFull), m_pRunStats(nullptr)
 {
@@ -16,6 +36,8 @@ CMomReplayV1::CMomReplayV1(CUtlBuffer &reader, bool bFull)
 
 CMomReplayV1::CMomReplayV1() : CMomReplayBase(CReplayHeader(), true), m_pRunStats(nullptr) {}
 
+CMomReplayV1::CMomReplayV1(const CReplayHeader &header) : CMomReplayBase(header, true), m_pRunStats(nullptr) {}
+
 CMomReplayV1::~CMomReplayV1()
 {
     if (m_pRunStats)
@@ -65,27 +87,42 @@ void CMomReplayV1::Serialize(CUtlBuffer &writer)
     // Write the header.
     m_rhHeader.Serialize(writer);
 
+    SerializeRunStats(writer);
+
+    // Write the frames.
+    writer.PutInt(m_rgFrames.Count());
+
+    CReplayFrameSpan span;
+    for (int32 i = 0; i < m_rgFrames.Count(); i += span.Count())
+    {
+        span = m_rgFrames.GetSpan(i);
+        for (const CReplayFrame &frame : span)
+            frame.Serialize(writer);
+    }
+}
+
+void CMomReplayV1::SerializeRunStats(CUtlBuffer &writer)
+{
     // Write the run stats (if there are any).
     writer.PutUnsignedChar(m_pRunStats != nullptr);
 
     if (m_pRunStats != nullptr)
         m_pRunStats->Serialize(writer);
-
-    // Write the frames.
-    writer.PutInt(m_rgFrames.Count());
-
-    for (int32 i = 0; i < m_rgFrames.Count(); ++i)
-        m_rgFrames[i].Serialize(writer);
 }
 
-// bFull is defined by a replay being played back vs. a replay being loaded for comparisons
-void CMomReplayV1::Deserialize(CUtlBuffer &reader, bool bFull)
+void CMomReplayV1::DeserializeRunStats(CUtlBuffer &reader)
 {
     // Read the run stats (if there are any).
     if (reader.GetUnsignedChar())
     {
         m_pRunStats = new CMomRunStats(reader);
     }
+}
+
+// bFull is defined by a replay being played back vs. a replay being loaded for comparisons
+void CMomReplayV1::Deserialize(CUtlBuffer &reader, bool bFull)
+{
+    DeserializeRunStats(reader);
 
     if (bFull)
     {
@@ -96,8 +133,330 @@ void CMomReplayV1::Deserialize(CUtlBuffer &reader, bool bFull)
         if (frameCount <= 0)
             return;
 
+        m_rgFrames.EnsureCapacity(frameCount);
+
         // And read all the frames.
         for (int32 i = 0; i < frameCount; ++i)
             m_rgFrames.AddToTail(CReplayFrame(reader));
     }
+}
+
+// ------------------------------------------------------------------------------------------
+// V2: delta-encoded, block-compressed frames
+//
+// Frame block layout (before compression), stored column-by-column so that components that
+// rarely change (roll, view offset, buttons) turn into long runs of zero bytes:
+//   [origin x][origin y][origin z][eye x][eye y][eye z][view offset][buttons]
+// where every column holds one varint residual per frame of the block. The first frame of
+// every block is predicted from zero, so each block can be decoded on its own.
+// ------------------------------------------------------------------------------------------
+
+enum ReplayFrameComponent_t
+{
+    FRAME_COMPONENT_ORIGIN_X = 0,
+    FRAME_COMPONENT_ORIGIN_Y,
+    FRAME_COMPONENT_ORIGIN_Z,
+    FRAME_COMPONENT_EYE_X,
+    FRAME_COMPONENT_EYE_Y,
+    FRAME_COMPONENT_EYE_Z,
+    FRAME_COMPONENT_VIEW_OFFSET,
+    FRAME_COMPONENT_BUTTONS,
+
+    FRAME_COMPONENT_COUNT
+};
+
+enum ReplayFramePredictor_t
+{
+    FRAME_PREDICT_LINEAR = 0, // Predicts the same delta as last frame (smooth movement)
+    FRAME_PREDICT_DELTA,      // Predicts the same value as last frame
+    FRAME_PREDICT_XOR,        // Bitwise difference to last frame (bitfields)
+};
+
+static const ReplayFramePredictor_t s_FramePredictors[FRAME_COMPONENT_COUNT] = {
+    FRAME_PREDICT_LINEAR, FRAME_PREDICT_LINEAR, FRAME_PREDICT_LINEAR,
+    FRAME_PREDICT_DELTA, FRAME_PREDICT_DELTA, FRAME_PREDICT_DELTA,
+    FRAME_PREDICT_DELTA,
+    FRAME_PREDICT_XOR
+};
+
+union ReplayFloatBits_t
+{
+    float f;
+    uint32 u;
+};
+
+// Maps float bits onto unsigned ints which keep the same ordering as the floats,
+// so that nearby values (also across 0) give small integer deltas
+static inline uint32 FloatToOrderedBits(float flValue)
+{
+    ReplayFloatBits_t bits;
+    bits.f = flValue;
+    return (bits.u & 0x80000000) ? ~bits.u : (bits.u | 0x80000000);
+}
+
+static inline float OrderedBitsToFloat(uint32 uValue)
+{
+    ReplayFloatBits_t bits;
+    bits.u = (uValue & 0x80000000) ? (uValue & 0x7FFFFFFF) : ~uValue;
+    return bits.f;
+}
+
+static inline uint32 ZigZagEncode(int32 iValue) { return (static_cast<uint32>(iValue) << 1) ^ static_cast<uint32>(iValue >> 31); }
+static inline int32 ZigZagDecode(uint32 uValue) { return static_cast<int32>(uValue >> 1) ^ -static_cast<int32>(uValue & 1); }
+
+static inline void PutVarUInt(CUtlBuffer &writer, uint32 uValue)
+{
+    while (uValue >= 0x80)
+    {
+        writer.PutUnsignedChar(static_cast<uint8>(uValue | 0x80));
+        uValue >>= 7;
+    }
+    writer.PutUnsignedChar(static_cast<uint8>(uValue));
+}
+
+// The most bytes PutVarUInt writes for a value
+#define VARUINT_MAX_BYTES 5
+// The most snappy can inflate data by, its densest element is a 3 byte copy of 64 bytes
+#define SNAPPY_MAX_EXPANSION 22
+
+static inline bool GetVarUInt(const uint8 *&pCur, const uint8 *pEnd, uint32 &uOut)
+{
+    uOut = 0;
+    for (int shift = 0; shift < VARUINT_MAX_BYTES * 7 && pCur < pEnd; shift += 7)
+    {
+        const uint8 byte = *pCur++;
+        uOut |= static_cast<uint32>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static inline uint32 GetFrameComponent(const CReplayFrame &frame, int component)
+{
+    switch (component)
+    {
+    case FRAME_COMPONENT_ORIGIN_X:
+        return FloatToOrderedBits(frame.PlayerOrigin().x);
+    case FRAME_COMPONENT_ORIGIN_Y:
+        return FloatToOrderedBits(frame.PlayerOrigin().y);
+    case FRAME_COMPONENT_ORIGIN_Z:
+        return FloatToOrderedBits(frame.PlayerOrigin().z);
+    case FRAME_COMPONENT_EYE_X:
+        return FloatToOrderedBits(frame.EyeAngles().x);
+    case FRAME_COMPONENT_EYE_Y:
+        return FloatToOrderedBits(frame.EyeAngles().y);
+    case FRAME_COMPONENT_EYE_Z:
+        return FloatToOrderedBits(frame.EyeAngles().z);
+    case FRAME_COMPONENT_VIEW_OFFSET:
+        return FloatToOrderedBits(frame.PlayerViewOffset());
+    case FRAME_COMPONENT_BUTTONS:
+        return static_cast<uint32>(frame.PlayerButtons());
+    default:
+        return 0;
+    }
+}
+
+CMomReplayV2::CMomReplayV2() : CMomReplayV1() {}
+
+CMomReplayV2::CMomReplayV2(CUtlBuffer &reader, bool bFull) : CMomReplayV1(CReplayHeader(reader))
+{
+    Deserialize(reader, bFull);
+}
+
+void CMomReplayV2::Serialize(CUtlBuffer &writer)
+{
+    m_rhHeader.Serialize(writer);
+
+    SerializeRunStats(writer);
+
+    const int32 frameCount = m_rgFrames.Count();
+    writer.PutInt(frameCount);
+    writer.PutUnsignedShort(REPLAY_V2_FRAMES_PER_BLOCK);
+
+    CUtlBuffer rawBlock;
+    CUtlMemory<char> compressed;
+    for (int32 blockStart = 0; blockStart < frameCount; blockStart += REPLAY_V2_FRAMES_PER_BLOCK)
+    {
+        rawBlock.Clear();
+        EncodeFrameBlock(blockStart, MIN(REPLAY_V2_FRAMES_PER_BLOCK, frameCount - blockStart), rawBlock);
+
+        compressed.EnsureCapacity(snappy::MaxCompressedLength(rawBlock.TellPut()));
+        size_t compressedSize = 0;
+        snappy::RawCompress(static_cast<const char *>(rawBlock.Base()), rawBlock.TellPut(), compressed.Base(), &compressedSize);
+
+        writer.PutUnsignedInt(compressedSize);
+        writer.Put(compressed.Base(), compressedSize);
+    }
+}
+
+void CMomReplayV2::Deserialize(CUtlBuffer &reader, bool bFull)
+{
+    DeserializeRunStats(reader);
+
+    if (!bFull)
+        return;
+
+    const int32 frameCount = reader.GetInt();
+    const int framesPerBlock = reader.GetUnsignedShort();
+    if (!frameCount)
+        return;
+
+    if (frameCount < 0 || framesPerBlock <= 0)
+    {
+        Warning("Replay frame count %i in blocks of %i is invalid!\n", frameCount, framesPerBlock);
+        return;
+    }
+
+    // Every frame takes at least a byte per component before compression, and every block at least its size.
+    // Don't reserve frames that the rest of the file can't hold.
+    const int remaining = reader.GetBytesRemaining();
+    const int32 blockCount = frameCount / framesPerBlock + (frameCount % framesPerBlock != 0);
+    if (static_cast<int64>(frameCount) * FRAME_COMPONENT_COUNT > static_cast<int64>(remaining) * SNAPPY_MAX_EXPANSION ||
+        blockCount > remaining / static_cast<int>(sizeof(uint32)))
+    {
+        Warning("Replay frame count %i doesn't fit the file!\n", frameCount);
+        return;
+    }
+
+    m_rgFrames.EnsureCapacity(frameCount);
+
+    // Blocks are streamed through a single scratch buffer, so only one block is ever decompressed at once
+    CUtlMemory<char> rawBlock;
+    for (int32 blockStart = 0; blockStart < frameCount; blockStart += framesPerBlock)
+    {
+        const uint32 compressedSize = reader.GetUnsignedInt();
+        if (!reader.IsValid() || compressedSize > static_cast<uint32>(reader.GetBytesRemaining()))
+        {
+            Warning("Replay frame block at frame %i is truncated!\n", blockStart);
+            return;
+        }
+
+        // The length comes from the file, the frames of the block can't take up more than this
+        const int blockFrames = MIN(framesPerBlock, frameCount - blockStart);
+        const size_t minUncompressedSize = static_cast<size_t>(blockFrames) * FRAME_COMPONENT_COUNT;
+        const size_t maxUncompressedSize = minUncompressedSize * VARUINT_MAX_BYTES;
+
+        const char *pCompressed = static_cast<const char *>(reader.PeekGet());
+        size_t uncompressedSize = 0;
+        if (!snappy::GetUncompressedLength(pCompressed, compressedSize, &uncompressedSize) ||
+            uncompressedSize < minUncompressedSize || uncompressedSize > maxUncompressedSize)
+        {
+            Warning("Replay frame block at frame %i is corrupt!\n", blockStart);
+            return;
+        }
+
+        rawBlock.EnsureCapacity(uncompressedSize);
+        if (!snappy::RawUncompress(pCompressed, compressedSize, rawBlock.Base()))
+        {
+            Warning("Failed to decompress replay frame block at frame %i!\n", blockStart);
+            return;
+        }
+        reader.SeekGet(CUtlBuffer::SEEK_CURRENT, compressedSize);
+
+        if (!DecodeFrameBlock(reinterpret_cast<const uint8 *>(rawBlock.Base()), uncompressedSize, blockFrames))
+        {
+            Warning("Failed to decode replay frame block at frame %i!\n", blockStart);
+            return;
+        }
+    }
+}
+
+void CMomReplayV2::EncodeFrameBlock(int iStartFrame, int iFrameCount, CUtlBuffer &into)
+{
+    for (int component = 0; component < FRAME_COMPONENT_COUNT; ++component)
+    {
+        const ReplayFramePredictor_t predictor = s_FramePredictors[component];
+        uint32 uPrev = 0, uPrevDelta = 0;
+
+        for (int i = 0; i < iFrameCount; ++i)
+        {
+            const uint32 uValue = GetFrameComponent(m_rgFrames[iStartFrame + i], component);
+
+            switch (predictor)
+            {
+            case FRAME_PREDICT_LINEAR:
+                {
+                    const uint32 uDelta = uValue - uPrev;
+                    PutVarUInt(into, ZigZagEncode(static_cast<int32>(uDelta - uPrevDelta)));
+                    // The first frame is relative to 0, its "delta" says nothing about movement
+                    uPrevDelta = i ? uDelta : 0;
+                }
+                break;
+            case FRAME_PREDICT_DELTA:
+                PutVarUInt(into, ZigZagEncode(static_cast<int32>(uValue - uPrev)));
+                break;
+            case FRAME_PREDICT_XOR:
+                PutVarUInt(into, uValue ^ uPrev);
+                break;
+            }
+
+            uPrev = uValue;
+        }
+    }
+}
+
+bool CMomReplayV2::DecodeFrameBlock(const uint8 *pData, size_t dataSize, int iFrameCount)
+{
+    CUtlVector<uint32> values;
+    values.SetCount(iFrameCount * FRAME_COMPONENT_COUNT);
+
+    const uint8 *pCur = pData;
+    const uint8 *pEnd = pData + dataSize;
+
+    for (int component = 0; component < FRAME_COMPONENT_COUNT; ++component)
+    {
+        const ReplayFramePredictor_t predictor = s_FramePredictors[component];
+        uint32 *pColumn = values.Base() + component * iFrameCount;
+        uint32 uPrev = 0, uPrevDelta = 0;
+
+        for (int i = 0; i < iFrameCount; ++i)
+        {
+            uint32 uResidual;
+            if (!GetVarUInt(pCur, pEnd, uResidual))
+                return false;
+
+            uint32 uValue = 0;
+            switch (predictor)
+            {
+            case FRAME_PREDICT_LINEAR:
+                {
+                    const uint32 uDelta = static_cast<uint32>(ZigZagDecode(uResidual)) + uPrevDelta;
+                    uValue = uPrev + uDelta;
+                    uPrevDelta = i ? uDelta : 0;
+                }
+                break;
+            case FRAME_PREDICT_DELTA:
+                uValue = uPrev + static_cast<uint32>(ZigZagDecode(uResidual));
+                break;
+            case FRAME_PREDICT_XOR:
+                uValue = uPrev ^ uResidual;
+                break;
+            }
+
+            pColumn[i] = uValue;
+            uPrev = uValue;
+        }
+    }
+
+    // Bytes left over mean the block doesn't hold the frames it should
+    if (pCur != pEnd)
+        return false;
+
+    for (int i = 0; i < iFrameCount; ++i)
+    {
+        const Vector origin(OrderedBitsToFloat(values[FRAME_COMPONENT_ORIGIN_X * iFrameCount + i]),
+                            OrderedBitsToFloat(values[FRAME_COMPONENT_ORIGIN_Y * iFrameCount + i]),
+                            OrderedBitsToFloat(values[FRAME_COMPONENT_ORIGIN_Z * iFrameCount + i]));
+        const QAngle eyes(OrderedBitsToFloat(values[FRAME_COMPONENT_EYE_X * iFrameCount + i]),
+                          OrderedBitsToFloat(values[FRAME_COMPONENT_EYE_Y * iFrameCount + i]),
+                          OrderedBitsToFloat(values[FRAME_COMPONENT_EYE_Z * iFrameCount + i]));
+        const float viewOffset = OrderedBitsToFloat(values[FRAME_COMPONENT_VIEW_OFFSET * iFrameCount + i]);
+        const int buttons = static_cast<int>(values[FRAME_COMPONENT_BUTTONS * iFrameCount + i]);
+
+        // The teleport flag is already part of the stored buttons
+        m_rgFrames.AddToTail(CReplayFrame(eyes, origin, viewOffset, buttons, false));
+    }
+
+    return true;
 }
\ No newline at end of file
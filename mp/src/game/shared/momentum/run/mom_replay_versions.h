@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mom_replay_base.h"
+#include "mom_replay_frame_store.h"
 #include "run_stats.h"
 
 class CMomReplayV1 : public CMomReplayBase
@@ -15,6 +16,7 @@ public:
     virtual CMomRunStats* GetRunStats() OVERRIDE;
     virtual int32 GetFrameCount() OVERRIDE;
     virtual CReplayFrame* GetFrame(int32 index) OVERRIDE;
+    virtual const CReplayFrameStore &GetFrameStore() OVERRIDE { return m_rgFrames; }
     virtual void AddFrame(const CReplayFrame& frame) OVERRIDE;
     virtual bool SetFrame(int32 index, const CReplayFrame& frame) OVERRIDE;
     virtual CMomRunStats* CreateRunStats(uint8 stages) OVERRIDE;
@@ -23,10 +25,42 @@ public:
 public:
     virtual void Serialize(CUtlBuffer &writer) OVERRIDE;
 
+protected:
+    // Only reads the header, for later versions that deserialize their own way
+    CMomReplayV1(const CReplayHeader &header);
+
+    // Writes/reads the run stats block shared by all versions
+    void SerializeRunStats(CUtlBuffer &writer);
+    void DeserializeRunStats(CUtlBuffer &reader);
+
 private:
     void Deserialize(CUtlBuffer &reader, bool bFull = true);
 
 protected:
     CMomRunStats *m_pRunStats;
-    CUtlVector<CReplayFrame> m_rgFrames;
+    CReplayFrameStore m_rgFrames;
+};
+
+// Frames are split into blocks of this many frames, each block being compressed on its own
+#define REPLAY_V2_FRAMES_PER_BLOCK 1024
+
+// Same header and stats as V1, but the frames are delta-encoded per component and
+// compressed in blocks with snappy, which makes long runs a fraction of the size.
+class CMomReplayV2 : public CMomReplayV1
+{
+public:
+    CMomReplayV2();
+    CMomReplayV2(CUtlBuffer &reader, bool bFull);
+
+public:
+    virtual uint8 GetVersion() OVERRIDE { return 2; }
+
+public:
+    virtual void Serialize(CUtlBuffer &writer) OVERRIDE;
+
+private:
+    void Deserialize(CUtlBuffer &reader, bool bFull = true);
+
+    void EncodeFrameBlock(int iStartFrame, int iFrameCount, CUtlBuffer &into);
+    bool DecodeFrameBlock(const uint8 *pData, size_t dataSize, int iFrameCount);
 };
\ No newline at end of file
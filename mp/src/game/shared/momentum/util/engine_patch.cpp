@@ -16,6 +16,8 @@
 #define LALDIF(addr) ((uintptr_t)(addr) % getpagesize())
 #endif
 
+#include <emmintrin.h>
+
 #include "cbase.h"
 #include "util/os_utils.h"
 #include "engine_patch.h"
@@ -165,15 +167,121 @@ inline bool CEngineBinary::DataCompare(const char* data, const char* pattern, co
 //---------------------------------------------------------------------------------------------------------
 void* CEngineBinary::FindPattern(const char* pattern, const char* mask, size_t offset)
 {
-    auto maskLength = strlen(mask);
-    for (size_t i = 0; i <= m_iModuleSize - maskLength; ++i)
+    EngineSignature_t signature = { pattern, mask, offset, nullptr };
+    FindPatterns(&signature, 1);
+    return signature.m_pResult;
+}
+
+// Bytes that show up all over x86 code (padding, push ebp, mov) and make poor anchors for the scan
+static inline bool IsCommonCodeByte(unsigned char byte)
+{
+    return byte == 0x00 || byte == 0xFF || byte == 0xCC || byte == 0x90 || byte == 0x55 || byte == 0x8B || byte == 0x89;
+}
+
+struct SignatureScan_t
+{
+    EngineSignature_t *m_pSignature;
+    size_t m_iLength;
+    size_t m_iFirstAnchor, m_iLastAnchor;
+};
+
+//---------------------------------------------------------------------------------------------------------
+// Resolves several signatures in a single pass over the engine memory.
+// Each signature is reduced to two anchor bytes (a rare-ish byte and its last non-wildcard byte) which are
+// compared 16 positions at a time with SSE2; only positions where both anchors match get the full mask compare.
+//---------------------------------------------------------------------------------------------------------
+void CEngineBinary::FindPatterns(EngineSignature_t* pSignatures, int count)
+{
+    CUtlVector<SignatureScan_t> scans;
+    scans.EnsureCapacity(count);
+
+    const auto pModule = reinterpret_cast<const unsigned char*>(m_pModuleBase);
+    size_t maxLength = 0;
+
+    for (int i = 0; i < count; ++i)
     {
-        auto addr = reinterpret_cast<char*>(m_pModuleBase) + i;
-        if (DataCompare(addr, pattern, mask))
-            return reinterpret_cast<void*>(addr + offset);
+        EngineSignature_t* pSignature = &pSignatures[i];
+        pSignature->m_pResult = nullptr;
+
+        const size_t length = strlen(pSignature->m_pMask);
+        if (!pModule || length > m_iModuleSize)
+            continue;
+
+        size_t firstAnchor = length, lastAnchor = length;
+        for (size_t j = 0; j < length; ++j)
+        {
+            if (pSignature->m_pMask[j] != 'x')
+                continue;
+
+            lastAnchor = j;
+            if (firstAnchor == length || (IsCommonCodeByte(pSignature->m_pPattern[firstAnchor]) && !IsCommonCodeByte(pSignature->m_pPattern[j])))
+                firstAnchor = j;
+        }
+
+        // Nothing but wildcards, matches right away
+        if (firstAnchor == length)
+        {
+            pSignature->m_pResult = const_cast<unsigned char*>(pModule) + pSignature->m_iOffset;
+            continue;
+        }
+
+        SignatureScan_t& scan = scans[scans.AddToTail()];
+        scan.m_pSignature = pSignature;
+        scan.m_iLength = length;
+        scan.m_iFirstAnchor = firstAnchor;
+        scan.m_iLastAnchor = lastAnchor;
+
+        maxLength = MAX(maxLength, length);
+    }
+
+    if (scans.IsEmpty())
+        return;
+
+    // Vectorized part of the scan, every pattern is tested against the same 16 start positions so the module is
+    // only streamed through the cache once
+    size_t pos = 0;
+    for (; pos + 16 + maxLength <= m_iModuleSize + 1 && !scans.IsEmpty(); pos += 16)
+    {
+        FOR_EACH_VEC_BACK(scans, i)
+        {
+            const SignatureScan_t& scan = scans[i];
+            const char* pPattern = scan.m_pSignature->m_pPattern;
+
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pModule + pos + scan.m_iFirstAnchor));
+            const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pModule + pos + scan.m_iLastAnchor));
+            int candidates = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, _mm_set1_epi8(pPattern[scan.m_iFirstAnchor])),
+                                                             _mm_cmpeq_epi8(last, _mm_set1_epi8(pPattern[scan.m_iLastAnchor]))));
+
+            for (int bit = 0; candidates; ++bit, candidates >>= 1)
+            {
+                if (!(candidates & 1))
+                    continue;
+
+                const auto addr = reinterpret_cast<const char*>(pModule + pos + bit);
+                if (DataCompare(addr, pPattern, scan.m_pSignature->m_pMask))
+                {
+                    scan.m_pSignature->m_pResult = const_cast<char*>(addr) + scan.m_pSignature->m_iOffset;
+                    scans.FastRemove(i);
+                    break;
+                }
+            }
+        }
     }
 
-    return nullptr;
+    // Whatever is left near the end of the module
+    FOR_EACH_VEC(scans, i)
+    {
+        const SignatureScan_t& scan = scans[i];
+        for (size_t start = pos; start + scan.m_iLength <= m_iModuleSize; ++start)
+        {
+            const auto addr = reinterpret_cast<const char*>(pModule + start);
+            if (DataCompare(addr, scan.m_pSignature->m_pPattern, scan.m_pSignature->m_pMask))
+            {
+                scan.m_pSignature->m_pResult = const_cast<char*>(addr) + scan.m_pSignature->m_iOffset;
+                break;
+            }
+        }
+    }
 }
 
 bool CEngineBinary::SetMemoryProtection(void* pAddress, size_t iLength, int iProtection)
@@ -205,14 +313,31 @@ bool CEngineBinary::SetMemoryProtection(void* pAddress, size_t iLength, int iPro
 void CEngineBinary::ApplyAllPatches()
 {
 #if !defined (OSX) // No OSX patches
-    for (int i = 0; i < sizeof(g_EnginePatches) / sizeof(*g_EnginePatches); i++)
-        g_EnginePatches[i].ApplyPatch();
+    const int count = sizeof(g_EnginePatches) / sizeof(*g_EnginePatches);
+
+    // Look for every signature at once rather than scanning the whole engine once per patch
+    EngineSignature_t signatures[count];
+    for (int i = 0; i < count; i++)
+        g_EnginePatches[i].GetSignature(signatures[i]);
+
+    FindPatterns(signatures, count);
+
+    for (int i = 0; i < count; i++)
+        g_EnginePatches[i].ApplyPatch(signatures[i].m_pResult);
 #endif
 }
 
 CEngineBinary g_EngineBinary;
 
-void CEnginePatch::ApplyPatch()
+void CEnginePatch::GetSignature(EngineSignature_t& signature) const
+{
+    signature.m_pPattern = m_pSignature;
+    signature.m_pMask = m_pMask;
+    signature.m_iOffset = m_iOffset;
+    signature.m_pResult = nullptr;
+}
+
+void CEnginePatch::ApplyPatch(void* addr)
 {
     if (!m_pPatch)
     {
@@ -220,8 +345,6 @@ void CEnginePatch::ApplyPatch()
         return;
     }
 
-    void* addr = CEngineBinary::FindPattern(m_pSignature, m_pMask, m_iOffset);
-
     if (addr)
     {
         auto pMemory = m_bImmediate ? (uintptr_t*)addr : *reinterpret_cast<uintptr_t**>(addr);
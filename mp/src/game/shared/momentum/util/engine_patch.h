@@ -3,6 +3,16 @@
 //-----------------------------------------------------------------------------------
 #pragma once
 
+// A signature to search the engine for, see CEngineBinary::FindPatterns
+struct EngineSignature_t
+{
+    const char *m_pPattern;
+    const char *m_pMask;
+    size_t m_iOffset;
+
+    void *m_pResult; // Filled in by the search, nullptr if the signature wasn't found
+};
+
 class CEngineBinary : public CAutoGameSystem
 {
 public:
@@ -13,6 +23,7 @@ public:
 
     static inline bool DataCompare(const char*, const char*, const char*);
     static void* FindPattern(const char*, const char*, size_t = 0);
+    static void FindPatterns(EngineSignature_t*, int);
 
     static bool SetMemoryProtection(void*, size_t, int);
 
@@ -40,7 +51,8 @@ public:
     CEnginePatch(const char*, char*, char*, size_t, bool, float);
     CEnginePatch(const char*, char*, char*, size_t, bool, char*, size_t);
 
-    void ApplyPatch();
+    void GetSignature(EngineSignature_t&) const;
+    void ApplyPatch(void*);
 
 private:
     const char *m_sName;
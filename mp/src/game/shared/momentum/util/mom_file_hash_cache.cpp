@@ -0,0 +1,219 @@
+#include "cbase.h"
+
+#include "filesystem.h"
+#include "utlbuffer.h"
+#include "mom_file_hash_cache.h"
+
+#include "tier0/valve_minmax_off.h"
+// This is wrapped by minmax_off due to Valve making a macro for min and max...
+#include "cryptopp/sha.h"
+// Now we can unwrap
+#include "tier0/valve_minmax_on.h"
+
+#include "tier0/memdbgon.h"
+
+#ifdef CLIENT_DLL
+#define FILE_HASH_CACHE_FILE_NAME "file_hash_cache_client.dat"
+#else
+#define FILE_HASH_CACHE_FILE_NAME "file_hash_cache.dat"
+#endif
+
+CMomFileHashCache::CMomFileHashCache() : CAutoGameSystem("CMomFileHashCache"
+#ifdef CLIENT_DLL
+"_CLIENT"
+#endif
+), m_bDirty(false)
+{
+}
+
+void CMomFileHashCache::PostInit()
+{
+    LoadCacheFile();
+}
+
+void CMomFileHashCache::LevelShutdownPostEntity()
+{
+    SaveCacheFile();
+}
+
+void CMomFileHashCache::Shutdown()
+{
+    SaveCacheFile();
+}
+
+bool CMomFileHashCache::GetFileHash(char *pOut, size_t outLen, const char *pFileName, const char *pPathID)
+{
+    char fullPath[MAX_PATH];
+    // Files that don't live loose on disk (e.g. inside a VPK) can't be keyed, just hash them directly
+    if (!g_pFullFileSystem->RelativePathToFullPath_safe(pFileName, pPathID, fullPath, FILTER_CULLPACK))
+        return HashFile(pOut, outLen, pFileName, pPathID);
+
+    const uint32 uFileSize = g_pFullFileSystem->Size(fullPath);
+    const long lFileTime = g_pFullFileSystem->GetFileTime(fullPath);
+
+    {
+        AUTO_LOCK(m_Mutex);
+        const auto indx = m_dictEntries.Find(fullPath);
+        if (m_dictEntries.IsValidIndex(indx))
+        {
+            const FileHashEntry_t &entry = m_dictEntries[indx];
+            if (entry.m_uFileSize == uFileSize && entry.m_lFileTime == lFileTime)
+            {
+                Q_strncpy(pOut, entry.m_szHash, outLen);
+                return true;
+            }
+        }
+    }
+
+    FileHashEntry_t entry;
+    entry.m_uFileSize = uFileSize;
+    entry.m_lFileTime = lFileTime;
+    if (!HashFile(entry.m_szHash, sizeof(entry.m_szHash), fullPath, nullptr))
+        return false;
+
+    Q_strncpy(pOut, entry.m_szHash, outLen);
+
+    AUTO_LOCK(m_Mutex);
+    const auto indx = m_dictEntries.Find(fullPath);
+    if (m_dictEntries.IsValidIndex(indx))
+        m_dictEntries[indx] = entry;
+    else
+        m_dictEntries.Insert(fullPath, entry);
+    m_bDirty = true;
+
+    return true;
+}
+
+void CMomFileHashCache::SetFileHash(const char *pFileName, const char *pPathID, const char *pHash)
+{
+    char fullPath[MAX_PATH];
+    if (!g_pFullFileSystem->RelativePathToFullPath_safe(pFileName, pPathID, fullPath, FILTER_CULLPACK))
+        return;
+
+    FileHashEntry_t entry;
+    entry.m_uFileSize = g_pFullFileSystem->Size(fullPath);
+    entry.m_lFileTime = g_pFullFileSystem->GetFileTime(fullPath);
+    Q_strncpy(entry.m_szHash, pHash, sizeof(entry.m_szHash));
+
+    AUTO_LOCK(m_Mutex);
+    const auto indx = m_dictEntries.Find(fullPath);
+    if (m_dictEntries.IsValidIndex(indx))
+        m_dictEntries[indx] = entry;
+    else
+        m_dictEntries.Insert(fullPath, entry);
+    m_bDirty = true;
+}
+
+bool CMomFileHashCache::HashFile(char *pOut, size_t outLen, const char *pFileName, const char *pPathID)
+{
+    FileHandle_t file = g_pFullFileSystem->Open(pFileName, "rb", pPathID);
+    if (!file)
+        return false;
+
+    CryptoPP::SHA1 hash;
+    CUtlMemory<byte> chunk(0, FILE_HASH_READ_CHUNK_SIZE);
+
+    uint32 remaining = g_pFullFileSystem->Size(file);
+    while (remaining > 0)
+    {
+        const int toRead = static_cast<int>(MIN(remaining, static_cast<uint32>(FILE_HASH_READ_CHUNK_SIZE)));
+        const int read = g_pFullFileSystem->Read(chunk.Base(), toRead, file);
+        if (read <= 0)
+            break;
+
+        hash.Update(chunk.Base(), read);
+        remaining -= read;
+    }
+
+    g_pFullFileSystem->Close(file);
+
+    if (remaining > 0)
+    {
+        Warning("Failed to read %s for hashing!\n", pFileName);
+        return false;
+    }
+
+    byte digest[CryptoPP::SHA1::DIGESTSIZE];
+    hash.Final(digest);
+    V_binarytohex(digest, sizeof(digest), pOut, outLen);
+    return true;
+}
+
+void CMomFileHashCache::LoadCacheFile()
+{
+    AUTO_LOCK(m_Mutex);
+    m_dictEntries.Purge();
+    m_bDirty = false;
+
+    CUtlBuffer reader;
+    if (!g_pFullFileSystem->ReadFile(FILE_HASH_CACHE_FILE_NAME, "MOD", reader))
+        return;
+
+    if (reader.GetUnsignedInt() != FILE_HASH_CACHE_MAGIC || reader.GetUnsignedChar() != FILE_HASH_CACHE_VERSION)
+    {
+        DevWarning("File hash cache is outdated, rebuilding it...\n");
+        return;
+    }
+
+    const int count = reader.GetInt();
+    for (int i = 0; i < count && reader.IsValid(); ++i)
+    {
+        char fullPath[MAX_PATH];
+        reader.GetString(fullPath);
+
+        FileHashEntry_t entry;
+        entry.m_uFileSize = reader.GetUnsignedInt();
+        entry.m_lFileTime = static_cast<long>(reader.GetInt64());
+        reader.GetString(entry.m_szHash);
+
+        m_dictEntries.Insert(fullPath, entry);
+    }
+
+    if (!reader.IsValid())
+    {
+        Warning("File hash cache is corrupt, rebuilding it...\n");
+        m_dictEntries.Purge();
+    }
+}
+
+void CMomFileHashCache::SaveCacheFile()
+{
+    AUTO_LOCK(m_Mutex);
+    if (!m_bDirty)
+        return;
+
+    CUtlBuffer writer;
+    writer.PutUnsignedInt(FILE_HASH_CACHE_MAGIC);
+    writer.PutUnsignedChar(FILE_HASH_CACHE_VERSION);
+    const int countPos = writer.TellPut();
+    writer.PutInt(0);
+
+    int count = 0;
+    FOR_EACH_DICT_FAST(m_dictEntries, i)
+    {
+        // Don't carry around files that have since been deleted
+        const char *pFullPath = m_dictEntries.GetElementName(i);
+        if (!g_pFullFileSystem->FileExists(pFullPath))
+            continue;
+
+        const FileHashEntry_t &entry = m_dictEntries[i];
+        writer.PutString(pFullPath);
+        writer.PutUnsignedInt(entry.m_uFileSize);
+        writer.PutInt64(entry.m_lFileTime);
+        writer.PutString(entry.m_szHash);
+        ++count;
+    }
+
+    const int endPos = writer.TellPut();
+    writer.SeekPut(CUtlBuffer::SEEK_HEAD, countPos);
+    writer.PutInt(count);
+    writer.SeekPut(CUtlBuffer::SEEK_HEAD, endPos);
+
+    if (g_pFullFileSystem->WriteFile(FILE_HASH_CACHE_FILE_NAME, "MOD", writer))
+        m_bDirty = false;
+    else
+        Warning("Failed to write the file hash cache!\n");
+}
+
+static CMomFileHashCache s_FileHashCache;
+CMomFileHashCache *g_pFileHashCache = &s_FileHashCache;
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "igamesystem.h"
+#include "utldict.h"
+
+#define FILE_HASH_CACHE_MAGIC 0x48464D4D // "MMFH"
+#define FILE_HASH_CACHE_VERSION 1
+
+// The size of the chunks files are read in when they have to be hashed
+#define FILE_HASH_READ_CHUNK_SIZE (256 * 1024)
+
+struct FileHashEntry_t
+{
+    uint32 m_uFileSize;
+    long m_lFileTime;
+    char m_szHash[41];
+};
+
+// Remembers the SHA1 hashes of files (maps, replays) keyed by their full path, invalidated by the file's size and
+// modification time, so the same files don't get read and hashed over and over again. The cache is persisted
+// between sessions. Files that do need hashing are streamed through the hash in chunks instead of being read whole.
+class CMomFileHashCache : public CAutoGameSystem
+{
+  public:
+    CMomFileHashCache();
+
+    void PostInit() OVERRIDE;
+    void LevelShutdownPostEntity() OVERRIDE;
+    void Shutdown() OVERRIDE;
+
+    // Gets the SHA1 hash of the file, either from the cache or by hashing it if it changed (or was never hashed)
+    bool GetFileHash(char *pOut, size_t outLen, const char *pFileName, const char *pPathID = "GAME");
+
+    // Records the hash of a file that was hashed elsewhere (e.g. while it was being downloaded), as the file is now
+    void SetFileHash(const char *pFileName, const char *pPathID, const char *pHash);
+
+    // Hashes the file by streaming it in chunks, without going through the cache
+    static bool HashFile(char *pOut, size_t outLen, const char *pFileName, const char *pPathID = "GAME");
+
+  private:
+    void LoadCacheFile();
+    void SaveCacheFile();
+
+    CThreadFastMutex m_Mutex;
+    CUtlDict<FileHashEntry_t> m_dictEntries;
+    bool m_bDirty;
+};
+
+extern CMomFileHashCache *g_pFileHashCache;
@@ -4,9 +4,11 @@
 #include "filesystem.h"
 #include "utlbuffer.h"
 #include "mom_util.h"
+#include "mom_file_hash_cache.h"
 #include "momentum/mom_shareddefs.h"
 #include "run/mom_replay_factory.h"
 #include "run/mom_replay_base.h"
+#include "run/mom_replay_index.h"
 #include "run/run_compare.h"
 #include "run/run_stats.h"
 #include "run/mom_run_entity.h"
@@ -340,11 +342,11 @@ void MomUtil::GetHexStringFromColor(const Color& color, char* pBuffer, int maxLe
     Q_snprintf(pBuffer, maxLen, "%08x", colorHex);
 }
 
-inline bool CheckReplayB(CMomReplayBase *pFastest, CMomReplayBase *pCheck, float tickrate, int trackNumber, uint32 flags)
+inline bool CheckReplayB(const ReplayIndexEntry_t *pFastest, const ReplayIndexEntry_t *pCheck, float tickrate, int trackNumber, uint32 flags)
 {
     if (pCheck)
     {
-        if (pCheck->GetRunFlags() == flags && pCheck->GetTrackNumber() == trackNumber && CloseEnough(tickrate, pCheck->GetTickInterval(), FLT_EPSILON))
+        if (pCheck->m_Header.m_iRunFlags == flags && pCheck->m_Header.m_iTrackNumber == trackNumber && CloseEnough(tickrate, pCheck->m_Header.m_fTickInterval, FLT_EPSILON))
         {
             if (pFastest)
             {
@@ -363,37 +365,18 @@ CMomReplayBase *MomUtil::GetBestTime(const char *szMapName, float tickrate, int
 {
     if (szMapName)
     {
-        char path[MAX_PATH];
-        Q_snprintf(path, MAX_PATH, "%s/%s-*%s", RECORDING_PATH, szMapName, EXT_RECORDING_FILE);
-        V_FixSlashes(path);
+        const ReplayIndexEntry_t *pFastest = nullptr;
 
-        CMomReplayBase *pFastest = nullptr;
-
-        FileFindHandle_t found;
-        const char *pFoundFile = filesystem->FindFirstEx(path, "MOD", &found);
-        while (pFoundFile)
+        const auto &replays = g_ReplayIndex.GetMapReplays(szMapName);
+        FOR_EACH_DICT_FAST(replays, i)
         {
-            // NOTE: THIS NEEDS TO BE MANUALLY CLEANED UP!
-            char pReplayPath[MAX_PATH];
-            V_ComposeFileName(RECORDING_PATH, pFoundFile, pReplayPath, MAX_PATH);
-
-            CMomReplayBase *pBase = g_ReplayFactory.LoadReplayFile(pReplayPath, false);
-            assert(pBase != nullptr);
-                
-            if (CheckReplayB(pFastest, pBase, tickrate, trackNumber, flags))
-            {
-                pFastest = pBase;
-            }
-            else // Not faster, get rid of it
+            if (CheckReplayB(pFastest, replays[i], tickrate, trackNumber, flags))
             {
-                delete pBase;
+                pFastest = replays[i];
             }
-
-            pFoundFile = filesystem->FindNext(found);
         }
 
-        filesystem->FindClose(found);
-        return pFastest;
+        return pFastest ? pFastest->CreateReplay() : nullptr;
     }
     return nullptr;
 }
@@ -447,11 +430,7 @@ bool MomUtil::GetSHA1Hash(const CUtlBuffer& buf, char* pOut, size_t outLen)
 
 bool MomUtil::GetFileHash(char* pOut, size_t outLen, const char *pFileName, const char *pPathID /* = "GAME"*/)
 {
-    CUtlBuffer fileBuffer;
-    if (g_pFullFileSystem->ReadFile(pFileName, pPathID, fileBuffer))
-        return GetSHA1Hash(fileBuffer, pOut, outLen);
-
-    return false;
+    return g_pFileHashCache->GetFileHash(pOut, outLen, pFileName, pPathID);
 }
 
 bool MomUtil::FileExists(const char* pFileName, const char* pFileHash, const char* pPathID /* = "GAME"*/)
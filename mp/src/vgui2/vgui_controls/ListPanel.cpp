@@ -2828,13 +2828,12 @@ void ListPanel::SetItemVisible(int itemID, bool state)
 	if (data->visible == state)
 		return;
 
-	m_bNeedsSort = true;
-
 	data->visible = state;
 	if (data->visible)
 	{
-		// add back to end of list
+		// add back to end of list, which needs a sort to put it in place
 		m_VisibleItems.AddToTail(itemID);
+		m_bNeedsSort = true;
 	}
 	else
 	{